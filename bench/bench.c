@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "iris.h"
+
+// Build from repository root with bench/build.bat, or with the same flags on other platforms:
+//   gcc -std=c11 -O2 -DNDEBUG src/iris*.c src/types/*.c bench/*.c -I./src/ -I./bench/ -o iris-bench -lpthread
+// Usage: iris-bench [-s scale] [-r runs] [-t tmp_dir] [case...], every case is run if none is given
+
+static const BenchCase bench_cases[] = {
+  { "load", "load 100 MB source through stdio and through mapping", bench_load },
+  { "read", "reader throughput on generated code and on string literals", bench_read },
+  { "utf8", "validation and counting of ASCII heavy code and of mixed text", bench_utf8 },
+  { "parallel", "reading 50 MB of code on 1, 2, 4 and 8 threads", bench_parallel },
+  { "vm", "tree walking against bytecode vm on arithmetic and call heavy scripts", bench_vm },
+  { "rest", "first and rest walk over lists and vectors of 10^4 to 10^6 items", bench_rest },
+  { "grow", "building lists of 10^5 to 10^7 items by push, reserve, extend and copy", bench_grow },
+  { "copy", "sharing copies against deep clones of strings, lists and quoted data", bench_copy },
+};
+
+#define N_BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+double bench_now(void) {
+  struct timespec time;
+  (void)timespec_get(&time, TIME_UTC);
+  return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+size_t bench_scaled(const BenchOptions* options, size_t size, size_t minimum) {
+  double result = (double)size * options->scale;
+  return (result < (double)minimum) ? minimum : (size_t)result;
+}
+
+void bench_check(const IrisObject obj) {
+  if (obj.kind == irisObjectKindError) {
+    object_print_repr(obj, true);
+    panic("benchmark case failed");
+  }
+}
+
+void bench_report(const char* label, double seconds, double amount, const char* unit) {
+  if (unit != NULL) {
+    (void)fprintf(stdout, "  %-40s %10.4fs %12.1f %s/s\n", label, seconds, amount / seconds, unit);
+  } else {
+    (void)fprintf(stdout, "  %-40s %10.4fs\n", label, seconds);
+  }
+  fflush(stdout);
+}
+
+// forms are picked in turn, %d receives form number, so that literals differ
+static const char* const source_templates[] = {
+  "(+ (+ 1 (- %d 2)) (+ (+ 3 4) 5))\n",
+  "(quote! (alpha \"short\" %d (beta -42 gamma) \"string literal that is too long to be stored inline\"))\n",
+  "; comment that is skipped by reader %d\n",
+  "(first (rest (quote! (%d 2 3 (nested list) \"\xc3\xbcnic\xc3\xb6" "de string\"))))\n",
+  "(- (+ %d 100) (+ 1 (+ 2 (+ 3 (+ 4 5)))))\n",
+};
+
+#define N_SOURCE_TEMPLATES (sizeof(source_templates) / sizeof(source_templates[0]))
+#define SOURCE_LINE_MAX 256U
+
+char* bench_source(size_t bytes, size_t* len) {
+  char* result = iris_alloc(bytes + SOURCE_LINE_MAX, char);
+  size_t pos = 0ULL;
+  for (int i = 0; pos < bytes; i++) {
+    int written = snprintf(result + pos, SOURCE_LINE_MAX, source_templates[(size_t)i % N_SOURCE_TEMPLATES], i);
+    if ((written < 0) || ((unsigned int)written >= SOURCE_LINE_MAX)) {
+      panic("benchmark source template doesn't fit");
+    }
+    pos += (size_t)written;
+  }
+  *len = pos;
+  return result;
+}
+
+char* bench_write_file(const BenchOptions* options, const char* name, const char* bytes, size_t len) {
+  size_t path_len = strlen(options->tmp_dir) + strlen(name) + 2U;
+  char* path = iris_alloc(path_len, char);
+  (void)snprintf(path, path_len, "%s/%s", options->tmp_dir, name);
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) { errno_panic(); }
+  if (fwrite(bytes, sizeof(char), len, file) != len) { ferror_panic(file); }
+  if (fclose(file) != 0) { errno_panic(); }
+  return path;
+}
+
+void bench_remove_file(char* path) {
+  (void)remove(path);
+  iris_free(path);
+}
+
+static const BenchCase* bench_find_case(const char* name) {
+  for (size_t i = 0ULL; i < N_BENCH_CASES; i++) {
+    if (strcmp(bench_cases[i].name, name) == 0) {
+      return &bench_cases[i];
+    }
+  }
+  return NULL;
+}
+
+static void bench_run_case(const BenchCase* bench, const BenchOptions* options) {
+  (void)fprintf(stdout, "%s: %s\n", bench->name, bench->description);
+  fflush(stdout);
+  bench->run(options);
+}
+
+static noreturn void bench_usage(void) {
+  (void)fputs("usage: iris-bench [-s scale] [-r runs] [-t tmp_dir] [case...]\ncases:\n", stderr);
+  for (size_t i = 0ULL; i < N_BENCH_CASES; i++) {
+    (void)fprintf(stderr, "  %-10s %s\n", bench_cases[i].name, bench_cases[i].description);
+  }
+  exit(1);
+}
+
+int main(int argc, const char* argv[]) {
+  BenchOptions options = { .scale = 1.0, .runs = 3U, .tmp_dir = "." };
+  int first_case = argc;
+  for (int i = 1; i < argc; i++) {
+    if ((argv[i][0] != '-') || (argv[i][1] == '\0')) {
+      first_case = i;
+      break;
+    }
+    if (i == (argc - 1)) {
+      bench_usage();
+    }
+    if (strcmp(argv[i], "-s") == 0) {
+      options.scale = atof(argv[++i]);
+      if (options.scale <= 0.0) { bench_usage(); }
+    } else if (strcmp(argv[i], "-r") == 0) {
+      int runs = atoi(argv[++i]);
+      if (runs <= 0) { bench_usage(); }
+      options.runs = (unsigned int)runs;
+    } else if (strcmp(argv[i], "-t") == 0) {
+      options.tmp_dir = argv[++i];
+    } else {
+      bench_usage();
+    }
+  }
+  for (int i = first_case; i < argc; i++) {
+    if (bench_find_case(argv[i]) == NULL) {
+      bench_usage();
+    }
+  }
+  iris_init();
+  if (first_case == argc) {
+    for (size_t i = 0ULL; i < N_BENCH_CASES; i++) {
+      bench_run_case(&bench_cases[i], &options);
+    }
+  } else {
+    for (int i = first_case; i < argc; i++) {
+      bench_run_case(bench_find_case(argv[i]), &options);
+    }
+  }
+  iris_deinit();
+  return 0;
+}
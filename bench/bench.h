@@ -0,0 +1,68 @@
+#ifndef IRIS_BENCH_H
+#define IRIS_BENCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "types/iris_types.h"
+
+// Benchmark driver that links against interpreter sources, every case measures one part of it in isolation
+// Inputs are generated on the fly, so runs are reproducible without any data files
+
+typedef struct {
+  double scale;        // multiplier of input sizes, 1.0 for sizes that cases are designed for
+  unsigned int runs;   // best of this many runs is reported
+  const char* tmp_dir; // where cases that need files write them, they're removed afterwards
+} BenchOptions;
+
+typedef struct {
+  const char* name;
+  const char* description;
+  void (*run)(const BenchOptions*);
+} BenchCase;
+
+/*
+  @brief  Monotonic enough wall clock time in seconds
+*/
+double bench_now(void);
+
+/*
+  @brief  Input size for case that is designed for given one, never less than minimum
+*/
+size_t bench_scaled(const BenchOptions*, size_t size, size_t minimum);
+
+/*
+  @brief  Stop benchmark if case got error instead of result, so that failures aren't measured
+*/
+void bench_check(const IrisObject);
+
+/*
+  @brief  Print measurement, amount is processed per second
+  @params unit - unit of amount, such as "MB" or "items", amount is ignored if it's NULL
+*/
+void bench_report(const char* label, double seconds, double amount, const char* unit);
+
+/*
+  @brief  Generated source of at least given size, mix of nested calls, quoted data and string literals
+          Every form is complete, so source could be split anywhere between lines
+  @warn   Returned buffer should be released with iris_free
+*/
+char* bench_source(size_t bytes, size_t* len);
+
+/*
+  @brief  Path of temporary file in tmp_dir, written with given bytes
+  @warn   Returned path should be released with bench_remove_file
+*/
+char* bench_write_file(const BenchOptions*, const char* name, const char* bytes, size_t len);
+void bench_remove_file(char* path);
+
+void bench_load(const BenchOptions*);
+void bench_read(const BenchOptions*);
+void bench_utf8(const BenchOptions*);
+void bench_parallel(const BenchOptions*);
+void bench_vm(const BenchOptions*);
+void bench_rest(const BenchOptions*);
+void bench_grow(const BenchOptions*);
+void bench_copy(const BenchOptions*);
+
+#endif
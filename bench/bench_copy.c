@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "iris.h"
+
+#define COPY_N_FORMS 20000U
+#define COPY_FORM_ITEMS 100U
+#define COPY_ITEMS_PER_RUN 10000000U // copies are repeated until clones go over this many items or bytes, so runs take similar time
+#define COPY_STRING_SIZE (1024U * 1024U)
+
+static const size_t copy_list_sizes[] = { 1000U, 10000U, 100000U };
+
+#define N_COPY_LIST_SIZES (sizeof(copy_list_sizes) / sizeof(copy_list_sizes[0]))
+
+/*
+  @brief  Copy object repeatedly either by sharing its box, as object_copy does, or by cloning it whole, as copies were made before
+*/
+static void copy_measure(const BenchOptions* options, const char* label, const IrisObject obj, size_t n_items, bool clone) {
+  size_t repeats = (bench_scaled(options, COPY_ITEMS_PER_RUN, 1U) / n_items) + 1U;
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    for (size_t i = 0ULL; i < repeats; i++) {
+      IrisObject copy = clone ? object_clone(obj) : object_copy(obj);
+      object_destroy(&copy);
+    }
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+  }
+  bench_report(label, best, (double)repeats, "copies");
+}
+
+/*
+  @brief  Forms that take rest of quoted list of strings and numbers, result of every form is as big as quoted data
+*/
+static IrisObject copy_script(const BenchOptions* options) {
+  static const char item[] = "\"constant string literal that isn't stored inline\" 42 ";
+  static const char head[] = "(rest (quote! (";
+  static const char tail[] = ")))\n";
+  size_t line_len = (sizeof(head) - 1U) + (COPY_FORM_ITEMS / 2U) * (sizeof(item) - 1U) + (sizeof(tail) - 1U);
+  size_t n_forms = bench_scaled(options, COPY_N_FORMS, 16U);
+  char* source = iris_alloc(n_forms * line_len, char);
+  char* pos = source;
+  for (size_t i = 0ULL; i < n_forms; i++) {
+    memcpy(pos, head, sizeof(head) - 1U);
+    pos += sizeof(head) - 1U;
+    for (size_t c = 0ULL; c < (COPY_FORM_ITEMS / 2U); c++) {
+      memcpy(pos, item, sizeof(item) - 1U);
+      pos += sizeof(item) - 1U;
+    }
+    memcpy(pos, tail, sizeof(tail) - 1U);
+    pos += sizeof(tail) - 1U;
+  }
+  IrisObject code = chars_read(source, (size_t)(pos - source));
+  iris_free(source);
+  bench_check(code);
+  IrisObject result = codelist_resolve_in_place(&code, *get_standard_scope_view());
+  bench_check(result);
+  return result;
+}
+
+static IrisObject copy_string(size_t len) {
+  char* bytes = iris_alloc(len, char);
+  for (size_t i = 0ULL; i < len; i++) {
+    bytes[i] = (char)('a' + (char)(i % 26U));
+  }
+  IrisString result = string_from_view(bytes, bytes + len);
+  iris_free(bytes);
+  return string_to_object(result);
+}
+
+/*
+  @brief  Evaluate forms of codelist, results could be cloned to see how much evaluation paid when copies were deep
+*/
+static void copy_eval(const BenchOptions* options, const char* label, const IrisList codelist, bool clone) {
+  IrisEvalStack* stack = eval_stack_new();
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    for (size_t i = 0ULL; i < codelist.len; i++) {
+      IrisObject result = eval_object(stack, codelist.items[i]);
+      bench_check(result);
+      if (clone) {
+        IrisObject copy = object_clone(result);
+        object_destroy(&copy);
+      }
+      object_destroy(&result);
+    }
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+  }
+  bench_report(label, best, (double)codelist.len, "forms");
+  eval_stack_destroy(&stack);
+}
+
+void bench_copy(const BenchOptions* options) {
+  size_t len = bench_scaled(options, COPY_STRING_SIZE, 64U);
+  IrisObject str_object = copy_string(len);
+  copy_measure(options, "object_copy, 1 MB string", str_object, len, false);
+  copy_measure(options, "object_clone, 1 MB string", str_object, len, true);
+  object_destroy(&str_object);
+
+  for (size_t i = 0ULL; i < N_COPY_LIST_SIZES; i++) {
+    size_t n_items = bench_scaled(options, copy_list_sizes[i], 16U);
+    IrisList items = list_new();
+    list_reserve(&items, n_items);
+    for (size_t item = 0ULL; item < n_items; item++) {
+      IrisString item_str = string_from_chars("list item that isn't stored inline");
+      list_push_string(&items, &item_str);
+    }
+    IrisObject list = list_to_object(items);
+    char label[64];
+    (void)snprintf(label, sizeof(label), "object_copy, list of %zu strings", n_items);
+    copy_measure(options, label, list, n_items, false);
+    (void)snprintf(label, sizeof(label), "object_clone, list of %zu strings", n_items);
+    copy_measure(options, label, list, n_items, true);
+    object_destroy(&list);
+  }
+
+  IrisObject code = copy_script(options);
+  copy_eval(options, "eval, rest of quoted 100 item lists", *code.list_variant, false);
+  copy_eval(options, "eval and clone of every result", *code.list_variant, true);
+  object_destroy(&code);
+}
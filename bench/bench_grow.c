@@ -0,0 +1,101 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "iris.h"
+
+#define GROW_FIXED_STEP 4U
+#define GROW_FIXED_MAX 1000000U // quadratic baseline isn't run past it
+
+static const size_t grow_sizes[] = { 100000U, 1000000U, 10000000U };
+
+#define N_GROW_SIZES (sizeof(grow_sizes) / sizeof(grow_sizes[0]))
+
+typedef enum {
+  growFixedStep,
+  growPush,
+  growReservePush,
+  growExtendArray,
+  growCopy,
+} GrowVariant;
+
+/*
+  @brief  Growth by fixed number of slots per resize, the way lists grew before, kept only for comparison
+*/
+static void grow_fixed_step(size_t n_items) {
+  IrisObject* items = NULL;
+  size_t cap = 0ULL;
+  for (size_t i = 0ULL; i < n_items; i++) {
+    if (i == cap) {
+      cap += GROW_FIXED_STEP;
+      items = iris_resize_kind(items, cap, IrisObject, irisObjectKindList);
+    }
+    items[i] = int_to_object((intmax_t)i);
+  }
+  iris_free(items);
+}
+
+static void grow_run(GrowVariant variant, size_t n_items, const IrisObject* array, const IrisList* source) {
+  IrisList list = list_new();
+  switch (variant) {
+    case growFixedStep:
+      grow_fixed_step(n_items);
+      return;
+    case growPush:
+      for (size_t i = 0ULL; i < n_items; i++) {
+        list_push_int(&list, (intmax_t)i);
+      }
+      break;
+    case growReservePush:
+      list_reserve(&list, n_items);
+      for (size_t i = 0ULL; i < n_items; i++) {
+        list_push_int(&list, (intmax_t)i);
+      }
+      break;
+    case growExtendArray:
+      // items are ints, so moving them out of array leaves it usable for the next run
+      list_extend_array(&list, (IrisObject*)array, n_items);
+      break;
+    case growCopy:
+      list = list_copy(*source);
+      break;
+  }
+  if (list_card(list) != n_items) {
+    panic("list should have every item");
+  }
+  list_destroy(&list);
+}
+
+static void grow_measure(const BenchOptions* options, const char* name, GrowVariant variant, size_t n_items, const IrisObject* array, const IrisList* source) {
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    grow_run(variant, n_items, array, source);
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+  }
+  char label[64];
+  (void)snprintf(label, sizeof(label), "%s, %zu items", name, n_items);
+  bench_report(label, best, (double)n_items, "items");
+}
+
+void bench_grow(const BenchOptions* options) {
+  for (size_t i = 0ULL; i < N_GROW_SIZES; i++) {
+    size_t n_items = bench_scaled(options, grow_sizes[i], 16U);
+    IrisObject* array = iris_alloc(n_items, IrisObject);
+    IrisList source = list_new();
+    list_reserve(&source, n_items);
+    for (size_t item = 0ULL; item < n_items; item++) {
+      array[item] = int_to_object((intmax_t)item);
+      list_push_int(&source, (intmax_t)item);
+    }
+    if (grow_sizes[i] <= GROW_FIXED_MAX) {
+      grow_measure(options, "push with fixed step of 4", growFixedStep, n_items, array, &source);
+    }
+    grow_measure(options, "push", growPush, n_items, array, &source);
+    grow_measure(options, "reserve and push", growReservePush, n_items, array, &source);
+    grow_measure(options, "extend from array", growExtendArray, n_items, array, &source);
+    grow_measure(options, "copy", growCopy, n_items, array, &source);
+    list_destroy(&source);
+    iris_free(array);
+  }
+}
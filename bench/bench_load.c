@@ -0,0 +1,101 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "iris.h"
+#include "iris_os.h"
+
+#define LOAD_SOURCE_SIZE (100ULL * 1024ULL * 1024ULL)
+#define LOAD_PAGE_SIZE 4096U
+
+/*
+  @brief  Touch every page of mapping, so that it's actually read and not only reserved
+*/
+static size_t load_touch(const IrisMappedFile* file) {
+  size_t result = 0ULL;
+  for (size_t i = 0ULL; i < file->len; i += LOAD_PAGE_SIZE) {
+    result += (unsigned char)file->data[i];
+  }
+  return result;
+}
+
+void bench_load(const BenchOptions* options) {
+  size_t len;
+  char* source = bench_source(bench_scaled(options, LOAD_SOURCE_SIZE, LOAD_PAGE_SIZE), &len);
+  char* path = bench_write_file(options, "iris-bench-load.iris", source, len);
+  iris_free(source);
+  double megabytes = (double)len / 1e6;
+
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) { errno_panic(); }
+    IrisString str = string_from_file(file);
+    (void)fclose(file);
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+    string_destroy(&str);
+  }
+  bench_report("string_from_file", best, megabytes, "MB");
+
+  best = 1e9;
+  volatile size_t checksum = 0ULL;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    IrisMappedFile file;
+    if (!os_file_map(path, &file)) { errno_panic(); }
+    checksum += load_touch(&file);
+    os_file_unmap(&file);
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+  }
+  bench_report("os_file_map, every page touched", best, megabytes, "MB");
+
+  // what eval_file did before and does now, literals are copied out of string or mapping, or borrowed from mapping
+  best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) { errno_panic(); }
+    IrisString str = string_from_file(file);
+    (void)fclose(file);
+    IrisObject code = string_read(str);
+    double elapsed = bench_now() - start;
+    bench_check(code);
+    best = (elapsed < best) ? elapsed : best;
+    object_destroy(&code);
+    string_destroy(&str);
+  }
+  bench_report("string_from_file + string_read", best, megabytes, "MB");
+
+  best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    IrisMappedFile file;
+    if (!os_file_map(path, &file)) { errno_panic(); }
+    IrisObject code = chars_read(file.data, file.len);
+    os_file_unmap(&file);
+    double elapsed = bench_now() - start;
+    bench_check(code);
+    best = (elapsed < best) ? elapsed : best;
+    object_destroy(&code);
+  }
+  bench_report("os_file_map + chars_read", best, megabytes, "MB");
+
+  best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    IrisMappedFile file;
+    if (!os_file_map(path, &file)) { errno_panic(); }
+    IrisStringSource* borrowed = string_source_from_file(&file);
+    IrisObject code = source_read(borrowed);
+    string_source_release(borrowed);
+    double elapsed = bench_now() - start;
+    bench_check(code);
+    best = (elapsed < best) ? elapsed : best;
+    object_destroy(&code);
+  }
+  bench_report("os_file_map + source_read", best, megabytes, "MB");
+
+  bench_remove_file(path);
+}
@@ -0,0 +1,30 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "iris.h"
+
+#define PARALLEL_SOURCE_SIZE (50ULL * 1024ULL * 1024ULL)
+
+static const unsigned int parallel_thread_counts[] = { 1U, 2U, 4U, 8U };
+
+#define N_PARALLEL_THREAD_COUNTS (sizeof(parallel_thread_counts) / sizeof(parallel_thread_counts[0]))
+
+void bench_parallel(const BenchOptions* options) {
+  size_t len;
+  char* source = bench_source(bench_scaled(options, PARALLEL_SOURCE_SIZE, 4096U), &len);
+  for (size_t i = 0ULL; i < N_PARALLEL_THREAD_COUNTS; i++) {
+    double best = 1e9;
+    for (unsigned int run = 0U; run < options->runs; run++) {
+      double start = bench_now();
+      IrisObject code = chars_read_parallel(source, len, parallel_thread_counts[i]);
+      double elapsed = bench_now() - start;
+      bench_check(code);
+      best = (elapsed < best) ? elapsed : best;
+      object_destroy(&code);
+    }
+    char label[64];
+    (void)snprintf(label, sizeof(label), "chars_read_parallel, %u threads", parallel_thread_counts[i]);
+    bench_report(label, best, (double)len / 1e6, "MB");
+  }
+  iris_free(source);
+}
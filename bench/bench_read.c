@@ -0,0 +1,50 @@
+#include "bench.h"
+#include "iris.h"
+
+#define READ_CODE_SIZE (50ULL * 1024ULL * 1024ULL)
+#define READ_LITERAL_SIZE (100ULL * 1024ULL * 1024ULL)
+#define READ_LITERAL_LEN 1000U
+
+/*
+  @brief  Source of long string literals, one per line, as in data files
+*/
+static char* read_literal_source(size_t bytes, size_t* len) {
+  size_t line_len = READ_LITERAL_LEN + 3U; // quotes and newline
+  size_t n_lines = (bytes + line_len - 1U) / line_len;
+  char* result = iris_alloc(n_lines * line_len, char);
+  for (size_t i = 0ULL; i < n_lines; i++) {
+    char* line = result + i * line_len;
+    line[0] = '"';
+    for (size_t c = 0ULL; c < READ_LITERAL_LEN; c++) {
+      line[c + 1U] = (char)('a' + (char)((i + c) % 26U));
+    }
+    line[READ_LITERAL_LEN + 1U] = '"';
+    line[READ_LITERAL_LEN + 2U] = '\n';
+  }
+  *len = n_lines * line_len;
+  return result;
+}
+
+static void read_measure(const BenchOptions* options, const char* label, const char* source, size_t len) {
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    IrisObject code = chars_read(source, len);
+    double elapsed = bench_now() - start;
+    bench_check(code);
+    best = (elapsed < best) ? elapsed : best;
+    object_destroy(&code);
+  }
+  bench_report(label, best, (double)len / 1e6, "MB");
+}
+
+void bench_read(const BenchOptions* options) {
+  size_t len;
+  char* source = bench_source(bench_scaled(options, READ_CODE_SIZE, 4096U), &len);
+  read_measure(options, "chars_read, 50 MB of code", source, len);
+  iris_free(source);
+
+  source = read_literal_source(bench_scaled(options, READ_LITERAL_SIZE, 4096U), &len);
+  read_measure(options, "chars_read, 100 MB of string literals", source, len);
+  iris_free(source);
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "iris.h"
+
+static const size_t rest_sizes[] = { 10000U, 100000U, 1000000U };
+
+#define N_REST_SIZES (sizeof(rest_sizes) / sizeof(rest_sizes[0]))
+
+/*
+  @brief  Sum items the way recursive script code does it, by calling first and rest builtins until sequence is empty
+*/
+static intmax_t rest_walk(const IrisFunc first, const IrisFunc rest, const IrisObject seq) {
+  intmax_t sum = 0;
+  IrisObject current = object_copy(seq);
+  while (true) {
+    IrisObject item = func_call(first, &current, 1ULL);
+    bench_check(item);
+    if (item.kind == irisObjectKindNone) {
+      break;
+    }
+    sum += item.int_variant;
+    IrisObject next = func_call(rest, &current, 1ULL);
+    bench_check(next);
+    object_destroy(&current);
+    current = next;
+  }
+  object_destroy(&current);
+  return sum;
+}
+
+static void rest_measure(const BenchOptions* options, const char* name, const IrisObject seq, size_t n_items) {
+  const IrisMap* scope = get_standard_scope_view();
+  const IrisFunc first = *map_get_view(*scope, symbol_to_object(symbol_from_chars("first")))->func_variant;
+  const IrisFunc rest = *map_get_view(*scope, symbol_to_object(symbol_from_chars("rest")))->func_variant;
+  double best = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    intmax_t sum = rest_walk(first, rest, seq);
+    double elapsed = bench_now() - start;
+    if (sum != (intmax_t)(n_items * (n_items + 1U) / 2U)) {
+      panic("walk didn't visit every item");
+    }
+    best = (elapsed < best) ? elapsed : best;
+  }
+  char label[64];
+  (void)snprintf(label, sizeof(label), "%s of %zu items", name, n_items);
+  bench_report(label, best, (double)n_items, "items");
+}
+
+void bench_rest(const BenchOptions* options) {
+  for (size_t i = 0ULL; i < N_REST_SIZES; i++) {
+    size_t n_items = bench_scaled(options, rest_sizes[i], 16U);
+    IrisList items = list_new();
+    list_reserve(&items, n_items);
+    for (size_t item = 1ULL; item <= n_items; item++) {
+      list_push_int(&items, (intmax_t)item);
+    }
+    IrisObject list = list_to_object(items);
+    IrisObject vec = vector_to_object(vector_from_list(*list.list_variant));
+    rest_measure(options, "first and rest, list", list, n_items);
+    rest_measure(options, "first and rest, vector", vec, n_items);
+    object_destroy(&vec);
+    object_destroy(&list);
+  }
+}
@@ -0,0 +1,74 @@
+#include "bench.h"
+#include "iris.h"
+#include "iris_utf8.h"
+
+#define UTF8_SOURCE_SIZE (100ULL * 1024ULL * 1024ULL)
+
+/*
+  @brief  Byte by byte walk over codepoint widths, the way sources were checked before vectorized validation
+*/
+static bool utf8_walk_widths(const char* bytes, size_t len) {
+  size_t i = 0ULL;
+  while (i < len) {
+    unsigned int width = utf8_codepoint_width(bytes[i]);
+    if ((width == 0U) || (width > (len - i))) {
+      return false;
+    }
+    for (unsigned int c = 1U; c < width; c++) {
+      if ((bytes[i + c] & 0b11000000) != 0b10000000) {
+        return false;
+      }
+    }
+    i += width;
+  }
+  return true;
+}
+
+/*
+  @brief  Text where every 8th character is two or three bytes wide
+*/
+static char* utf8_mixed_source(size_t bytes, size_t* len) {
+  static const char* const pieces[] = { "abcdefg", "\xc3\xbc", "hijklmn", "\xe2\x82\xac" };
+  char* result = iris_alloc(bytes + 8U, char);
+  size_t pos = 0ULL;
+  for (size_t i = 0ULL; pos < bytes; i++) {
+    for (const char* piece = pieces[i % 4U]; *piece != '\0'; piece++) {
+      result[pos++] = *piece;
+    }
+  }
+  *len = pos;
+  return result;
+}
+
+static void utf8_measure(const BenchOptions* options, const char* label, const char* bytes, size_t len, int variant) {
+  double best = 1e9;
+  volatile size_t sink = 0ULL;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    double start = bench_now();
+    switch (variant) {
+      case 0: sink += utf8_walk_widths(bytes, len); break;
+      case 1: sink += utf8_validate(bytes, len, NULL); break;
+      default: sink += utf8_count(bytes, len); break;
+    }
+    double elapsed = bench_now() - start;
+    best = (elapsed < best) ? elapsed : best;
+  }
+  bench_report(label, best, (double)len / 1e6, "MB");
+}
+
+void bench_utf8(const BenchOptions* options) {
+  size_t len;
+  char* source = bench_source(bench_scaled(options, UTF8_SOURCE_SIZE, 4096U), &len);
+  if (!utf8_validate(source, len, NULL)) { panic("benchmark source should be valid"); }
+  utf8_measure(options, "code, byte by byte widths", source, len, 0);
+  utf8_measure(options, "code, utf8_validate", source, len, 1);
+  utf8_measure(options, "code, utf8_count", source, len, 2);
+  iris_free(source);
+
+  source = utf8_mixed_source(bench_scaled(options, UTF8_SOURCE_SIZE, 4096U), &len);
+  if (!utf8_validate(source, len, NULL)) { panic("benchmark source should be valid"); }
+  utf8_measure(options, "mixed text, byte by byte widths", source, len, 0);
+  utf8_measure(options, "mixed text, utf8_validate", source, len, 1);
+  utf8_measure(options, "mixed text, utf8_count", source, len, 2);
+  iris_free(source);
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "iris.h"
+#include "iris_vm.h"
+#include "iris_jit.h"
+
+#define VM_N_FORMS 100000U
+#define VM_LINE_MAX 160U
+
+// every form makes a dozen of calls to + and -, arguments are kept positive, as builtins reject some negative sums
+static const char* const vm_arithmetic_templates[] = {
+  "(+ (- (+ %d 10) (+ 2 3)) (+ (- 10 4) (+ (+ 5 6) (- 8 7))))\n",
+  "(- (+ (+ (+ %d 1) (+ 2 3)) (+ 4 (+ 5 6))) (+ 1 (+ 2 (+ 3 4))))\n",
+};
+
+// calls of collection builtins, values that are passed between them are boxed
+static const char* const vm_call_templates[] = {
+  "(first (rest (rest (rest (quote! (%d 2 3 4 5))))))\n",
+  "(first (first (rest (quote! (1 (%d nested) 3)))))\n",
+  "(get (vec (quote! (1 2 %d))) 2)\n",
+  "(get (assoc (hash-map (quote! (a 1 b 2))) (quote! c) %d) (quote! c))\n",
+};
+
+/*
+  @brief  Read and resolve forms made of given templates, so that only evaluation is measured
+*/
+static IrisObject vm_script(const BenchOptions* options, const char* const* templates, size_t n_templates) {
+  size_t n_forms = bench_scaled(options, VM_N_FORMS, 16U);
+  char* source = iris_alloc(n_forms * VM_LINE_MAX, char);
+  size_t len = 0ULL;
+  for (size_t i = 0ULL; i < n_forms; i++) {
+    len += (size_t)snprintf(source + len, VM_LINE_MAX, templates[i % n_templates], (int)(i & 0xffffU));
+  }
+  IrisObject code = chars_read(source, len);
+  iris_free(source);
+  bench_check(code);
+  IrisObject result = codelist_resolve_in_place(&code, *get_standard_scope_view());
+  bench_check(result);
+  return result;
+}
+
+/*
+  @brief  Stop benchmark if vm, or native code in builds with IRIS_USE_TCC, disagrees with tree walking
+*/
+static void vm_verify(IrisEvalStack* stack, IrisVm* vm, const IrisList codelist) {
+  for (size_t i = 0ULL; i < codelist.len; i++) {
+    IrisObject expected = eval_object(stack, codelist.items[i]);
+    IrisObject result = vm_eval_object(vm, codelist.items[i]);
+    if (!object_equal(expected, result)) {
+      object_print_repr(codelist.items[i], true);
+      panic("vm result differs from tree walking");
+    }
+    object_destroy(&expected);
+    object_destroy(&result);
+  }
+}
+
+static void vm_measure(const BenchOptions* options, const char* name, const IrisList codelist) {
+  IrisEvalStack* stack = eval_stack_new();
+  IrisVm* vm = vm_new();
+  vm_verify(stack, vm, codelist);
+  double best_tree = 1e9;
+  double best_vm = 1e9;
+  for (unsigned int run = 0U; run < options->runs; run++) {
+    // forms are evaluated one at a time, as eval_file does it, so vm compiles every one before running it
+    double start = bench_now();
+    for (size_t i = 0ULL; i < codelist.len; i++) {
+      IrisObject result = eval_object(stack, codelist.items[i]);
+      bench_check(result);
+      object_destroy(&result);
+    }
+    double elapsed = bench_now() - start;
+    best_tree = (elapsed < best_tree) ? elapsed : best_tree;
+
+    start = bench_now();
+    for (size_t i = 0ULL; i < codelist.len; i++) {
+      IrisObject result = vm_eval_object(vm, codelist.items[i]);
+      bench_check(result);
+      object_destroy(&result);
+    }
+    elapsed = bench_now() - start;
+    best_vm = (elapsed < best_vm) ? elapsed : best_vm;
+  }
+  char label[64];
+  (void)snprintf(label, sizeof(label), "%s, tree walking", name);
+  bench_report(label, best_tree, (double)codelist.len, "forms");
+  (void)snprintf(label, sizeof(label), "%s, vm compile and run", name);
+  bench_report(label, best_vm, (double)codelist.len, "forms");
+  vm_destroy(&vm);
+  eval_stack_destroy(&stack);
+}
+
+void bench_vm(const BenchOptions* options) {
+  IrisObject code = vm_script(options, vm_arithmetic_templates, sizeof(vm_arithmetic_templates) / sizeof(vm_arithmetic_templates[0]));
+  vm_measure(options, "arithmetic", *code.list_variant);
+  object_destroy(&code);
+
+  code = vm_script(options, vm_call_templates, sizeof(vm_call_templates) / sizeof(vm_call_templates[0]));
+  vm_measure(options, "calls", *code.list_variant);
+  object_destroy(&code);
+
+  #ifdef IRIS_USE_TCC
+  // forms of scripts repeat few shapes, so every one of them should be compiled natively
+  IrisJitMetrics metrics;
+  jit_metrics_snapshot(&metrics);
+  (void)fprintf(stdout, "  jit compiles: %llu, failures: %llu, hits: %llu of %llu lookups\n",
+    (unsigned long long)metrics.compiles, (unsigned long long)metrics.failures,
+    (unsigned long long)metrics.hits, (unsigned long long)metrics.lookups);
+  if ((metrics.compiles == 0ULL) || (metrics.failures != 0ULL)) {
+    panic("jit didn't compile shapes of benchmark scripts");
+  }
+  #endif
+}
@@ -0,0 +1,2 @@
+rem extra flags are passed to gcc, for example: bench\build.bat -DIRIS_USE_TCC -I./tinycc/ -Ltinycc/win32 -ltcc
+call gcc -std=c11 src\iris*.c src\types\*.c bench\*.c -I./src/ -I./bench/ -Wall -Wextra -o iris-bench -O2 -DNDEBUG -flto %* -Wl,-Bstatic -static-libgcc -lpthread
@@ -0,0 +1,4 @@
+rem interpreter with native tier, needs tinycc submodule: git submodule update --init
+cd tinycc\win32 && call build-tcc.bat -c gcc -t 64 && cd ..\..
+call gcc -std=c11 src\*.c src\types\*.c -I./src/ -I./tinycc/ -Wall -Wextra -o iris -g -flto -DIRIS_COLLECT_MEMORY_METRICS -DIRIS_USE_TCC -Ltinycc/win32 -ltcc -Wl,-Bstatic -static-libgcc -lpthread
+copy /y tinycc\win32\libtcc.dll .
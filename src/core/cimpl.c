@@ -11,6 +11,7 @@
 #include "iris_reader.h"
 #include "iris_memory.h"
 #include "iris_utils.h"
+#include "iris_jit.h"
 
 // todo: should we automatically convert types? for example when mixing integers and floats
 // todo: resolving symbol in reader might be a better way
@@ -24,7 +25,12 @@
 // >>> (defn metrics []
 //        (c-call "metrics"))
 /*
-  @brief    Calls built-in memory metrics function
+  @brief    Returns memory metrics collected so far as dict
+            Keys are symbols: allocations, frees, resizes, live-bytes, peak-bytes,
+            histogram -- list of allocation counts by power of two sizes,
+            kinds -- dict of allocations, total-bytes and live-bytes by object kind
+            jit -- dict of lookups, hits, compiles, failures and compile-ns, only with IRIS_USE_TCC
+            Nil is returned if metrics aren't collected in this build
   @variants (0)
 */
 static IrisObject cimpl_metrics(const IrisObject* args, size_t arg_count) {
@@ -32,8 +38,101 @@ static IrisObject cimpl_metrics(const IrisObject* args, size_t arg_count) {
   if (arg_count != 0ULL) {
     return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
   }
-  iris_metrics_print_repr(); // todo: return it as string?
-  return (IrisObject){0}; // nil
+  IrisMemoryMetrics metrics;
+  if (iris_metrics_snapshot(&metrics) == false) {
+    iris_metrics_print_repr();
+    return (IrisObject){0}; // nil
+  }
+  #define push_metric(m_dict, m_key, m_value) {                               \
+    IrisObject value = int_to_object((intmax_t)(m_value));                    \
+    dict_push_object(&(m_dict), symbol_to_object(symbol_from_chars(m_key)), &value); \
+  }
+  IrisDict result = dict_new();
+  push_metric(result, "allocations", metrics.allocations);
+  push_metric(result, "frees", metrics.frees);
+  push_metric(result, "resizes", metrics.resizes);
+  push_metric(result, "live-bytes", metrics.live_bytes);
+  push_metric(result, "peak-bytes", metrics.peak_bytes);
+  {
+    IrisList histogram = list_new();
+    list_reserve(&histogram, IRIS_METRICS_HISTOGRAM_BUCKETS);
+    for (size_t i = 0ULL; i < IRIS_METRICS_HISTOGRAM_BUCKETS; i++) {
+      list_push_int(&histogram, (intmax_t)metrics.histogram[i]);
+    }
+    dict_push_list(&result, symbol_to_object(symbol_from_chars("histogram")), &histogram);
+  }
+  {
+    IrisDict kinds = dict_new();
+    for (unsigned int kind = 0U; kind < N_OBJECT_KINDS; kind++) {
+      IrisDict entry = dict_new();
+      push_metric(entry, "allocations", metrics.kind_allocations[kind]);
+      push_metric(entry, "total-bytes", metrics.kind_total_bytes[kind]);
+      push_metric(entry, "live-bytes", metrics.kind_live_bytes[kind]);
+      IrisObject entry_object = dict_to_object(entry);
+      dict_push_object(&kinds, symbol_to_object(symbol_from_chars(iris_metrics_kind_name(kind))), &entry_object);
+    }
+    IrisObject kinds_object = dict_to_object(kinds);
+    dict_push_object(&result, symbol_to_object(symbol_from_chars("kinds")), &kinds_object);
+  }
+  #ifdef IRIS_USE_TCC
+  {
+    IrisJitMetrics jit_metrics;
+    jit_metrics_snapshot(&jit_metrics);
+    IrisDict jit = dict_new();
+    push_metric(jit, "lookups", jit_metrics.lookups);
+    push_metric(jit, "hits", jit_metrics.hits);
+    push_metric(jit, "compiles", jit_metrics.compiles);
+    push_metric(jit, "failures", jit_metrics.failures);
+    push_metric(jit, "compile-ns", jit_metrics.compile_ns);
+    IrisObject jit_object = dict_to_object(jit);
+    dict_push_object(&result, symbol_to_object(symbol_from_chars("jit")), &jit_object);
+  }
+  #endif
+  #undef push_metric
+  return dict_to_object(result);
+}
+
+static bool cimpl_is_hashable(const IrisObject obj) {
+  return (obj.kind == irisObjectKindInt) || (obj.kind == irisObjectKindFloat) ||
+         (obj.kind == irisObjectKindString) || (obj.kind == irisObjectKindSymbol);
+}
+
+/*
+  @brief    Returns copy of item that is stored in dict or map by given key or in vector by given index
+            Symbol and string keys with the same name address the same item
+  @variants (2: dict any) (2: map any) (2: vector int)
+*/
+static IrisObject cimpl_get(const IrisObject* args, size_t arg_count) {
+  if (arg_count != 2ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
+  }
+  assert(pointer_is_valid(args));
+  if (args[0].kind == irisObjectKindVector) {
+    if (args[1].kind != irisObjectKindInt) {
+      return error_to_object(error_from_chars(irisErrorTypeError, "index of get should be int"));
+    }
+    if ((args[1].int_variant < 0) || ((size_t)args[1].int_variant >= vector_card(*args[0].vector_variant))) {
+      return error_to_object(error_from_chars(irisErrorNameError, "index is outside of vector"));
+    }
+    return object_copy(*vector_nth(*args[0].vector_variant, (size_t)args[1].int_variant));
+  }
+  if ((args[0].kind != irisObjectKindDict) && (args[0].kind != irisObjectKindMap)) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "first argument of get should be dict, map or vector"));
+  }
+  if (!cimpl_is_hashable(args[1])) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "key of get should be hashable"));
+  }
+  if (args[0].kind == irisObjectKindMap) {
+    const IrisObject* found = map_find(*args[0].map_variant, args[1]);
+    if (found == NULL) {
+      return error_to_object(error_from_chars(irisErrorNameError, "key isn't present in map"));
+    }
+    return object_copy(*found);
+  }
+  if (dict_has(*args[0].dict_variant, args[1]) == false) {
+    return error_to_object(error_from_chars(irisErrorNameError, "key isn't present in dict"));
+  }
+  return dict_get(*args[0].dict_variant, args[1]);
 }
 
 // todo: something more poetic?
@@ -110,11 +209,17 @@ static IrisObject cimpl_first(const IrisObject* args, size_t arg_count) {
   if (arg_count != 1ULL) {
     return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
   }
+  if (args[0].kind == irisObjectKindVector) {
+    if (vector_is_empty(*args[0].vector_variant)) {
+      return (IrisObject){0}; // nil
+    }
+    return object_copy(*vector_nth(*args[0].vector_variant, 0ULL));
+  }
   if (args[0].kind != irisObjectKindList) {
-    return error_to_object(error_from_chars(irisErrorTypeError, "argument of first should be list"));
+    return error_to_object(error_from_chars(irisErrorTypeError, "argument of first should be list or vector"));
   }
-  if (args[0].list_variant.len != 0) {
-    IrisObject copy = object_copy(args[0].list_variant.items[0]);
+  if (args[0].list_variant->len != 0) {
+    IrisObject copy = object_copy(args[0].list_variant->items[0]);
     return copy;
   } else {
     return (IrisObject){0}; // nil
@@ -125,14 +230,97 @@ static IrisObject cimpl_rest(const IrisObject* args, size_t arg_count) {
   if (arg_count != 1ULL) {
     return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
   }
+  if (args[0].kind == irisObjectKindVector) {
+    // shares nodes with argument
+    return vector_to_object(vector_rest(*args[0].vector_variant));
+  }
   if (args[0].kind != irisObjectKindList) {
-    return error_to_object(error_from_chars(irisErrorTypeError, "argument of first should be list"));
+    return error_to_object(error_from_chars(irisErrorTypeError, "argument of rest should be list or vector"));
   }
-  if (args[0].list_variant.len != 0) {
-    return list_to_object(list_slice(args[0].list_variant, 1ULL, list_card(args[0].list_variant) - 1ULL));
-  } else {
-    return list_to_object((IrisList){0});
+  // borrows items of argument
+  return list_to_object(list_rest(args[0].list_variant));
+}
+
+/*
+  @brief    Returns persistent vector of items of given list
+            Copies, rest and push of vectors share their nodes instead of copying items
+  @variants (1: list)
+*/
+static IrisObject cimpl_vec(const IrisObject* args, size_t arg_count) {
+  if (arg_count != 1ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
+  }
+  if (args[0].kind != irisObjectKindList) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "argument of vec should be list"));
+  }
+  return vector_to_object(vector_from_list(*args[0].list_variant));
+}
+
+/*
+  @brief    Returns vector with item appended, given vector isn't changed
+  @variants (2: vector any)
+*/
+static IrisObject cimpl_push(const IrisObject* args, size_t arg_count) {
+  if (arg_count != 2ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
+  }
+  if (args[0].kind != irisObjectKindVector) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "first argument of push should be vector"));
+  }
+  IrisVector result = vector_copy(*args[0].vector_variant);
+  IrisObject item = object_copy(args[1]);
+  vector_push_object(&result, &item);
+  return vector_to_object(result);
+}
+
+/*
+  @brief    Returns persistent map of given list of alternating keys and items, later keys replace earlier ones
+            Copies and assoc of maps share their nodes instead of copying pairs
+  @variants (1: list)
+*/
+static IrisObject cimpl_hash_map(const IrisObject* args, size_t arg_count) {
+  if (arg_count != 1ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
+  }
+  if (args[0].kind != irisObjectKindList) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "argument of hash-map should be list"));
+  }
+  const IrisList* pairs = args[0].list_variant;
+  if ((pairs->len % 2ULL) != 0ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "hash-map requires even number of items"));
+  }
+  for (size_t i = 0ULL; i < pairs->len; i += 2ULL) {
+    if (!cimpl_is_hashable(pairs->items[i])) {
+      return error_to_object(error_from_chars(irisErrorTypeError, "keys of hash-map should be hashable"));
+    }
+  }
+  IrisMap empty = map_new();
+  IrisMapTransient result = map_transient(&empty);
+  for (size_t i = 0ULL; i < pairs->len; i += 2ULL) {
+    IrisObject item = object_copy(pairs->items[i + 1ULL]);
+    map_transient_push_object(&result, pairs->items[i], &item);
+  }
+  return map_to_object(map_persistent(&result));
+}
+
+/*
+  @brief    Returns map with key bound to item, given map isn't changed
+  @variants (3: map any any)
+*/
+static IrisObject cimpl_assoc(const IrisObject* args, size_t arg_count) {
+  if (arg_count != 3ULL) {
+    return error_to_object(error_from_chars(irisErrorContractViolation, "invalid argument count"));
+  }
+  if (args[0].kind != irisObjectKindMap) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "first argument of assoc should be map"));
+  }
+  if (!cimpl_is_hashable(args[1])) {
+    return error_to_object(error_from_chars(irisErrorTypeError, "key of assoc should be hashable"));
   }
+  IrisMap result = map_copy(*args[0].map_variant);
+  IrisObject item = object_copy(args[2]);
+  map_push_object(&result, args[1], &item);
+  return map_to_object(result);
 }
 
 // todo: it may leak memory if body tries to return allocated object
@@ -221,15 +409,15 @@ static IrisObject cimpl_rest(const IrisObject* args, size_t arg_count) {
 //   if (supposedly_list.kind != irisObjectKindList) {
 //     return error_to_object(error_from_chars(irisErrorTypeError, "second argument of reduce should be list"));
 //   }
-//   if (supposedly_list.list_variant.len < 2ULL) {
+//   if (supposedly_list.list_variant->len < 2ULL) {
 //     return error_to_object(error_from_chars(irisErrorTypeError, "there should be at least 2 arguments in list to be reduced"));
 //   }
 //   IrisObject cell[2] = {
-//     func_call(args[0].func_variant, &supposedly_list.list_variant.items[0], 2ULL),
+//     func_call(args[0].func_variant, &supposedly_list.list_variant->items[0], 2ULL),
 //     (IrisObject){0}
 //   };
-//   for (size_t i = 2ULL; i < supposedly_list.list_variant.len; i++) {
-//     cell[1] = supposedly_list.list_variant.items[i];
+//   for (size_t i = 2ULL; i < supposedly_list.list_variant->len; i++) {
+//     cell[1] = supposedly_list.list_variant->items[i];
 //     IrisObject to_destoy = cell[0];
 //     cell[0] = func_call(args[0].func_variant, cell, 2ULL);
 //     object_destroy(&to_destoy);
@@ -1,6 +1,9 @@
 #include "iris.h"
 #include "iris_eval.h"
 #include "iris_utils.h"
+#include "iris_hash.h"
+#include "iris_pool.h"
+#include "iris_profile.h"
 
 // todo: move OS specific stuff to separate file?
 #ifdef _WIN32
@@ -17,6 +20,7 @@ void iris_init() {
     iris_check_warn(success_in != (BOOL)0, "cannot set terminal input to UTF8 mode");
   }
   #endif
+  iris_hash_init();
   init_error_module();
   eval_module_init();
 }
@@ -24,4 +28,11 @@ void iris_init() {
 void iris_deinit(void) {
   eval_module_deinit();
   deinit_error_module();
+  symbol_module_deinit();
+  #ifdef IRIS_PROFILE_ALLOCATION_SITES
+  iris_profile_dump();
+  #endif
+  #ifdef IRIS_USE_POOL
+  iris_pool_deinit();
+  #endif
 }
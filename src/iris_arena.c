@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "iris_arena.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+// todo: chunks could be requested from OS directly with mmap / VirtualAlloc and be decommitted on reset
+// todo: reset could poison released memory in debug builds to catch dangling references
+
+#define ARENA_CHUNK_PREALLOC (64ULL * 1024ULL)
+#define ARENA_CHUNK_GROW_FACTOR 2ULL
+#define ARENA_ALIGNMENT (sizeof(max_align_t))
+#define ARENA_NO_LAST_BLOCK SIZE_MAX
+
+static_assert((ARENA_ALIGNMENT & (ARENA_ALIGNMENT - 1ULL)) == 0ULL, "arena alignment should be power of 2");
+static_assert(ARENA_CHUNK_GROW_FACTOR > 0ULL, "arena chunk grow factor shouldn't be 0");
+
+typedef struct _IrisArenaChunk {
+  struct _IrisArenaChunk* next;
+  size_t cap;   // bytes available for blocks
+  size_t used;  // bytes that are already bumped
+  size_t last;  // offset of the most recent block, ARENA_NO_LAST_BLOCK if it was popped
+} IrisArenaChunk;
+
+typedef struct {
+  // stored right before every block, required for copying on resize
+  size_t size;
+} IrisArenaBlock;
+
+#define arena_align(n) (((n) + ARENA_ALIGNMENT - 1ULL) & ~(ARENA_ALIGNMENT - 1ULL))
+#define ARENA_CHUNK_HEADER arena_align(sizeof(IrisArenaChunk))
+#define ARENA_BLOCK_HEADER arena_align(sizeof(IrisArenaBlock))
+
+#define arena_chunk_data(chunk) ((unsigned char*)(chunk) + ARENA_CHUNK_HEADER)
+#define arena_block_of(mem) ((IrisArenaBlock*)((unsigned char*)(mem) - ARENA_BLOCK_HEADER))
+
+static _Thread_local IrisArena* bound_arena = NULL;
+
+#ifdef IRIS_COLLECT_MEMORY_METRICS
+static size_t n_arena_allocations = 0ULL;
+static size_t n_arena_bytes = 0ULL;
+static size_t n_arena_chunks = 0ULL;
+static size_t n_arena_resets = 0ULL;
+static size_t n_arena_in_place_resizes = 0ULL;
+#endif
+
+IrisArena arena_new(IrisArenaMode mode) {
+  IrisArena result = {
+    .chunks = NULL,
+    .next_chunk_size = ARENA_CHUNK_PREALLOC,
+    .mode = mode,
+  };
+  return result;
+}
+
+bool arena_is_valid(const IrisArena arena) {
+  return (arena.next_chunk_size != 0ULL) && (arena.mode <= irisArenaModeResetPerForm);
+}
+
+static IrisArenaChunk* arena_push_chunk(IrisArena* arena, size_t min_bytes) {
+  size_t cap = arena->next_chunk_size;
+  while (cap < min_bytes) {
+    cap *= ARENA_CHUNK_GROW_FACTOR;
+  }
+  IrisArenaChunk* chunk = (IrisArenaChunk*)iris_standard_alloc(ARENA_CHUNK_HEADER + cap);
+  chunk->next = arena->chunks;
+  chunk->cap = cap;
+  chunk->used = 0ULL;
+  chunk->last = ARENA_NO_LAST_BLOCK;
+  arena->chunks = chunk;
+  arena->next_chunk_size = cap * ARENA_CHUNK_GROW_FACTOR;
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  n_arena_chunks++;
+  #endif
+  return chunk;
+}
+
+static IrisArenaChunk* arena_find_chunk(const IrisArena* arena, const void* mem) {
+  const unsigned char* ptr = (const unsigned char*)mem;
+  for (IrisArenaChunk* chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+    if ((ptr >= arena_chunk_data(chunk)) && (ptr < (arena_chunk_data(chunk) + chunk->cap))) {
+      return chunk;
+    }
+  }
+  return NULL;
+}
+
+static void* arena_bump(IrisArena* arena, size_t bytes) {
+  assert(bytes != 0ULL);
+  size_t total = ARENA_BLOCK_HEADER + arena_align(bytes);
+  IrisArenaChunk* chunk = arena->chunks;
+  if ((chunk == NULL) || ((chunk->cap - chunk->used) < total)) {
+    chunk = arena_push_chunk(arena, total);
+  }
+  IrisArenaBlock* block = (IrisArenaBlock*)(arena_chunk_data(chunk) + chunk->used);
+  block->size = bytes;
+  chunk->last = chunk->used;
+  chunk->used += total;
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  n_arena_allocations++;
+  n_arena_bytes += bytes;
+  #endif
+  return (unsigned char*)block + ARENA_BLOCK_HEADER;
+}
+
+__forceinline bool arena_block_is_last(const IrisArenaChunk* chunk, const void* mem) {
+  return (chunk->last != ARENA_NO_LAST_BLOCK) &&
+    ((const unsigned char*)mem == (arena_chunk_data(chunk) + chunk->last + ARENA_BLOCK_HEADER));
+}
+
+bool arena_owns(const IrisArena* arena, const void* mem) {
+  assert(pointer_is_valid(arena));
+  return arena_find_chunk(arena, mem) != NULL;
+}
+
+void arena_reset(IrisArena* arena) {
+  assert(pointer_is_valid(arena));
+  assert(arena_is_valid(*arena));
+  if (arena->chunks == NULL) {
+    return;
+  }
+  IrisArenaChunk* chunk = arena->chunks->next;
+  while (chunk != NULL) {
+    IrisArenaChunk* next = chunk->next;
+    iris_standard_free(chunk);
+    chunk = next;
+  }
+  arena->chunks->next = NULL;
+  arena->chunks->used = 0ULL;
+  arena->chunks->last = ARENA_NO_LAST_BLOCK;
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  n_arena_resets++;
+  #endif
+}
+
+void arena_destroy(IrisArena* arena) {
+  assert(pointer_is_valid(arena));
+  assert(arena_is_valid(*arena));
+  iris_check(bound_arena != arena, "attempt to destroy arena that is bound to thread");
+  IrisArenaChunk* chunk = arena->chunks;
+  while (chunk != NULL) {
+    IrisArenaChunk* next = chunk->next;
+    iris_standard_free(chunk);
+    chunk = next;
+  }
+  arena->chunks = NULL;
+  arena->next_chunk_size = 0ULL;
+}
+
+void arena_bind(IrisArena* arena) {
+  assert((arena == NULL) || arena_is_valid(*arena));
+  bound_arena = arena;
+}
+
+IrisArena* arena_bound(void) {
+  return bound_arena;
+}
+
+void* iris_arena_alloc(size_t bytes) {
+  if (bytes == 0ULL) {
+    return NULL;
+  }
+  IrisArena* arena = bound_arena;
+  if ((arena == NULL) || (arena->mode == irisArenaModeOff)) {
+    return IRIS_HEAP_ALLOC(bytes);
+  }
+  return arena_bump(arena, bytes);
+}
+
+void* iris_arena_resize(void* mem, size_t bytes) {
+  if (mem == NULL) {
+    return iris_arena_alloc(bytes);
+  } else if (bytes == 0ULL) {
+    iris_arena_free(mem);
+    return NULL;
+  }
+  IrisArena* arena = bound_arena;
+  IrisArenaChunk* chunk = ((arena != NULL) && (arena->mode != irisArenaModeOff)) ? arena_find_chunk(arena, mem) : NULL;
+  if (chunk == NULL) {
+    // block was allocated on heap before arena was bound, it's kept there as it might escape
+    return IRIS_HEAP_RESIZE(mem, bytes);
+  }
+  IrisArenaBlock* block = arena_block_of(mem);
+  if (arena_block_is_last(chunk, mem) &&
+      ((chunk->last + ARENA_BLOCK_HEADER + arena_align(bytes)) <= chunk->cap)) {
+    // most recent block can grow and shrink in place
+    chunk->used = chunk->last + ARENA_BLOCK_HEADER + arena_align(bytes);
+    block->size = bytes;
+    #ifdef IRIS_COLLECT_MEMORY_METRICS
+    n_arena_in_place_resizes++;
+    #endif
+    return mem;
+  }
+  size_t old_size = block->size;
+  void* resized = arena_bump(arena, bytes);
+  memcpy(resized, mem, (old_size < bytes) ? old_size : bytes);
+  return resized;
+}
+
+void iris_arena_free(void* mem) {
+  assert(pointer_is_valid(mem));
+  IrisArena* arena = bound_arena;
+  IrisArenaChunk* chunk = ((arena != NULL) && (arena->mode != irisArenaModeOff)) ? arena_find_chunk(arena, mem) : NULL;
+  if (chunk == NULL) {
+    IRIS_HEAP_FREE(mem);
+  } else if (arena_block_is_last(chunk, mem)) {
+    chunk->used = chunk->last;
+    chunk->last = ARENA_NO_LAST_BLOCK;
+  }
+}
+
+void iris_arena_metrics_print_repr(void) {
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  (void)fprintf(stdout, "arena allocations: %llu, bytes: %llu\n", (unsigned long long)n_arena_allocations, (unsigned long long)n_arena_bytes);
+  (void)fprintf(stdout, "arena chunks: %llu, resets: %llu, in-place resizes: %llu\n",
+    (unsigned long long)n_arena_chunks, (unsigned long long)n_arena_resets, (unsigned long long)n_arena_in_place_resizes);
+  #endif
+}
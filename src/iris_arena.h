@@ -0,0 +1,55 @@
+#ifndef IRIS_ARENA_H
+#define IRIS_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// todo: arenas could be nested, for example for scoped evaluation of macros on resolving
+
+typedef enum {
+  irisArenaModeOff,           // arena isn't used, every allocation goes to heap
+  irisArenaModeRetain,        // memory is released only when arena is destroyed
+  irisArenaModeResetPerForm,  // memory is released after evaluation of each top-level form
+} IrisArenaMode;
+
+typedef struct _IrisArena {
+  // region allocator that is owned by single interpreter thread
+  // allocations are bumped from chunks that grow geometrically and are released all at once
+  // frees of individual blocks are no-ops, except for the most recent one which is popped
+  struct _IrisArenaChunk* chunks; // most recent and biggest chunk is first
+  size_t next_chunk_size;
+  IrisArenaMode mode;
+} IrisArena;
+
+IrisArena arena_new(IrisArenaMode);
+void arena_destroy(IrisArena*);
+
+/*
+  @brief  Release all memory that was bumped, biggest chunk is kept for reuse
+  @warn   Every object allocated in arena is dangling after that
+*/
+void arena_reset(IrisArena*);
+
+/*
+  @brief  Returns true if pointer resides in one of arena chunks
+*/
+bool arena_owns(const IrisArena*, const void*);
+
+bool arena_is_valid(const IrisArena);
+
+/*
+  @brief  Route IRIS_ALLOC/IRIS_RESIZE/IRIS_FREE of calling thread to given arena
+          Passing NULL makes thread allocate from heap again
+  @warn   Objects allocated in arena should be destroyed while it's bound,
+          otherwise arena memory will be passed to heap free
+*/
+void arena_bind(IrisArena*);
+IrisArena* arena_bound(void);
+
+// hooks that are used when IRIS_USE_ARENA is defined, fall back to heap when no arena is bound
+void* iris_arena_alloc(size_t bytes);
+void* iris_arena_resize(void* mem, size_t bytes);
+void  iris_arena_free(void* mem);
+void  iris_arena_metrics_print_repr(void);
+
+#endif
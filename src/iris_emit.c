@@ -0,0 +1,410 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "iris_emit.h"
+#include "iris_eval.h"
+#include "iris_jit.h"
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+// todo: programs could be emitted as library with entry point instead of main, so they're linkable into other code
+// todo: forms without side effects on constants could be folded at translation time
+
+#define EMIT_STRING_LINE 64U // bytes of literal per line of emitted code
+
+typedef struct {
+  IrisFuncPrototype cfunc;
+  const char* name;
+} EmitBuiltin;
+
+typedef struct {
+  FILE* out;
+  const IrisObject** constants; // in order of appearance
+  size_t n_constants;
+  size_t constants_cap;
+  size_t next_constant;         // constant that emitted code refers to next
+  EmitBuiltin* builtins;
+  size_t n_builtins;
+  size_t builtins_cap;
+  size_t value_depth;           // deepest nesting of list constants
+  bool* owned;                  // ownership of stack slots of form that is emitted
+} EmitState;
+
+static IrisObject emit_error(const char* msg) {
+  return error_to_object(error_from_chars(irisErrorTypeError, msg));
+}
+
+static bool emit_is_call(const IrisObject* obj) {
+  return (obj->kind == irisObjectKindList) &&
+         (obj->list_variant->len > 0ULL) &&
+         (obj->list_variant->items[0].kind == irisObjectKindFunc);
+}
+
+/*
+  @brief  Immediate values are written into code directly, so C compiler sees them
+*/
+static bool emit_is_immediate(const IrisObject* obj) {
+  return (obj->kind == irisObjectKindNone) || (obj->kind == irisObjectKindInt) ||
+         ((obj->kind == irisObjectKindFloat) && isfinite(obj->float_variant));
+}
+
+static void emit_immediate(FILE* out, const IrisObject* obj) {
+  switch (obj->kind) {
+    case irisObjectKindNone:
+      (void)fputs("(IrisObject){0}", out);
+      break;
+    case irisObjectKindInt:
+      if (obj->int_variant == INTMAX_MIN) {
+        (void)fputs("int_to_object(INTMAX_MIN)", out);
+      } else {
+        (void)fprintf(out, "int_to_object(INTMAX_C(%jd))", obj->int_variant);
+      }
+      break;
+    case irisObjectKindFloat:
+      (void)fprintf(out, "float_to_object(%a)", obj->float_variant);
+      break;
+    default:
+      panic("object isn't immediate"); // unreachable
+  }
+}
+
+/*
+  @return Index of builtin in emitted table or SIZE_MAX if function isn't bound in standard scope
+*/
+static size_t emit_builtin(EmitState* state, const IrisFunc* func) {
+  for (size_t i = 0ULL; i < state->n_builtins; i++) {
+    if (state->builtins[i].cfunc == func->cfunc) {
+      return i;
+    }
+  }
+  const char* name = eval_builtin_name(*func);
+  if (name == NULL) {
+    return SIZE_MAX;
+  }
+  if (state->n_builtins == state->builtins_cap) {
+    state->builtins_cap = (state->builtins_cap == 0ULL) ? 8ULL : (state->builtins_cap * 2ULL);
+    state->builtins = iris_resize(state->builtins, state->builtins_cap, EmitBuiltin);
+  }
+  state->builtins[state->n_builtins] = (EmitBuiltin){ .cfunc = func->cfunc, .name = name };
+  return state->n_builtins++;
+}
+
+/*
+  @brief  Check that constant could be constructed by emitted code
+  @return Nesting depth of lists in constant or SIZE_MAX if it cannot be emitted
+*/
+static size_t emit_check_value(EmitState* state, const IrisObject* obj) {
+  switch (obj->kind) {
+    case irisObjectKindNone:
+    case irisObjectKindInt:
+    case irisObjectKindString:
+    case irisObjectKindSymbol:
+      return 0ULL;
+    case irisObjectKindFloat:
+      return emit_is_immediate(obj) ? 0ULL : SIZE_MAX;
+    case irisObjectKindFunc:
+      return (emit_builtin(state, obj->func_variant) != SIZE_MAX) ? 0ULL : SIZE_MAX;
+    case irisObjectKindList: {
+      size_t result = 0ULL;
+      for (size_t i = 0ULL; i < obj->list_variant->len; i++) {
+        size_t depth = emit_check_value(state, &obj->list_variant->items[i]);
+        if (depth == SIZE_MAX) {
+          return SIZE_MAX;
+        }
+        if (depth > result) {
+          result = depth;
+        }
+      }
+      return result + 1ULL;
+    }
+    default:
+      return SIZE_MAX;
+  }
+}
+
+/*
+  @brief  Collect constants and builtins of form in the same order in which emit_form refers to them
+*/
+static IrisObject emit_collect(EmitState* state, const IrisObject* obj) {
+  if (emit_is_call(obj)) {
+    const IrisList* list = obj->list_variant;
+    if (emit_builtin(state, list->items[0].func_variant) == SIZE_MAX) {
+      return emit_error("only builtins of standard scope could be called from emitted code");
+    }
+    for (size_t i = 1ULL; i < list->len; i++) {
+      IrisObject status = emit_collect(state, &list->items[i]);
+      if (status.kind == irisObjectKindError) {
+        return status;
+      }
+    }
+    return (IrisObject){0}; // nil
+  }
+  if (emit_is_immediate(obj)) {
+    return (IrisObject){0}; // nil
+  }
+  size_t depth = emit_check_value(state, obj);
+  if (depth == SIZE_MAX) {
+    return emit_error("constant cannot be represented in emitted code");
+  }
+  if (depth > state->value_depth) {
+    state->value_depth = depth;
+  }
+  if (state->n_constants == state->constants_cap) {
+    state->constants_cap = (state->constants_cap == 0ULL) ? 64ULL : (state->constants_cap * 2ULL);
+    state->constants = (const IrisObject**)iris_resize((void*)state->constants, state->constants_cap, const IrisObject*);
+  }
+  state->constants[state->n_constants++] = obj;
+  return (IrisObject){0}; // nil
+}
+
+static void emit_bytes_literal(FILE* out, const char* bytes, size_t len) {
+  (void)fputc('"', out);
+  for (size_t i = 0ULL; i < len; i++) {
+    unsigned char ch = (unsigned char)bytes[i];
+    if ((i != 0ULL) && ((i % EMIT_STRING_LINE) == 0ULL)) {
+      (void)fputs("\"\n    \"", out);
+    }
+    // question mark is escaped so trigraphs couldn't form
+    if ((ch >= 0x20U) && (ch < 0x7FU) && (ch != '"') && (ch != '\\') && (ch != '?')) {
+      (void)fputc((int)ch, out);
+    } else {
+      (void)fprintf(out, "\\%03o", (unsigned int)ch);
+    }
+  }
+  (void)fputc('"', out);
+}
+
+/*
+  @brief  Emit statements that construct constant in variable v<depth>
+*/
+static void emit_value(EmitState* state, const IrisObject* obj, size_t depth) {
+  FILE* out = state->out;
+  switch (obj->kind) {
+    case irisObjectKindNone:
+    case irisObjectKindInt:
+    case irisObjectKindFloat:
+      (void)fprintf(out, "  v%zu = ", depth);
+      emit_immediate(out, obj);
+      (void)fputs(";\n", out);
+      break;
+    case irisObjectKindString: {
+      const IrisString* str = obj->string_variant;
+      (void)fprintf(out, "  {\n    static const char bytes[] = ");
+      emit_bytes_literal(out, string_bytes(*str), str->len);
+      (void)fprintf(out, ";\n    v%zu = string_to_object(string_from_view(bytes, bytes + %zu));\n  }\n", depth, str->len);
+      break;
+    }
+    case irisObjectKindSymbol: {
+      const IrisString* name = symbol_name(obj->symbol_variant);
+      (void)fprintf(out, "  {\n    static const char bytes[] = ");
+      emit_bytes_literal(out, string_bytes(*name), name->len);
+      (void)fprintf(out, ";\n    v%zu = symbol_to_object(symbol_from_view(bytes, bytes + %zu));\n  }\n", depth, name->len);
+      break;
+    }
+    case irisObjectKindFunc:
+      (void)fprintf(out, "  v%zu = object_copy(*b[%zu]);\n", depth, emit_builtin(state, obj->func_variant));
+      break;
+    case irisObjectKindList:
+      (void)fprintf(out, "  l%zu = list_new();\n", depth);
+      if (obj->list_variant->len != 0ULL) {
+        (void)fprintf(out, "  list_reserve(&l%zu, %zu);\n", depth, obj->list_variant->len);
+      }
+      for (size_t i = 0ULL; i < obj->list_variant->len; i++) {
+        emit_value(state, &obj->list_variant->items[i], depth + 1ULL);
+        (void)fprintf(out, "  list_push_object(&l%zu, &v%zu);\n", depth, (size_t)(depth + 1ULL));
+      }
+      (void)fprintf(out, "  v%zu = list_to_object(l%zu);\n", depth, depth);
+      break;
+    default:
+      panic("constant should be checked before emitting"); // unreachable
+  }
+}
+
+/*
+  @brief  Stack slots that evaluation of object requires
+*/
+static size_t emit_stack_size(const IrisObject* obj) {
+  if (!emit_is_call(obj)) {
+    return 1ULL;
+  }
+  size_t result = 1ULL;
+  const IrisList* list = obj->list_variant;
+  for (size_t i = 1ULL; i < list->len; i++) {
+    size_t size = (i - 1ULL) + emit_stack_size(&list->items[i]);
+    if (size > result) {
+      result = size;
+    }
+  }
+  return result;
+}
+
+static void emit_release(EmitState* state, size_t low, size_t high) {
+  for (size_t i = low; i < high; i++) {
+    if (state->owned[i]) {
+      (void)fprintf(state->out, "  object_destroy(&s[%zu]);\n", i);
+    }
+  }
+}
+
+/*
+  @brief  Emit statements that leave result of evaluation of object in slot s[base]
+          Arguments are evaluated left to right, errors release every owned slot and are returned from form
+*/
+static void emit_object(EmitState* state, const IrisObject* obj, size_t base) {
+  FILE* out = state->out;
+  if (emit_is_immediate(obj)) {
+    (void)fprintf(out, "  s[%zu] = ", base);
+    emit_immediate(out, obj);
+    (void)fputs(";\n", out);
+    state->owned[base] = false;
+    return;
+  }
+  if (!emit_is_call(obj)) {
+    (void)fprintf(out, "  s[%zu] = k[%zu];\n", base, state->next_constant++);
+    state->owned[base] = false;
+    return;
+  }
+  const IrisList* list = obj->list_variant;
+  size_t arg_count = list->len - 1ULL;
+  for (size_t i = 1ULL; i < list->len; i++) {
+    emit_object(state, &list->items[i], base + i - 1ULL);
+  }
+  size_t builtin = emit_builtin(state, list->items[0].func_variant);
+  // integer arithmetic is done in place with the same fast paths as native tier has
+  IrisJitInline inline_kind = jit_inline_of(state->builtins[builtin].cfunc);
+  bool has_fast_path = (inline_kind != irisJitInlineNone) && (arg_count == 2ULL);
+  if (has_fast_path) {
+    char guard[IRIS_JIT_GUARD_MAX];
+    (void)fwrite(guard, 1U, jit_inline_guard(guard, inline_kind, base, base + 1ULL), out);
+  }
+  (void)fprintf(out, "  r = func_call(*b[%zu]->func_variant, &s[%zu], %zu);\n", builtin, base, arg_count);
+  emit_release(state, base, base + arg_count);
+  (void)fputs("  if (r.kind == irisObjectKindError) {\n", out);
+  emit_release(state, 0ULL, base);
+  (void)fprintf(out, "  return r;\n  }\n  s[%zu] = r;\n", base);
+  if (has_fast_path) {
+    (void)fputs("  }\n", out);
+  }
+  state->owned[base] = true;
+}
+
+static void emit_form(EmitState* state, const IrisObject* obj, size_t idx) {
+  FILE* out = state->out;
+  size_t stack_size = emit_stack_size(obj);
+  state->owned = iris_resize(state->owned, stack_size, bool);
+  (void)fprintf(out, "\nstatic IrisObject iris_form_%zu(void) {\n  IrisObject s[%zu];\n", idx, stack_size);
+  if (emit_is_call(obj)) {
+    (void)fputs("  IrisObject r;\n", out);
+  }
+  emit_object(state, obj, 0ULL);
+  (void)fputs(state->owned[0] ? "  return s[0];\n}\n" : "  return object_copy(s[0]);\n}\n", out);
+}
+
+static void emit_program(EmitState* state, const IrisList codelist, const char* origin) {
+  FILE* out = state->out;
+  (void)fprintf(out,
+    "// generated by iris from %s\n"
+    "// build together with runtime sources except main.c, for example:\n"
+    "//   gcc -std=c11 -O2 this.c $(ls <iris>/src/*.c | grep -v main.c) <iris>/src/types/*.c -I<iris>/src -lpthread\n"
+    "\n"
+    "#include <stdio.h>\n"
+    "#include <stdint.h>\n"
+    "\n"
+    "#include \"iris.h\"\n"
+    "#include \"iris_misc.h\"\n"
+    "\n",
+    origin);
+  if (state->n_builtins != 0ULL) {
+    (void)fprintf(out, "static const IrisObject* b[%zu]; // builtins, viewed in standard scope\n", state->n_builtins);
+  }
+  if (state->n_constants != 0ULL) {
+    (void)fprintf(out, "static IrisObject k[%zu]; // constants\n", state->n_constants);
+  }
+
+  (void)fputs("static void iris_program_init(void) {\n  const IrisMap* scope = get_standard_scope_view();\n  (void)scope;\n", out);
+  for (size_t i = 0ULL; (state->n_constants != 0ULL) && (i <= state->value_depth); i++) {
+    (void)fprintf(out, "  IrisObject v%zu;\n", i);
+    if (i != state->value_depth) {
+      (void)fprintf(out, "  IrisList l%zu;\n", i);
+    }
+  }
+  for (size_t i = 0ULL; i < state->n_builtins; i++) {
+    (void)fprintf(out, "  {\n    static const char name[] = ");
+    emit_bytes_literal(out, state->builtins[i].name, strlen(state->builtins[i].name));
+    (void)fprintf(out, ";\n    b[%zu] = map_get_view(*scope, symbol_to_object(symbol_from_chars(name)));\n  }\n", i);
+  }
+  for (size_t i = 0ULL; i < state->n_constants; i++) {
+    emit_value(state, state->constants[i], 0ULL);
+    (void)fprintf(out, "  k[%zu] = v0;\n", i);
+  }
+  (void)fputs("}\n", out);
+
+  (void)fputs("\nstatic void iris_program_deinit(void) {\n", out);
+  if (state->n_constants != 0ULL) {
+    (void)fprintf(out, "  for (size_t i = 0; i < %zu; i++) {\n    object_destroy(&k[i]);\n  }\n", state->n_constants);
+  }
+  (void)fputs("}\n", out);
+
+  for (size_t i = 0ULL; i < codelist.len; i++) {
+    emit_form(state, &codelist.items[i], i);
+  }
+
+  (void)fputs("\nstatic IrisObject (*const iris_forms[])(void) = {\n", out);
+  for (size_t i = 0ULL; i < codelist.len; i++) {
+    (void)fprintf(out, "  iris_form_%zu,\n", i);
+  }
+  (void)fputs(
+    "  NULL\n"
+    "};\n"
+    "\n"
+    "int main(void) {\n"
+    "  iris_init();\n"
+    "  iris_program_init();\n"
+    "  int status = 0;\n"
+    "  for (size_t i = 0; iris_forms[i] != NULL; i++) {\n"
+    "    IrisObject result = iris_forms[i]();\n"
+    "    if (result.kind == irisObjectKindError) {\n"
+    "      (void)fputs(ANSI_ESCAPE_ERROR\"evaluation error:\"ANSI_ESCAPE_RESET\" \", stderr);\n"
+    "      object_print_repr(result, true);\n"
+    "      status = 1;\n"
+    "    }\n"
+    "    object_destroy(&result);\n"
+    "    if (status != 0) {\n"
+    "      break;\n"
+    "    }\n"
+    "  }\n"
+    "  iris_program_deinit();\n"
+    "  iris_deinit();\n"
+    "  #ifdef IRIS_COLLECT_MEMORY_METRICS\n"
+    "  iris_metrics_print_repr();\n"
+    "  #endif\n"
+    "  return status;\n"
+    "}\n", out);
+}
+
+IrisObject emit_codelist(const IrisList codelist, const char* origin, FILE* out) {
+  assert(list_is_valid(codelist));
+  assert(pointer_is_valid(origin));
+  assert(pointer_is_valid(out));
+  EmitState state = { .out = out };
+  IrisObject result = {0}; // nil
+  for (size_t i = 0ULL; i < codelist.len; i++) {
+    result = emit_collect(&state, &codelist.items[i]);
+    if (result.kind == irisObjectKindError) {
+      break;
+    }
+  }
+  if (result.kind != irisObjectKindError) {
+    emit_program(&state, codelist, origin);
+    if (ferror(out)) {
+      result = emit_error("cannot write emitted code");
+    }
+  }
+  if (state.constants != NULL) { iris_free((void*)state.constants); }
+  if (state.builtins != NULL) { iris_free(state.builtins); }
+  if (state.owned != NULL) { iris_free(state.owned); }
+  return result;
+}
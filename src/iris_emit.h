@@ -0,0 +1,19 @@
+#ifndef IRIS_EMIT_H
+#define IRIS_EMIT_H
+
+#include <stdio.h>
+
+#include "types/iris_types.h"
+
+// Ahead of time translation of resolved programs to C
+// Emitted translation unit defines main and links against runtime sources without main.c,
+// literals are constructed on startup and builtins are looked up once, so neither reader nor resolver is run
+
+/*
+  @brief  Write C translation unit that evaluates resolved codelist the same way eval_codelist does
+  @params origin - name of source that is mentioned in header of emitted file
+  @return Nil on success, error if program has objects that cannot be represented in C, nothing is written then
+*/
+IrisObject emit_codelist(const IrisList, const char* origin, FILE* out);
+
+#endif
@@ -12,9 +12,15 @@
 #include "types/iris_types.h"
 #include "iris_inter.h"
 #include "iris_reader.h"
+#include "iris_vm.h"
+#include "iris_jit.h"
+#include "iris_emit.h"
+#include "iris_os.h"
 #include "iris_memory.h"
+#include "iris_arena.h"
 #include "iris_utils.h"
 #include "iris_misc.h"
+#include "iris_profile.h"
 
 // todo: evaluation of "quote" lists returned from other lists
 //       maybe it could some sort of "delayed" promise? that should be computed on evaluation
@@ -22,9 +28,7 @@
 // todo: (help)
 // todo: (doc <symbol>)
 // todo: (for [binding list [binding list ...]] body) -- iteration over list
-// todo: call stack for debugging, _Thread_local
-
-#define IRIS_ARGUMENT_STACK_LIMIT 32
+// todo: call stack for debugging, frames of IrisEvalStack could be walked for it
 
 const char* repl_welcome_msg =
   "- Iris REPL -\n"
@@ -33,16 +37,31 @@ const char* repl_welcome_msg =
   "| enter (help) or (doc <name>) for getting info\n"
   "| ctrl+c or (quit) for exit\n";
 
-static IrisDict standard_scope; // todo: make it as RefCell of Dict? we would need it if we want to go full "meta" and have ability to retrieve it
+static IrisMap standard_scope; // todo: make it as RefCell of Map? we would need it if we want to go full "meta" and have ability to retrieve it
 static volatile bool repl_should_exit = false; // todo: make it a stack
+static unsigned int read_threads = 1U; // more than one makes files to be read whole before evaluation
+static IrisEvalMode eval_mode = irisEvalModeTree;
+
+#define EVAL_MAX_BUILTINS 32U
+
+typedef struct {
+  const char* name;
+  IrisFuncPrototype cfunc;
+} EvalBuiltin;
 
-IrisDict scope_default(void) {
-  IrisDict result = dict_new();
-  #define push_to_scope(m_push_by, m_cfunc, m_symbol) {         \
-    IrisFunc func = m_push_by(m_cfunc);                         \
-    IrisString symbol = string_from_chars(m_symbol);            \
-    dict_push_func(&result, string_to_object(symbol), &func);   \
-    string_destroy(&symbol);                                    \
+static EvalBuiltin standard_builtins[EVAL_MAX_BUILTINS]; // names of standard scope, for looking functions up by pointer
+static size_t n_standard_builtins = 0ULL;
+
+IrisMap scope_default(void) {
+  IRIS_PROFILE_ZONE("scope");
+  IrisMap empty = map_new();
+  IrisMapTransient result = map_transient(&empty);
+  n_standard_builtins = 0ULL;
+  #define push_to_scope(m_push_by, m_cfunc, m_symbol) {                   \
+    IrisFunc func = m_push_by(m_cfunc);                                   \
+    map_transient_push_func(&result, symbol_to_object(symbol_from_chars(m_symbol)), &func); \
+    assert(n_standard_builtins < EVAL_MAX_BUILTINS);                      \
+    standard_builtins[n_standard_builtins++] = (EvalBuiltin){ .name = m_symbol, .cfunc = m_cfunc }; \
   }
 
   // todo: decouple from cimpl.c
@@ -58,6 +77,11 @@ IrisDict scope_default(void) {
   push_to_scope(func_from_cfunc,        cimpl_quit,         "quit");
   push_to_scope(func_from_cfunc,        cimpl_first,        "first");
   push_to_scope(func_from_cfunc,        cimpl_rest,         "rest");
+  push_to_scope(func_from_cfunc,        cimpl_get,          "get");
+  push_to_scope(func_from_cfunc,        cimpl_vec,          "vec");
+  push_to_scope(func_from_cfunc,        cimpl_push,         "push");
+  push_to_scope(func_from_cfunc,        cimpl_hash_map,     "hash-map");
+  push_to_scope(func_from_cfunc,        cimpl_assoc,        "assoc");
   push_to_scope(func_from_cfunc,        cimpl_add,          "+");
   push_to_scope(func_from_cfunc,        cimpl_sub,          "-");
   // push_to_scope(func_from_cfunc,        cimpl_reduce,       "reduce");
@@ -65,31 +89,48 @@ IrisDict scope_default(void) {
   // push_to_scope(func_macro_from_cfunc,  cimpl_repeat_eval,  "repeat-eval!");
   push_to_scope(func_from_cfunc,        cimpl_metrics,      "metrics");
 
-  return result;
+  // fast paths are used by native tier and by translation to C
+  static bool inlines_registered = false;
+  if (!inlines_registered) {
+    jit_register_inline(cimpl_add, irisJitInlineAdd);
+    jit_register_inline(cimpl_sub, irisJitInlineSub);
+    inlines_registered = true;
+  }
+
+  return map_persistent(&result);
   #undef push_to_scope
 }
 
 void eval_module_init(void) {
-  if (dict_is_valid(standard_scope)) {
-    dict_destroy(&standard_scope);
+  if (!map_is_empty(standard_scope)) {
+    map_destroy(&standard_scope);
     warning("reconstruction of default scope dictionary");
   }
   standard_scope = scope_default();
 }
 
 void eval_module_deinit(void) {
-  if (dict_is_valid(standard_scope)) {
-    dict_destroy(&standard_scope);
+  if (map_is_valid(standard_scope)) {
+    map_destroy(&standard_scope);
   } else {
     panic("default scope dictionary is ill-formed");
   }
 }
 
-const IrisDict* get_standard_scope_view(void) {
-  assert(dict_is_valid(standard_scope));
+const IrisMap* get_standard_scope_view(void) {
+  assert(map_is_valid(standard_scope));
   return &standard_scope;
 }
 
+const char* eval_builtin_name(const IrisFunc func) {
+  for (size_t i = 0ULL; i < n_standard_builtins; i++) {
+    if (standard_builtins[i].cfunc == func.cfunc) {
+      return standard_builtins[i].name;
+    }
+  }
+  return NULL;
+}
+
 static void user_interrupt_handler(int sig) {
   (void)sig;
   repl_should_exit = true;
@@ -101,106 +142,346 @@ void enter_repl(void) {
   if (signal(SIGINT, user_interrupt_handler) == SIG_ERR) {
     iris_check_warn(true, "problem with setting up SIGINT handler for repl");
   }
-  const IrisDict* scope = get_standard_scope_view();
+  const IrisMap* scope = get_standard_scope_view();
   (void)fputs(repl_welcome_msg, stdout);
-  while (!repl_should_exit) {
-    (void)fputs(">>> ", stdout);
-    fflush(stdout);
-    IrisString line = string_from_file_line(stdin);
-    IrisObject code = string_read(line);
-    IrisObject torun = codelist_resolve(code, *scope);
-    if (torun.kind != irisObjectKindError) {
-      IrisObject result = eval_codelist(torun.list_variant);
-      object_print_repr(result, true);
-      object_destroy(&result);
+  IrisReader* reader = reader_from_fd(OS_STDIN_FD);
+  reader_set_prompts(reader, ">>> ", "... ");
+  IrisVm* vm = (eval_mode == irisEvalModeBytecode) ? vm_new() : NULL;
+  IrisEvalStack* stack = eval_stack_new();
+  IrisObject code;
+  while (!repl_should_exit && reader_next(reader, &code)) {
+    if (code.kind != irisObjectKindError) {
+      IrisObject torun = form_resolve_in_place(&code, *scope);
+      if (torun.kind != irisObjectKindError) {
+        IrisObject result = (vm != NULL) ? vm_eval_object(vm, torun) : eval_object(stack, torun);
+        object_print_repr(result, true);
+        object_destroy(&result);
+      } else {
+        object_print_repr(torun, true);
+      }
+      object_destroy(&torun);
     } else {
-      object_print_repr(torun, true);
+      object_print_repr(code, true);
+      object_destroy(&code);
     }
-    string_destroy(&line);
+  }
+  reader_destroy(&reader);
+  eval_stack_destroy(&stack);
+  if (vm != NULL) {
+    vm_destroy(&vm);
+  }
+  signal(SIGINT, SIG_DFL);
+}
+
+void eval_set_read_threads(unsigned int n_threads) {
+  iris_check(n_threads != 0U, "number of reader threads should be positive");
+  read_threads = n_threads;
+}
+
+void eval_set_mode(IrisEvalMode mode) {
+  eval_mode = mode;
+}
+
+static void eval_report_error(const IrisObject err, IrisInterStage stage) {
+  switch (stage) {
+    case irisInterStageRead: (void)fputs(ANSI_ESCAPE_ERROR"reader error:"ANSI_ESCAPE_RESET" ", stderr); break;
+    case irisInterStageResolve: (void)fputs(ANSI_ESCAPE_ERROR"resolving error:"ANSI_ESCAPE_RESET" ", stderr); break;
+    case irisInterStageEval: (void)fputs(ANSI_ESCAPE_ERROR"evaluation error:"ANSI_ESCAPE_RESET" ", stderr); break;
+    default: panic("unknown interpreter stage");
+  }
+  object_print_repr(err, true);
+}
+
+/*
+  @brief  Evaluate forms as soon as they're read
+*/
+static void eval_stream(IrisReader* reader) {
+  IrisInterHandle inter = inter_new();
+  inter_set_eval_mode(&inter, eval_mode);
+  if (inter_eval_reader(&inter, reader) == false) {
+    panic("couldn't start interpreter");
+  }
+  IrisObject result = inter_result(&inter);
+  IrisInterStage stage = inter_result_stage(&inter);
+  inter_destroy(&inter);
+  if (result.kind == irisObjectKindError) {
+    eval_report_error(result, stage);
+  }
+  object_destroy(&result);
+}
+
+/*
+  @brief  Read whole source on several threads first, then resolve and evaluate it
+*/
+static void eval_source_parallel(IrisStringSource* source) {
+  const IrisMap* scope = get_standard_scope_view();
+  IrisObject code = source_read_parallel(source, read_threads);
+  if (code.kind == irisObjectKindError) {
+    eval_report_error(code, irisInterStageRead);
     object_destroy(&code);
+    return;
+  }
+  IrisObject torun = codelist_resolve_in_place(&code, *scope);
+  if (torun.kind == irisObjectKindError) {
+    eval_report_error(torun, irisInterStageResolve);
     object_destroy(&torun);
+    return;
   }
-  signal(SIGINT, SIG_DFL);
+  IrisInterHandle inter = inter_new();
+  inter_set_eval_mode(&inter, eval_mode);
+  if (inter_eval_codelist(&inter, torun.list_variant) == false) {
+    panic("couldn't start interpreter");
+  }
+  object_destroy(&torun); // list is moved by interpreter, but its box is still here
+  IrisObject result = inter_result(&inter);
+  inter_destroy(&inter);
+  if (result.kind == irisObjectKindError) {
+    eval_report_error(result, irisInterStageEval);
+  }
+  object_destroy(&result);
 }
 
-void eval_file(const IrisString filename) {
+/*
+  @brief  Map file at given path for reading, panics if it cannot be opened
+*/
+static IrisStringSource* eval_map_file(const IrisString filename) {
   iris_check(filename.len <= PATH_MAX, "filename length exceeded system's limit");
   char path[filename.len + 1ULL];
-  memcpy(path, filename.data, filename.len * sizeof(char));
+  memcpy(path, string_bytes(filename), filename.len * sizeof(char));
   path[filename.len] = '\0';
-  FILE* file;
-  file = fopen(path, "rb");
-  iris_check(file != NULL, "cannot open file for evaluation");
-  IrisString content = string_from_file(file);
-  fclose(file);
-  const IrisDict* scope = get_standard_scope_view();
-  IrisObject code = string_read(content);
-  if (code.kind != irisObjectKindError) {
-    IrisObject torun = codelist_resolve(code, *scope);
-    if (torun.kind != irisObjectKindError) {
-      IrisInterHandle inter = inter_new();
-      if (inter_eval_codelist(&inter, &torun.list_variant) == false) {
-        panic("couldn't start interpreter");
-      }
-      IrisObject result = inter_result(&inter);
-      inter_destroy(&inter);
-      if (result.kind == irisObjectKindError) {
-        (void)fputs(ANSI_ESCAPE_ERROR"evaluation error:"ANSI_ESCAPE_RESET" ", stderr);
-        object_print_repr(result, true);
-      }
-      object_destroy(&result);
-    } else {
-      (void)fputs(ANSI_ESCAPE_ERROR"resolving error:"ANSI_ESCAPE_RESET" ", stderr);
-      object_print_repr(torun, true);
-    }
+  IrisMappedFile file;
+  if (!os_file_map(path, &file)) {
+    panic("cannot open file for evaluation");
+  }
+  return string_source_from_file(&file);
+}
+
+void eval_file(const IrisString filename) {
+  if (string_compare_chars(filename, "-")) {
+    IrisReader* reader = reader_from_fd(OS_STDIN_FD);
+    eval_stream(reader);
+    reader_destroy(&reader);
+    return;
+  }
+  IrisStringSource* source = eval_map_file(filename);
+  if (read_threads > 1U) {
+    eval_source_parallel(source);
   } else {
-    (void)fputs(ANSI_ESCAPE_ERROR"reader error:"ANSI_ESCAPE_RESET" ", stderr);
-    object_print_repr(code, true);
+    IrisReader* reader = reader_from_source(source);
+    eval_stream(reader);
+    reader_destroy(&reader);
   }
-  object_destroy(&code);
-  string_destroy(&content);
+  string_source_release(source); // mapping is kept alive by strings that borrow from it
+}
+
+/*
+  @brief  Read and resolve whole program and write it as C
+*/
+static void transpile_reader(IrisReader* reader, const char* origin, FILE* out) {
+  const IrisMap* scope = get_standard_scope_view();
+  IrisObject code = list_to_object(list_new());
+  IrisObject form;
+  while (reader_next(reader, &form)) {
+    if (form.kind == irisObjectKindError) {
+      eval_report_error(form, irisInterStageRead);
+      object_destroy(&form);
+      object_destroy(&code);
+      return;
+    }
+    list_push_object(code.list_variant, &form);
+  }
+  IrisObject torun = codelist_resolve_in_place(&code, *scope);
+  if (torun.kind == irisObjectKindError) {
+    eval_report_error(torun, irisInterStageResolve);
+    object_destroy(&torun);
+    return;
+  }
+  IrisObject status = emit_codelist(*torun.list_variant, origin, out);
+  if (status.kind == irisObjectKindError) {
+    (void)fputs(ANSI_ESCAPE_ERROR"translation error:"ANSI_ESCAPE_RESET" ", stderr);
+    object_print_repr(status, true);
+    object_destroy(&status);
+  }
+  object_destroy(&torun);
+}
+
+void transpile_file(const IrisString filename) {
+  iris_check(!string_compare_chars(filename, "-"), "translation requires file, as output is written next to it");
+  IrisStringSource* source = eval_map_file(filename);
+  IrisReader* reader = reader_from_source(source);
+  char path[filename.len + sizeof(".c")];
+  memcpy(path, string_bytes(filename), filename.len * sizeof(char));
+  memcpy(path + filename.len, ".c", sizeof(".c"));
+  FILE* out = fopen(path, "w");
+  iris_check(out != NULL, "cannot open file for translation output");
+  path[filename.len] = '\0'; // origin is mentioned without extension of output
+  transpile_reader(reader, path, out);
+  if (fclose(out) != 0) {
+    panic("cannot write translation output");
+  }
+  reader_destroy(&reader);
+  string_source_release(source);
+}
+
+#define EVAL_STACK_PREALLOC 64U
+
+typedef struct {
+  const IrisList* form; // call which arguments are being evaluated
+  size_t next;          // index of item of form that is evaluated next
+} EvalFrame;
+
+struct _IrisEvalStack {
+  IrisObject* values; // evaluated arguments of every frame, the topmost frame has its ones at the end
+  size_t n_values;
+  size_t values_cap;
+  EvalFrame* frames;
+  size_t n_frames;
+  size_t frames_cap;
+};
+
+IrisEvalStack* eval_stack_new(void) {
+  return iris_alloc0(1, IrisEvalStack);
+}
+
+void eval_stack_destroy(IrisEvalStack** stack) {
+  assert(stack != NULL);
+  assert(pointer_is_valid(*stack));
+  assert((*stack)->n_values == 0ULL);
+  if ((*stack)->values != NULL) { iris_free((*stack)->values); }
+  if ((*stack)->frames != NULL) { iris_free((*stack)->frames); }
+  iris_free(*stack);
+  *stack = NULL;
+}
+
+static size_t eval_stack_grown_cap(size_t cap) {
+  size_t result = (cap == 0ULL) ? EVAL_STACK_PREALLOC : (cap * 2ULL);
+  return (result > IRIS_EVAL_STACK_LIMIT) ? IRIS_EVAL_STACK_LIMIT : result;
+}
+
+// buffers outlive evaluation of any particular form, so they're always grown on heap, even when arena is bound
+
+static bool eval_stack_reserve_value(IrisEvalStack* stack) {
+  if (stack->n_values == stack->values_cap) {
+    if (stack->values_cap == IRIS_EVAL_STACK_LIMIT) {
+      return false;
+    }
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    stack->values_cap = eval_stack_grown_cap(stack->values_cap);
+    stack->values = iris_resize(stack->values, stack->values_cap, IrisObject);
+    arena_bind(arena);
+  }
+  return true;
+}
+
+static bool eval_stack_push_frame(IrisEvalStack* stack, const IrisList* form) {
+  if (stack->n_frames == stack->frames_cap) {
+    if (stack->frames_cap == IRIS_EVAL_STACK_LIMIT) {
+      return false;
+    }
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    stack->frames_cap = eval_stack_grown_cap(stack->frames_cap);
+    stack->frames = iris_resize(stack->frames, stack->frames_cap, EvalFrame);
+    arena_bind(arena);
+  }
+  // callee is the first item, evaluation of arguments starts past it
+  stack->frames[stack->n_frames++] = (EvalFrame){ .form = form, .next = 1ULL };
+  return true;
+}
+
+/*
+  @brief  Discard every pending call, values that were evaluated for them are destroyed
+*/
+static void eval_stack_unwind(IrisEvalStack* stack) {
+  for (size_t i = 0ULL; i < stack->n_values; i++) {
+    object_destroy(&stack->values[i]);
+  }
+  stack->n_values = 0ULL;
+  stack->n_frames = 0ULL;
+}
+
+static IrisObject eval_stack_exhausted(IrisEvalStack* stack) {
+  eval_stack_unwind(stack);
+  return error_to_object(error_from_chars(irisErrorStackError, "evaluation stack exhausted"));
+}
+
+static inline bool eval_is_call(const IrisObject* obj) {
+  return (obj->kind == irisObjectKindList) &&
+         (obj->list_variant->len > 0ULL) &&
+         (obj->list_variant->items[0].kind == irisObjectKindFunc);
 }
 
 // todo: define ways of scope modification
-//       it could probably be done by special dicts that have back references to scope from which they inherit
-IrisObject eval_object(const IrisObject obj) {
+//       scopes are persistent maps, so nested ones could extend copy of enclosing scope without affecting it
+IrisObject eval_object(IrisEvalStack* stack, const IrisObject obj) {
+  IRIS_PROFILE_ZONE("eval");
+  assert(pointer_is_valid(stack));
   assert(object_is_valid(obj));
-  if ((obj.kind == irisObjectKindList) &&
-      (obj.list_variant.len > 0ULL) &&
-      (obj.list_variant.items[0].kind == irisObjectKindFunc)) {
-    iris_check((obj.list_variant.len - 1ULL) <= IRIS_ARGUMENT_STACK_LIMIT, "argument stack exceeded");
-    IrisObject arguments[obj.list_variant.len - 1ULL];
-    for (size_t i = 1ULL; i < obj.list_variant.len; i++) {
-      IrisObject evaluated = eval_object(obj.list_variant.items[i]);
-      if (evaluated.kind == irisObjectKindError) {
-        for (size_t d = 1ULL; d < i; d++) {
-          object_destroy(&arguments[d - 1ULL]);
+  assert((stack->n_frames == 0ULL) && (stack->n_values == 0ULL));
+  if (!eval_is_call(&obj)) {
+    return object_copy(obj);
+  }
+  // nested calls push frames instead of recursing, so depth of code and width of calls are bound only by the stack
+  if (!eval_stack_push_frame(stack, obj.list_variant)) {
+    return eval_stack_exhausted(stack);
+  }
+  for (;;) {
+    EvalFrame* frame = &stack->frames[stack->n_frames - 1ULL];
+    const IrisList* form = frame->form;
+    if (frame->next != form->len) {
+      const IrisObject* item = &form->items[frame->next++];
+      if (eval_is_call(item)) {
+        if (!eval_stack_push_frame(stack, item->list_variant)) {
+          return eval_stack_exhausted(stack);
         }
-        return evaluated;
+      } else {
+        if (!eval_stack_reserve_value(stack)) {
+          return eval_stack_exhausted(stack);
+        }
+        stack->values[stack->n_values++] = object_copy(*item);
       }
-      arguments[i - 1ULL] = evaluated;
+      continue;
     }
+    // every argument is evaluated, they're the topmost values
     // todo: what if leading object is not func object but func list? which resolves to a function to be called
-    IrisObject result = func_call(obj.list_variant.items[0].func_variant, arguments, obj.list_variant.len - 1ULL);
-    for (size_t d = 0ULL; d < obj.list_variant.len - 1ULL; d++) {
+    size_t arg_count = form->len - 1ULL;
+    assert(stack->n_values >= arg_count);
+    IrisObject* arguments = stack->values + (stack->n_values - arg_count);
+    IrisObject result = func_call(*form->items[0].func_variant, arguments, arg_count);
+    for (size_t d = 0ULL; d < arg_count; d++) {
       object_destroy(&arguments[d]);
     }
-    return result;
+    stack->n_values -= arg_count;
+    stack->n_frames--;
+    if (result.kind == irisObjectKindError) {
+      eval_stack_unwind(stack);
+      return result;
+    }
+    if (stack->n_frames == 0ULL) {
+      assert(stack->n_values == 0ULL);
+      return result;
+    }
+    if (!eval_stack_reserve_value(stack)) {
+      object_destroy(&result);
+      return eval_stack_exhausted(stack);
+    }
+    stack->values[stack->n_values++] = result;
   }
-  return object_copy(obj);
 }
 
-IrisObject eval_codelist(const IrisList list) {
+IrisObject eval_codelist(IrisEvalStack* stack, const IrisList list) {
+  IRIS_PROFILE_ZONE("eval");
   assert(list_is_valid(list));
   if (list.len == 0ULL) {
     return (IrisObject){0}; // nil
   }
   for (size_t i = 0ULL; i < (list.len - 1ULL); i++) {
-    IrisObject result = eval_object(list.items[i]);
+    IrisObject result = eval_object(stack, list.items[i]);
     if (result.kind == irisObjectKindError) {
       return result;
     }
     object_destroy(&result);
   }
-  return eval_object(list.items[list.len - 1ULL]);
+  return eval_object(stack, list.items[list.len - 1ULL]);
 }
@@ -3,6 +3,23 @@
 
 #include "types/iris_types.h"
 
+typedef enum {
+  irisEvalModeTree,     // walk resolved forms recursively
+  irisEvalModeBytecode, // experimental, compile resolved forms to bytecode first, see iris_vm.h
+} IrisEvalMode;
+
+// calls that need more values or frames of evaluation stack are failed with irisErrorStackError
+#ifndef IRIS_EVAL_STACK_LIMIT
+  #define IRIS_EVAL_STACK_LIMIT (1U << 22)
+#endif
+
+// opaque type, argument values and frames of nested calls that are evaluated by tree walking
+// owned by single interpreter, buffers are reused between evaluations
+typedef struct _IrisEvalStack IrisEvalStack;
+
+IrisEvalStack* eval_stack_new(void);
+void eval_stack_destroy(IrisEvalStack**);
+
 void eval_module_init(void);
 void eval_module_deinit(void);
 
@@ -13,18 +30,41 @@ void enter_repl(void);
 
 void eval_file(const IrisString filename);
 
+/*
+  @brief  Translate file to C and write it next to it, with .c appended to its name, see iris_emit.h
+*/
+void transpile_file(const IrisString filename);
+
+/*
+  @brief  Number of threads on which files are read, with more than one
+          file is read whole in parallel before evaluation instead of form by form
+*/
+void eval_set_read_threads(unsigned int n_threads);
+
+/*
+  @brief  Way in which repl and files are evaluated, tree walking by default
+*/
+void eval_set_mode(IrisEvalMode);
+
 /*
   @warn Should be called after eval_module_init()
 */
-const IrisDict* get_standard_scope_view(void);
+const IrisMap* get_standard_scope_view(void);
+
+/*
+  @brief  Name under which function is bound in standard scope
+  @return NULL if function isn't a builtin
+*/
+const char* eval_builtin_name(const IrisFunc);
 
 /*
   @brief  Evaluate list of object as it's composed from valid code
           Returns result of evaluation of the last element
   @params scope - dictionary that contains callable and data objects, lookup of symbols is done against it
           in_repl - if true then every top-most list result will be printed, otherwise ignored
+  @warn   Stack isn't reentrant, builtins shouldn't evaluate through the same one
 */
-IrisObject eval_codelist(const IrisList);
-IrisObject eval_object(const IrisObject);
+IrisObject eval_codelist(IrisEvalStack*, const IrisList);
+IrisObject eval_object(IrisEvalStack*, const IrisObject);
 
 #endif
@@ -0,0 +1,118 @@
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "iris_hash.h"
+#include "iris_memory.h"
+
+// todo: 32 bit platforms would benefit from variant that doesn't require 64 bit multiplication
+
+static_assert(sizeof(size_t) == sizeof(uint64_t), "hashing currently assumes 64 bit size_t");
+
+static const uint64_t hash_secret[4] = {
+  0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+static uint64_t seed = 0xa0761d6478bd642fULL;
+
+/*
+  @brief  Multiply two words into 128 bit result and return its halves in place
+*/
+__forceinline void hash_mum(uint64_t* a, uint64_t* b) {
+  #ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64U);
+  #else
+  uint64_t ha = *a >> 32U, hb = *b >> 32U, la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32U);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32U);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32U) + (rm1 >> 32U) + c;
+  #endif
+}
+
+__forceinline uint64_t hash_mix(uint64_t a, uint64_t b) {
+  hash_mum(&a, &b);
+  return a ^ b;
+}
+
+// unaligned reads, little endian is assumed, on big endian hashes differ but are still valid
+__forceinline uint64_t hash_read8(const unsigned char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+__forceinline uint64_t hash_read4(const unsigned char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+__forceinline uint64_t hash_read3(const unsigned char* p, size_t len) {
+  return (((uint64_t)p[0]) << 16U) | (((uint64_t)p[len >> 1U]) << 8U) | p[len - 1U];
+}
+
+void iris_hash_init(void) {
+  #ifdef IRIS_HASH_SEED
+  seed = (uint64_t)(IRIS_HASH_SEED);
+  #else
+  // address of local is randomized by ASLR on most systems, time makes it differ between runs otherwise
+  uint64_t entropy = (uint64_t)(uintptr_t)&entropy;
+  entropy = hash_mix(entropy ^ hash_secret[0], (uint64_t)time(NULL) ^ hash_secret[1]);
+  entropy = hash_mix(entropy ^ hash_secret[2], (uint64_t)clock() ^ hash_secret[3]);
+  seed = entropy;
+  #endif
+}
+
+uint64_t iris_hash_seed(void) {
+  return seed;
+}
+
+size_t iris_hash_bytes(const void* bytes, size_t len) {
+  assert((bytes != NULL) || (len == 0ULL));
+  const unsigned char* p = (const unsigned char*)bytes;
+  uint64_t s = seed ^ hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+  uint64_t a, b;
+  if (len <= 16ULL) {
+    if (len >= 4ULL) {
+      a = (hash_read4(p) << 32U) | hash_read4(p + ((len >> 3U) << 2U));
+      b = (hash_read4(p + len - 4ULL) << 32U) | hash_read4(p + len - 4ULL - ((len >> 3U) << 2U));
+    } else if (len > 0ULL) {
+      a = hash_read3(p, len);
+      b = 0ULL;
+    } else {
+      a = b = 0ULL;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48ULL) {
+      // three independent lanes keep multipliers busy on long inputs
+      uint64_t s1 = s, s2 = s;
+      do {
+        s = hash_mix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8U) ^ s);
+        s1 = hash_mix(hash_read8(p + 16U) ^ hash_secret[2], hash_read8(p + 24U) ^ s1);
+        s2 = hash_mix(hash_read8(p + 32U) ^ hash_secret[3], hash_read8(p + 40U) ^ s2);
+        p += 48U;
+        i -= 48ULL;
+      } while (i > 48ULL);
+      s ^= s1 ^ s2;
+    }
+    while (i > 16ULL) {
+      s = hash_mix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8U) ^ s);
+      i -= 16ULL;
+      p += 16U;
+    }
+    a = hash_read8(p + i - 16ULL);
+    b = hash_read8(p + i - 8ULL);
+  }
+  a ^= hash_secret[1];
+  b ^= s;
+  hash_mum(&a, &b);
+  uint64_t result = hash_mix(a ^ hash_secret[0] ^ len, b ^ hash_secret[1]);
+  return (result == 0ULL) ? 1ULL : (size_t)result;
+}
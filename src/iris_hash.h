@@ -0,0 +1,24 @@
+#ifndef IRIS_HASH_H
+#define IRIS_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Seeded hashing of byte sequences, based on wyhash by Wang Yi (public domain)
+// Seed is chosen on every process start, so keys that collide can't be precomputed
+// Pass -DIRIS_HASH_SEED=<n> to get reproducible hashes, for example for debugging
+
+/*
+  @brief  Choose seed for this process
+  @warn   Should be called before any string is hashed, as cached hashes aren't recomputed
+*/
+void iris_hash_init(void);
+
+uint64_t iris_hash_seed(void);
+
+/*
+  @brief  Hash bytes with process seed, never returns 0, so it could be used as unset marker
+*/
+size_t iris_hash_bytes(const void* bytes, size_t len);
+
+#endif
@@ -4,35 +4,76 @@
 
 #include "iris_inter.h"
 #include "iris_eval.h"
+#include "iris_reader.h"
 #include "types/iris_types.h"
 #include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_pool.h"
+#include "iris_vm.h"
 #include "iris_utils.h"
 
 typedef struct _IrisInterThread {
   // handle on which interpreter caller can interact with started interpreter instance
   pthread_t thread;
+  IrisArena arena; // region from which evaluation allocates, only touched by interpreter thread while it runs
+  IrisInterStage stage; // written by interpreter thread, could be read after joining
+  IrisVm* vm; // NULL if forms are evaluated by walking them
+  IrisEvalStack* stack; // used when forms are evaluated by walking them
+  IrisMap scope; // names are resolved against it, shares nodes with standard scope
 } IrisInterThread;
 
 typedef struct {
   IrisList inhereted_scopes;  // immutable formed scopes
-  IrisDict local_scope;       // interpreter-local scope that could be modified
+  IrisMap  local_scope;       // interpreter-local scope that could be modified
 } IrisInter;
 
 typedef struct {
   IrisList codelist;
+  IrisReader* reader; // if not NULL then forms are read from it instead of codelist
+  IrisInterThread* inter;
 } IrisInterThreadPayload;
 
 IrisInterThread* inter_new(void) {
-  return iris_alloc0(1, IrisInterThread);
+  IrisInterThread* result = iris_alloc0(1, IrisInterThread);
+  #ifdef IRIS_USE_ARENA
+  result->arena = arena_new(irisArenaModeResetPerForm);
+  #else
+  result->arena = arena_new(irisArenaModeOff);
+  #endif
+  result->stack = eval_stack_new();
+  result->scope = map_copy(*get_standard_scope_view());
+  return result;
 }
 
 void inter_destroy(IrisInterThread** handle) {
   assert(handle != NULL);
   assert(*handle != NULL);
+  arena_destroy(&(*handle)->arena);
+  eval_stack_destroy(&(*handle)->stack);
+  map_destroy(&(*handle)->scope);
+  if ((*handle)->vm != NULL) {
+    vm_destroy(&(*handle)->vm);
+  }
   iris_free(*handle);
   *handle = NULL;
 }
 
+void inter_set_arena_mode(IrisInterThread** handle, IrisArenaMode mode) {
+  assert(handle != NULL);
+  assert(*handle != NULL);
+  (*handle)->arena.mode = mode;
+}
+
+void inter_set_eval_mode(IrisInterThread** handle, IrisEvalMode mode) {
+  assert(handle != NULL);
+  assert(*handle != NULL);
+  if ((mode == irisEvalModeBytecode) && ((*handle)->vm == NULL)) {
+    (*handle)->vm = vm_new();
+  } else if ((mode == irisEvalModeTree) && ((*handle)->vm != NULL)) {
+    vm_destroy(&(*handle)->vm);
+  }
+}
+
 static void inter_eval_thread_init(void) {
   // todo: not sure about that, might it fuck with calling thread?
   // todo: posix locale when available
@@ -40,14 +81,113 @@ static void inter_eval_thread_init(void) {
   setlocale(LC_ALL, ".utf8");
 }
 
+/*
+  @brief  Copy arena allocated object to heap so it could outlive the arena
+  @warn   Should be called when arena is bound, object is destroyed after copying
+*/
+static IrisObject inter_escape_object(IrisObject* obj, IrisArena* arena) {
+  // copies share boxes, so nothing short of clone would leave arena
+  arena_bind(NULL);
+  IrisObject result = object_clone(*obj);
+  arena_bind(arena);
+  object_destroy(obj);
+  return result;
+}
+
+static IrisObject inter_eval_object(IrisInterThread* inter, const IrisObject obj) {
+  return (inter->vm != NULL) ? vm_eval_object(inter->vm, obj) : eval_object(inter->stack, obj);
+}
+
+/*
+  @brief  Evaluate top-level forms one by one, allocating from the arena
+          Only result of the last form (or the first error) escapes to heap
+*/
+static IrisObject inter_eval_forms(const IrisList codelist, IrisInterThread* inter) {
+  assert(list_is_valid(codelist));
+  IrisArena* arena = &inter->arena;
+  if (arena->mode == irisArenaModeOff) {
+    return (inter->vm != NULL) ? vm_eval_codelist(inter->vm, codelist) : eval_codelist(inter->stack, codelist);
+  }
+  IrisObject result = {0}; // nil
+  arena_bind(arena);
+  for (size_t i = 0ULL; i < codelist.len; i++) {
+    result = inter_eval_object(inter, codelist.items[i]);
+    if ((result.kind == irisObjectKindError) || (i == (codelist.len - 1ULL))) {
+      result = inter_escape_object(&result, arena);
+      break;
+    }
+    object_destroy(&result);
+    if (arena->mode == irisArenaModeResetPerForm) {
+      arena_reset(arena);
+    }
+  }
+  arena_bind(NULL);
+  arena_reset(arena);
+  return result;
+}
+
+/*
+  @brief  Read, resolve and evaluate top-level forms one by one, as soon as each of them is read
+          Forms are read on heap, while resolving and evaluation allocate from the arena
+  @return Result of the last form or the first error, stage at which it happened is recorded
+*/
+static IrisObject inter_eval_stream(IrisReader* reader, IrisInterThread* inter) {
+  const IrisMap* scope = &inter->scope;
+  IrisArena* arena = (inter->arena.mode != irisArenaModeOff) ? &inter->arena : NULL;
+  IrisObject result = {0}; // nil
+  IrisObject code;
+  while (reader_next(reader, &code)) {
+    object_destroy(&result);
+    if (code.kind == irisObjectKindError) {
+      inter->stage = irisInterStageRead;
+      return code;
+    }
+    arena_bind(arena);
+    // form is heap allocated, but names are resolved into it from arena, so it's destroyed while arena is bound
+    IrisObject torun = form_resolve_in_place(&code, *scope);
+    if (torun.kind == irisObjectKindError) {
+      inter->stage = irisInterStageResolve;
+      result = torun;
+    } else {
+      inter->stage = irisInterStageEval;
+      result = inter_eval_object(inter, torun);
+      object_destroy(&torun);
+    }
+    if (arena != NULL) {
+      // it isn't known whether there are more forms, so every result escapes
+      result = inter_escape_object(&result, arena);
+    }
+    arena_bind(NULL);
+    if ((arena != NULL) && (arena->mode == irisArenaModeResetPerForm)) {
+      arena_reset(arena);
+    }
+    if (result.kind == irisObjectKindError) {
+      break;
+    }
+  }
+  if (arena != NULL) {
+    arena_reset(arena);
+  }
+  return result;
+}
+
 static void* inter_eval_thread(void* payload_void) {
   inter_eval_thread_init();
   IrisInterThreadPayload payload = *(IrisInterThreadPayload*)payload_void;
-  assert(list_is_valid(payload.codelist));
   IrisObject* result = iris_alloc0(1, IrisObject);
-  *result = eval_codelist(payload.codelist);
-  list_destroy(&payload.codelist);
+  if (payload.reader != NULL) {
+    *result = inter_eval_stream(payload.reader, payload.inter);
+  } else {
+    assert(list_is_valid(payload.codelist));
+    payload.inter->stage = irisInterStageEval;
+    *result = inter_eval_forms(payload.codelist, payload.inter);
+    list_destroy(&payload.codelist);
+  }
   iris_free(payload_void);
+  iris_metrics_thread_release();
+  #ifdef IRIS_USE_POOL
+  iris_pool_thread_release();
+  #endif
   pthread_exit((void*)result);
   return NULL;
 }
@@ -55,8 +195,10 @@ static void* inter_eval_thread(void* payload_void) {
 bool inter_eval_codelist(IrisInterThread** handle, IrisList* codelist) {
   IrisInterThreadPayload* payload = iris_alloc0(1, IrisInterThreadPayload);
   payload->codelist = *codelist;
+  payload->inter = *handle;
   int err = pthread_create(&((*handle)->thread), NULL, &inter_eval_thread, payload);
   if (err != 0) {
+    iris_free(payload);
     list_destroy(codelist);
     return false;
   } else {
@@ -65,6 +207,25 @@ bool inter_eval_codelist(IrisInterThread** handle, IrisList* codelist) {
   }
 }
 
+bool inter_eval_reader(IrisInterThread** handle, IrisReader* reader) {
+  assert(pointer_is_valid(reader));
+  IrisInterThreadPayload* payload = iris_alloc0(1, IrisInterThreadPayload);
+  payload->reader = reader;
+  payload->inter = *handle;
+  int err = pthread_create(&((*handle)->thread), NULL, &inter_eval_thread, payload);
+  if (err != 0) {
+    iris_free(payload);
+    return false;
+  }
+  return true;
+}
+
+IrisInterStage inter_result_stage(IrisInterThread** handle) {
+  assert(handle != NULL);
+  assert(*handle != NULL);
+  return (*handle)->stage;
+}
+
 IrisObject inter_result(IrisInterThread** handle) {
   IrisObject* buffer = NULL;
   int err = pthread_join((*handle)->thread, (void**)&buffer);
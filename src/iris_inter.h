@@ -4,25 +4,60 @@
 #include <stdbool.h>
 
 #include "types/iris_types.h"
+#include "iris_arena.h"
+#include "iris_reader.h"
+#include "iris_eval.h"
 
 // todo: interpreter should probably start with codestring, not codelist
 //       to then resolve it by scopes of its own
-// todo: ability to specify inhereted scopes of interpreters
+// todo: ability to specify inhereted scopes of interpreters, for now every one starts with copy of standard scope
+
+typedef enum {
+  irisInterStageRead,
+  irisInterStageResolve,
+  irisInterStageEval,
+} IrisInterStage;
 
 // opaque type for interfacing interpreters
 typedef struct _IrisInterThread* IrisInterHandle;
 
+/*
+  @warn Should be called after eval_module_init()
+*/
 IrisInterHandle inter_new(void);
 void inter_destroy(IrisInterHandle*);
 
+/*
+  @brief  Set how interpreter thread treats its arena, should be called before evaluation is started
+          Has effect only when allocation hooks are routed to arenas, see IRIS_USE_ARENA
+*/
+void inter_set_arena_mode(IrisInterHandle*, IrisArenaMode);
+
+/*
+  @brief  Set how interpreter thread evaluates forms, should be called before evaluation is started
+*/
+void inter_set_eval_mode(IrisInterHandle*, IrisEvalMode);
+
 /*
   @brief  Start new interpreter instance
   @return False on error, otherwise true
 */
 bool inter_eval_codelist(IrisInterHandle*, IrisList*);
 
+/*
+  @brief  Start new interpreter instance that evaluates forms as they are read
+  @warn   Reader is borrowed, it should be kept alive until inter_result
+  @return False on error, otherwise true
+*/
+bool inter_eval_reader(IrisInterHandle*, IrisReader*);
+
 // bool inter_eval_codestring(IrisInterHandle*, IrisString*);
 // bool inter_eval_file(IrisInterHandle*, const IrisString filename);
 IrisObject inter_result(IrisInterHandle*);
 
+/*
+  @brief  Stage at which evaluation stopped, should be called after inter_result
+*/
+IrisInterStage inter_result_stage(IrisInterHandle*);
+
 #endif
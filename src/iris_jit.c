@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "iris_jit.h"
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+#define JIT_MAX_INLINES 16U
+
+typedef struct {
+  IrisFuncPrototype cfunc;
+  IrisJitInline kind;
+} JitInlineEntry;
+
+static JitInlineEntry jit_inlines[JIT_MAX_INLINES];
+static size_t n_jit_inlines = 0ULL;
+
+void jit_register_inline(IrisFuncPrototype cfunc, IrisJitInline kind) {
+  assert(pointer_is_valid((const void*)cfunc));
+  iris_check(n_jit_inlines < JIT_MAX_INLINES, "too many inlined builtins");
+  jit_inlines[n_jit_inlines++] = (JitInlineEntry){ .cfunc = cfunc, .kind = kind };
+}
+
+IrisJitInline jit_inline_of(IrisFuncPrototype cfunc) {
+  for (size_t i = 0ULL; i < n_jit_inlines; i++) {
+    if (jit_inlines[i].cfunc == cfunc) {
+      return jit_inlines[i].kind;
+    }
+  }
+  return irisJitInlineNone;
+}
+
+size_t jit_inline_guard(char* buffer, IrisJitInline kind, size_t x, size_t y) {
+  assert(kind != irisJitInlineNone);
+  #define x_ "s[%zu].int_variant"
+  const char* format = (kind == irisJitInlineAdd)
+    ? "  if ((s[%zu].kind == irisObjectKindInt) && (s[%zu].kind == irisObjectKindInt) &&\n"
+      "      !(((" x_ " > 0) && (" x_ " > INTMAX_MAX - " x_ ")) || ((" x_ " < 0) && (" x_ " < INTMAX_MIN - " x_ ")))) {\n"
+      "    s[%zu].int_variant += " x_ ";\n"
+      "  } else {\n"
+    : "  if ((s[%zu].kind == irisObjectKindInt) && (s[%zu].kind == irisObjectKindInt) &&\n"
+      "      !(((" x_ " < 0) && (" x_ " > INTMAX_MAX + " x_ ")) || ((" x_ " > 0) && (" x_ " < INTMAX_MIN + " x_ ")))) {\n"
+      "    s[%zu].int_variant -= " x_ ";\n"
+      "  } else {\n";
+  #undef x_
+  int written = snprintf(buffer, IRIS_JIT_GUARD_MAX, format, x, y, x, x, y, x, x, y, x, y);
+  iris_check((written >= 0) && ((size_t)written < IRIS_JIT_GUARD_MAX), "fast path doesn't fit its buffer");
+  return (size_t)written;
+}
+
+#ifdef IRIS_USE_TCC
+
+#include "libtcc.h"
+
+#include "iris_vm.h"
+#include "iris_arena.h"
+#include "iris_hash.h"
+
+// todo: tcc states could be batched, every compiled chunk now pays for its own state and relocated sections
+// todo: type feedback from vm, so fast paths are emitted only where they were taken
+
+#define JIT_SOURCE_PREALLOC 1024U
+
+// generated code declares its own layout compatible object, as tcc doesn't see runtime headers
+static_assert(sizeof(IrisObjectKind) == sizeof(int), "object kind should be int sized for generated code");
+static_assert(sizeof(intmax_t) == sizeof(long long), "integers should be long long sized for generated code");
+static_assert(sizeof(IrisObject) == 16U, "object layout should match one declared in generated code");
+static_assert(offsetof(IrisObject, int_variant) == 8U, "object layout should match one declared in generated code");
+
+typedef struct {
+  uint64_t hash;
+  uint32_t* code;              // NULL if slot is empty
+  size_t code_len;
+  IrisFuncPrototype* callees;  // in order of calls
+  size_t n_callees;
+  size_t count;
+  TCCState* state;             // NULL until compiled
+  IrisJitProc proc;
+  bool failed;
+} JitEntry;
+
+struct _IrisJit {
+  JitEntry* entries;
+  size_t cap; // power of two
+  size_t len;
+};
+
+// libtcc before 0.9.28 keeps compiler state in globals, so states of different interpreters are never used at once
+static pthread_mutex_t jit_tcc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static atomic_size_t n_jit_lookups;
+static atomic_size_t n_jit_hits;
+static atomic_size_t n_jit_compiles;
+static atomic_size_t n_jit_failures;
+static atomic_uint_least64_t jit_compile_ns;
+
+IrisJit* jit_new(void) {
+  return iris_alloc0(1, IrisJit);
+}
+
+void jit_destroy(IrisJit** jit) {
+  assert(jit != NULL);
+  assert(pointer_is_valid(*jit));
+  for (size_t i = 0ULL; i < (*jit)->cap; i++) {
+    JitEntry* entry = &(*jit)->entries[i];
+    if (entry->code == NULL) {
+      continue;
+    }
+    if (entry->state != NULL) {
+      pthread_mutex_lock(&jit_tcc_lock);
+      tcc_delete(entry->state);
+      pthread_mutex_unlock(&jit_tcc_lock);
+    }
+    iris_free(entry->code);
+    if (entry->callees != NULL) {
+      iris_free(entry->callees);
+    }
+  }
+  if ((*jit)->entries != NULL) {
+    iris_free((*jit)->entries);
+  }
+  iris_free(*jit);
+  *jit = NULL;
+}
+
+static inline IrisFuncPrototype jit_callee(const IrisObject* const* constants, uint32_t idx) {
+  assert(constants[idx]->kind == irisObjectKindFunc);
+  return constants[idx]->func_variant->cfunc;
+}
+
+static uint64_t jit_shape_hash(const uint32_t* code, size_t code_len, const IrisObject* const* constants) {
+  uint64_t result = (uint64_t)iris_hash_bytes(code, code_len * sizeof(uint32_t));
+  for (size_t i = 0ULL; i < code_len; i++) {
+    switch ((IrisVmOp)code[i]) {
+      case irisVmOpPushConst: i += 1ULL; break;
+      case irisVmOpCall:
+        result = (result ^ (uint64_t)(uintptr_t)jit_callee(constants, code[i + 1ULL])) * 0x100000001B3ULL;
+        i += 2ULL;
+        break;
+      default: break;
+    }
+  }
+  return result;
+}
+
+static bool jit_shape_equal(const JitEntry* entry, uint64_t hash, const uint32_t* code, size_t code_len, const IrisObject* const* constants) {
+  if ((entry->hash != hash) || (entry->code_len != code_len) ||
+      (memcmp(entry->code, code, code_len * sizeof(uint32_t)) != 0)) {
+    return false;
+  }
+  size_t callee = 0ULL;
+  for (size_t i = 0ULL; i < code_len; i++) {
+    switch ((IrisVmOp)code[i]) {
+      case irisVmOpPushConst: i += 1ULL; break;
+      case irisVmOpCall:
+        if (entry->callees[callee++] != jit_callee(constants, code[i + 1ULL])) {
+          return false;
+        }
+        i += 2ULL;
+        break;
+      default: break;
+    }
+  }
+  return true;
+}
+
+static void jit_grow(IrisJit* jit) {
+  size_t cap = (jit->cap == 0ULL) ? 64ULL : (jit->cap * 2ULL);
+  JitEntry* entries = iris_alloc0(cap, JitEntry);
+  for (size_t i = 0ULL; i < jit->cap; i++) {
+    if (jit->entries[i].code == NULL) {
+      continue;
+    }
+    size_t slot = (size_t)jit->entries[i].hash & (cap - 1ULL);
+    while (entries[slot].code != NULL) {
+      slot = (slot + 1ULL) & (cap - 1ULL);
+    }
+    entries[slot] = jit->entries[i];
+  }
+  if (jit->entries != NULL) {
+    iris_free(jit->entries);
+  }
+  jit->entries = entries;
+  jit->cap = cap;
+}
+
+static JitEntry* jit_insert(IrisJit* jit, uint64_t hash, const uint32_t* code, size_t code_len, const IrisObject* const* constants) {
+  if ((jit->len * 2ULL) >= jit->cap) {
+    jit_grow(jit);
+  }
+  size_t slot = (size_t)hash & (jit->cap - 1ULL);
+  while (jit->entries[slot].code != NULL) {
+    slot = (slot + 1ULL) & (jit->cap - 1ULL);
+  }
+  JitEntry* entry = &jit->entries[slot];
+  *entry = (JitEntry){ .hash = hash, .code_len = code_len };
+  entry->code = iris_alloc(code_len, uint32_t);
+  memcpy(entry->code, code, code_len * sizeof(uint32_t));
+  for (size_t i = 0ULL; i < code_len; i++) {
+    switch ((IrisVmOp)code[i]) {
+      case irisVmOpPushConst: i += 1ULL; break;
+      case irisVmOpCall:
+        entry->callees = iris_resize(entry->callees, entry->n_callees + 1ULL, IrisFuncPrototype);
+        entry->callees[entry->n_callees++] = jit_callee(constants, code[i + 1ULL]);
+        i += 2ULL;
+        break;
+      default: break;
+    }
+  }
+  jit->len++;
+  return entry;
+}
+
+typedef struct {
+  char* data;
+  size_t len;
+  size_t cap;
+} JitSource;
+
+static void jit_emit(JitSource* source, const char* format, ...) {
+  for (;;) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(source->data + source->len, source->cap - source->len, format, args);
+    va_end(args);
+    iris_check(written >= 0, "formatting of generated code failed");
+    if ((source->len + (size_t)written) < source->cap) {
+      source->len += (size_t)written;
+      return;
+    }
+    source->cap = (source->cap + (size_t)written) * 2ULL;
+    source->data = iris_resize(source->data, source->cap, char);
+  }
+}
+
+/*
+  @brief  Release owned slots in range, ownership of every slot is known statically
+*/
+static void jit_emit_release(JitSource* source, const bool* owned, size_t low, size_t high) {
+  for (size_t i = low; i < high; i++) {
+    if (owned[i]) {
+      jit_emit(source, "  iris_jit_destroy(&s[%zu]);\n", i);
+    }
+  }
+}
+
+/*
+  @brief  Translate chunk to C, stack slots become elements of local array
+          Fast paths mirror guards of builtins exactly, anything else falls to the builtin itself
+*/
+static char* jit_translate(const JitEntry* entry, size_t stack_size) {
+  JitSource source = { .data = iris_alloc(JIT_SOURCE_PREALLOC, char), .cap = JIT_SOURCE_PREALLOC };
+  source.data[0] = '\0';
+  jit_emit(&source,
+    "typedef __SIZE_TYPE__ size_t;\n"
+    "typedef struct { int kind; union { long long int_variant; void* pointer; }; } IrisObject;\n"
+    "_Static_assert(sizeof(IrisObject) == 16, \"object layout should match runtime\");\n"
+    "enum { irisObjectKindInt = %d, irisObjectKindError = %d };\n"
+    "#define INTMAX_MAX 9223372036854775807LL\n"
+    "#define INTMAX_MIN (-INTMAX_MAX - 1LL)\n"
+    "IrisObject iris_jit_copy(const IrisObject*);\n"
+    "void iris_jit_destroy(IrisObject*);\n",
+    (int)irisObjectKindInt, (int)irisObjectKindError);
+  for (size_t i = 0ULL; i < entry->n_callees; i++) {
+    jit_emit(&source, "IrisObject iris_jit_f%zu(const IrisObject*, size_t);\n", i);
+  }
+  jit_emit(&source, "IrisObject iris_jit_entry(const IrisObject* const* k) {\n  IrisObject s[%zu];\n  IrisObject r;\n",
+    (stack_size != 0ULL) ? stack_size : 1ULL);
+
+  bool* owned = iris_alloc0((stack_size != 0ULL) ? stack_size : 1ULL, bool);
+  size_t sp = 0ULL;
+  size_t callee = 0ULL;
+  for (size_t i = 0ULL; i < entry->code_len; i++) {
+    const uint32_t* op = &entry->code[i];
+    switch ((IrisVmOp)op[0]) {
+      case irisVmOpPushConst:
+        jit_emit(&source, "  s[%zu] = *k[%u];\n", sp, op[1]);
+        owned[sp++] = false;
+        i += 1ULL;
+        break;
+      case irisVmOpCall: {
+        size_t arg_count = (size_t)op[2];
+        size_t base = sp - arg_count;
+        IrisJitInline inline_kind = jit_inline_of(entry->callees[callee]);
+        bool has_fast_path = (inline_kind != irisJitInlineNone) && (arg_count == 2ULL);
+        if (has_fast_path) {
+          char guard[IRIS_JIT_GUARD_MAX];
+          (void)jit_inline_guard(guard, inline_kind, base, base + 1ULL);
+          jit_emit(&source, "%s", guard);
+        }
+        jit_emit(&source, "  r = iris_jit_f%zu(&s[%zu], %zu);\n", callee, base, arg_count);
+        jit_emit_release(&source, owned, base, sp);
+        jit_emit(&source, "  if (r.kind == irisObjectKindError) {\n");
+        jit_emit_release(&source, owned, 0ULL, base);
+        jit_emit(&source, "  return r;\n  }\n  s[%zu] = r;\n", base);
+        if (has_fast_path) {
+          jit_emit(&source, "  }\n");
+        }
+        sp = base;
+        owned[sp++] = true;
+        callee++;
+        i += 2ULL;
+        break;
+      }
+      case irisVmOpPop:
+        sp--;
+        jit_emit_release(&source, owned, sp, sp + 1ULL);
+        break;
+      case irisVmOpReturn:
+        assert(sp == 1ULL);
+        jit_emit(&source, owned[0] ? "  return s[0];\n}\n" : "  return iris_jit_copy(&s[0]);\n}\n");
+        break;
+      default:
+        panic("unknown bytecode operation");
+    }
+  }
+  iris_free(owned);
+  return source.data;
+}
+
+static IrisObject jit_copy_object(const IrisObject* obj) {
+  return object_copy(*obj);
+}
+
+static void jit_destroy_object(IrisObject* obj) {
+  object_destroy(obj);
+}
+
+static void jit_report_error(void* opaque, const char* msg) {
+  (void)opaque;
+  warning(msg);
+}
+
+static uint64_t jit_clock_ns(void) {
+  struct timespec time;
+  (void)timespec_get(&time, TIME_UTC);
+  return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+/*
+  @return False if tcc couldn't compile generated code, entry is marked as failed then
+*/
+static bool jit_compile(JitEntry* entry, size_t stack_size) {
+  uint64_t start = jit_clock_ns();
+  char* source = jit_translate(entry, stack_size);
+  pthread_mutex_lock(&jit_tcc_lock);
+  TCCState* state = tcc_new();
+  bool status = state != NULL;
+  if (status) {
+    tcc_set_error_func(state, NULL, jit_report_error);
+    // generated code doesn't use libc, so there's no need to locate its headers and libraries
+    tcc_set_options(state, "-nostdinc -nostdlib");
+    status = (tcc_set_output_type(state, TCC_OUTPUT_MEMORY) == 0) && (tcc_compile_string(state, source) == 0);
+  }
+  if (status) {
+    (void)tcc_add_symbol(state, "iris_jit_copy", (const void*)jit_copy_object);
+    (void)tcc_add_symbol(state, "iris_jit_destroy", (const void*)jit_destroy_object);
+    // struct copies are compiled to calls, -nostdlib leaves them unresolved where tcc doesn't look symbols up in process
+    (void)tcc_add_symbol(state, "memmove", (const void*)memmove);
+    (void)tcc_add_symbol(state, "memcpy", (const void*)memcpy);
+    (void)tcc_add_symbol(state, "memset", (const void*)memset);
+    for (size_t i = 0ULL; i < entry->n_callees; i++) {
+      char name[32];
+      (void)snprintf(name, sizeof(name), "iris_jit_f%zu", i);
+      (void)tcc_add_symbol(state, name, (const void*)entry->callees[i]);
+    }
+    #ifdef TCC_RELOCATE_AUTO
+    status = tcc_relocate(state, TCC_RELOCATE_AUTO) >= 0; // 0.9.27 and older take memory to relocate to
+    #else
+    status = tcc_relocate(state) >= 0;
+    #endif
+  }
+  if (status) {
+    entry->proc = (IrisJitProc)tcc_get_symbol(state, "iris_jit_entry");
+    status = entry->proc != NULL;
+  }
+  if (!status && (state != NULL)) {
+    tcc_delete(state);
+  }
+  pthread_mutex_unlock(&jit_tcc_lock);
+  iris_free(source);
+  if (status) {
+    entry->state = state;
+    atomic_fetch_add_explicit(&n_jit_compiles, 1U, memory_order_relaxed);
+  } else {
+    entry->failed = true;
+    atomic_fetch_add_explicit(&n_jit_failures, 1U, memory_order_relaxed);
+  }
+  atomic_fetch_add_explicit(&jit_compile_ns, jit_clock_ns() - start, memory_order_relaxed);
+  return status;
+}
+
+IrisJitProc jit_lookup(IrisJit* jit, const uint32_t* code, size_t code_len, const IrisObject* const* constants, size_t stack_size) {
+  assert(pointer_is_valid(jit));
+  assert(pointer_is_valid(code));
+  atomic_fetch_add_explicit(&n_jit_lookups, 1U, memory_order_relaxed);
+  uint64_t hash = jit_shape_hash(code, code_len, constants);
+  JitEntry* entry = NULL;
+  if (jit->cap != 0ULL) {
+    for (size_t slot = (size_t)hash & (jit->cap - 1ULL); jit->entries[slot].code != NULL; slot = (slot + 1ULL) & (jit->cap - 1ULL)) {
+      if (jit_shape_equal(&jit->entries[slot], hash, code, code_len, constants)) {
+        entry = &jit->entries[slot];
+        break;
+      }
+    }
+  }
+  if (entry == NULL) {
+    if (jit->len >= IRIS_JIT_MAX_SHAPES) {
+      return NULL;
+    }
+    // entries and generated code outlive any particular form, so they never go to arena
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    entry = jit_insert(jit, hash, code, code_len, constants);
+    arena_bind(arena);
+  }
+  if (entry->proc == NULL) {
+    if (entry->failed || (++entry->count < IRIS_JIT_THRESHOLD)) {
+      return NULL;
+    }
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    bool status = jit_compile(entry, stack_size);
+    arena_bind(arena);
+    if (!status) {
+      return NULL;
+    }
+  }
+  atomic_fetch_add_explicit(&n_jit_hits, 1U, memory_order_relaxed);
+  return entry->proc;
+}
+
+void jit_metrics_snapshot(IrisJitMetrics* result) {
+  assert(pointer_is_valid(result));
+  *result = (IrisJitMetrics){
+    .lookups = atomic_load(&n_jit_lookups),
+    .hits = atomic_load(&n_jit_hits),
+    .compiles = atomic_load(&n_jit_compiles),
+    .failures = atomic_load(&n_jit_failures),
+    .compile_ns = atomic_load(&jit_compile_ns),
+  };
+}
+
+void jit_metrics_print_repr(void) {
+  IrisJitMetrics metrics;
+  jit_metrics_snapshot(&metrics);
+  (void)fputs("--- jit metrics:\n", stdout);
+  (void)fprintf(stdout, "lookups: %llu, hit rate: %.1f%%\n", (unsigned long long)metrics.lookups,
+    (metrics.lookups != 0ULL) ? (100.0 * (double)metrics.hits / (double)metrics.lookups) : 0.0);
+  (void)fprintf(stdout, "compiles: %llu, failures: %llu, compile time: %.3fms\n",
+    (unsigned long long)metrics.compiles, (unsigned long long)metrics.failures, (double)metrics.compile_ns / 1e6);
+}
+
+#endif
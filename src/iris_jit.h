@@ -0,0 +1,83 @@
+#ifndef IRIS_JIT_H
+#define IRIS_JIT_H
+
+// Native tier for bytecode of iris_vm.h, enabled by -DIRIS_USE_TCC and linking against libtcc of tinycc submodule
+// Chunks are keyed by their shape, which is code and called builtins, but not values of constants,
+// so forms that differ only by literals share compiled code
+// Once shape is seen IRIS_JIT_THRESHOLD times it's translated to C and compiled in memory
+// Integer fast paths of builtins are shared with translation of iris_emit.h, so they're available without tcc
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types/iris_types.h"
+
+#define IRIS_JIT_GUARD_MAX 512U // longest fast path that jit_inline_guard writes
+
+typedef enum {
+  irisJitInlineNone,
+  irisJitInlineAdd, // integer fast path of (+ x y)
+  irisJitInlineSub, // integer fast path of (- x y)
+} IrisJitInline;
+
+/*
+  @brief  Emit integer fast path instead of direct call for given builtin
+  @warn   Should be called before any interpreter is started, fast path should match builtin for integers
+*/
+void jit_register_inline(IrisFuncPrototype, IrisJitInline);
+
+/*
+  @return Fast path registered for builtin or irisJitInlineNone
+*/
+IrisJitInline jit_inline_of(IrisFuncPrototype);
+
+/*
+  @brief  Write C code of guarded fast path for operands in slots s[x] and s[y], result is left in s[x]
+          Guards are the same as builtins have, so results and errors don't change
+          Code expects IrisObject with kind and int_variant, irisObjectKindInt, INTMAX_MIN and INTMAX_MAX,
+          it ends with opened else branch, in which caller should call builtin and then close it
+  @params buffer - room for IRIS_JIT_GUARD_MAX bytes
+  @return Length of written code, which is always below IRIS_JIT_GUARD_MAX
+*/
+size_t jit_inline_guard(char* buffer, IrisJitInline, size_t x, size_t y);
+
+#ifdef IRIS_USE_TCC
+
+#ifndef IRIS_JIT_THRESHOLD
+  #define IRIS_JIT_THRESHOLD 16U
+#endif
+
+#define IRIS_JIT_MAX_SHAPES 4096U // shapes above it are left to vm, so memory is bounded for code without repetitions
+
+/*
+  @brief  Compiled chunk, takes the same constants as vm would
+*/
+typedef IrisObject (*IrisJitProc)(const IrisObject* const* constants);
+
+typedef struct {
+  size_t lookups;
+  size_t hits;     // lookups that were served by native code
+  size_t compiles;
+  size_t failures; // shapes that tcc refused, they're left to vm
+  uint64_t compile_ns;
+} IrisJitMetrics;
+
+// opaque type, owned by single interpreter
+typedef struct _IrisJit IrisJit;
+
+IrisJit* jit_new(void);
+void jit_destroy(IrisJit**);
+
+/*
+  @brief  Count evaluation of chunk and compile it once its shape is hot
+  @params stack_size - number of stack slots that chunk requires
+  @return Native code of chunk or NULL if it should be run by vm
+*/
+IrisJitProc jit_lookup(IrisJit*, const uint32_t* code, size_t code_len, const IrisObject* const* constants, size_t stack_size);
+
+void jit_metrics_snapshot(IrisJitMetrics*);
+void jit_metrics_print_repr(void);
+
+#endif
+
+#endif
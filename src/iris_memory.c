@@ -2,28 +2,60 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_pool.h"
+#include "iris_profile.h"
 #include "types/iris_types.h"
 #include "iris_utils.h"
 
 // todo: thread-local memory treatment might be beneficial for running interpreter instances concurrently
 //       possible reference: https://link.springer.com/content/pdf/10.1007%2F978-3-540-31985-6_10.pdf
-// todo: it's possible to log status and lifetime changes of every allocation
+//       for now interpreter threads could bump their allocations from arenas, see iris_arena.h
+// todo: it's possible to log status and lifetime changes of every allocation, for now only call sites are profiled
 // todo: something similar to mcheck.h functionalities, we could trace double frees and validity of pointers as allocations
 // todo: debugging memory snapshots? by which you can log what allocations weren't freed between certain start and end point
 
 #ifdef IRIS_COLLECT_MEMORY_METRICS
-// static IrisDict allocations;
-static size_t n_allocations = 0ULL;
-static size_t n_resizes = 0ULL;
-static size_t n_frees = 0ULL;
-// size_t memory_usage_current = 0ULL; // todo: for that we need to trace resizes which requires some additional work
-// size_t memory_usage_peak = 0ULL;    //       we could probably use dictionary for that and use memory locations as keys
-                                       //       tho there's problem with that as info about allocations will consume memory too
-                                       //       so, info will be quite spoiled
-#endif
+// every metered allocation is prefixed with header, so sizes are known on free and resize without any side table
+// headers are accounted as well, as it's memory that is used because of allocation anyway
+typedef struct {
+  size_t size;        // requested bytes, without header
+  unsigned int kind;  // IrisObjectKind to which allocation is attributed
+} IrisMeteredHeader;
+
+#define METERED_HEADER_SIZE ((sizeof(IrisMeteredHeader) + sizeof(max_align_t) - 1ULL) & ~(sizeof(max_align_t) - 1ULL))
+#define metered_header_of(mem) ((IrisMeteredHeader*)((unsigned char*)(mem) - METERED_HEADER_SIZE))
+
+static_assert(N_OBJECT_KINDS <= IRIS_METRICS_KINDS, "metrics should be able to hold every object kind");
+
+// reader and interpreter threads allocate concurrently, so every thread counts into its own slot which only it writes,
+// slots are summed on snapshot, only live bytes are shared as peak has to be tracked against their total
+typedef struct _IrisMetricsSlot {
+  atomic_size_t allocations;
+  atomic_size_t frees;
+  atomic_size_t resizes;
+  atomic_size_t histogram[IRIS_METRICS_HISTOGRAM_BUCKETS];
+  atomic_size_t kind_allocations[IRIS_METRICS_KINDS];
+  atomic_size_t kind_live_bytes[IRIS_METRICS_KINDS]; // could wrap in single slot, as memory is freed by other thread
+  atomic_size_t kind_total_bytes[IRIS_METRICS_KINDS];
+  atomic_bool taken;                // slots of released threads are reused, so they're bounded by concurrent threads
+  struct _IrisMetricsSlot* next;
+} IrisMetricsSlot;
+
+static _Atomic(IrisMetricsSlot*) metrics_slots;
+static _Thread_local IrisMetricsSlot* local_metrics = NULL;
+static atomic_size_t metrics_live_bytes;
+static atomic_size_t metrics_peak_bytes;
 
+// counters are only written by thread that owns slot, so there's no need for atomic read-modify-write
+#define metrics_add(counter, n) \
+  atomic_store_explicit(&(counter), atomic_load_explicit(&(counter), memory_order_relaxed) + (n), memory_order_relaxed)
+#define metrics_sub(counter, n) metrics_add(counter, -(size_t)(n))
+#define metrics_load(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+#endif
 bool pointer_is_valid(const void* p) { // todo: could probably be inlined by #define
   // extern char etext;
   return (p != NULL); // && ((char*) p > &etext);
@@ -48,9 +80,6 @@ void* iris_standard_alloc(size_t bytes) {
   }
   void* mem = malloc(bytes);
   assert(pointer_is_valid(mem)); // todo: shouldn't be assert, but user code catch-able error
-  #ifdef IRIS_COLLECT_MEMORY_METRICS
-  n_allocations++;
-  #endif
   return mem;
 }
 #pragma GCC diagnostic pop
@@ -65,32 +94,241 @@ void* iris_standard_resize(void* mem, size_t bytes) {
   assert(pointer_is_valid(mem));
   void* resized = realloc(mem, bytes);
   assert(pointer_is_valid(resized)); // todo: shouldn't be assert, but user code catch-able error
-  #ifdef IRIS_COLLECT_MEMORY_METRICS
-  n_resizes++;
-  #endif
   return resized;
 }
 
 void iris_standard_free(void* mem) {
   assert(pointer_is_valid(mem));
   free(mem);
-  #ifdef IRIS_COLLECT_MEMORY_METRICS
-  n_frees++;
-  #endif
 }
 
-void* iris_alloc0_untyped(size_t bytes) {
+void* iris_alloc0_untyped(size_t bytes, unsigned int kind, const char* file, int line) {
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  void* mem = iris_metered_alloc(bytes, kind, file, line);
+  #else
+  (void)kind;
+  (void)file;
+  (void)line;
   void* mem = IRIS_ALLOC(bytes);
+  #endif
   memset(mem, 0, bytes);
   return mem;
 }
 
+#ifdef IRIS_COLLECT_MEMORY_METRICS
+__forceinline size_t metrics_histogram_bucket(size_t bytes) {
+  size_t bucket = 0ULL;
+  while ((bucket < (IRIS_METRICS_HISTOGRAM_BUCKETS - 1U)) && ((1ULL << bucket) < bytes)) {
+    bucket++;
+  }
+  return bucket;
+}
+
+static IrisMetricsSlot* metrics_local_slot(void) {
+  if (local_metrics != NULL) {
+    return local_metrics;
+  }
+  IrisMetricsSlot* slot = atomic_load_explicit(&metrics_slots, memory_order_acquire);
+  for (; slot != NULL; slot = slot->next) {
+    if (!atomic_load_explicit(&slot->taken, memory_order_relaxed) &&
+        !atomic_exchange_explicit(&slot->taken, true, memory_order_acquire)) {
+      local_metrics = slot;
+      return slot;
+    }
+  }
+  // slots are never freed, so counters of exited threads are kept
+  slot = (IrisMetricsSlot*)iris_standard_alloc(sizeof(IrisMetricsSlot));
+  memset(slot, 0, sizeof(IrisMetricsSlot));
+  atomic_init(&slot->taken, true);
+  IrisMetricsSlot* expected = atomic_load_explicit(&metrics_slots, memory_order_relaxed);
+  do {
+    slot->next = expected;
+  } while (!atomic_compare_exchange_weak_explicit(&metrics_slots, &expected, slot,
+                                                  memory_order_release, memory_order_relaxed));
+  local_metrics = slot;
+  return slot;
+}
+
+__forceinline void metrics_account(IrisMetricsSlot* local, unsigned int kind, size_t bytes) {
+  size_t live = atomic_fetch_add_explicit(&metrics_live_bytes, bytes, memory_order_relaxed) + bytes;
+  metrics_add(local->kind_live_bytes[kind], bytes);
+  metrics_add(local->kind_total_bytes[kind], bytes);
+  size_t peak = atomic_load_explicit(&metrics_peak_bytes, memory_order_relaxed);
+  while ((live > peak) && !atomic_compare_exchange_weak_explicit(&metrics_peak_bytes, &peak, live,
+                                                                memory_order_relaxed, memory_order_relaxed)) {
+  }
+}
+
+__forceinline void metrics_unaccount(IrisMetricsSlot* local, unsigned int kind, size_t bytes) {
+  size_t live = atomic_fetch_sub_explicit(&metrics_live_bytes, bytes, memory_order_relaxed);
+  assert(live >= bytes);
+  (void)live;
+  metrics_sub(local->kind_live_bytes[kind], bytes);
+}
+
+void* iris_metered_alloc(size_t bytes, unsigned int kind, const char* file, int line) {
+  assert(kind < N_OBJECT_KINDS);
+  if (bytes == 0ULL) {
+    return NULL;
+  }
+  #ifdef IRIS_PROFILE_ALLOCATION_SITES
+  iris_profile_record(file, line, bytes);
+  #else
+  (void)file;
+  (void)line;
+  #endif
+  IrisMeteredHeader* header = (IrisMeteredHeader*)IRIS_ALLOC(METERED_HEADER_SIZE + bytes);
+  header->size = bytes;
+  header->kind = kind;
+  IrisMetricsSlot* local = metrics_local_slot();
+  metrics_add(local->allocations, 1U);
+  metrics_add(local->kind_allocations[kind], 1U);
+  metrics_add(local->histogram[metrics_histogram_bucket(bytes)], 1U);
+  metrics_account(local, kind, METERED_HEADER_SIZE + bytes);
+  return (unsigned char*)header + METERED_HEADER_SIZE;
+}
+
+void* iris_metered_resize(void* mem, size_t bytes, unsigned int kind, const char* file, int line) {
+  if (mem == NULL) {
+    return iris_metered_alloc(bytes, kind, file, line);
+  } else if (bytes == 0ULL) {
+    iris_metered_free(mem);
+    return NULL;
+  }
+  IrisMeteredHeader* header = metered_header_of(mem);
+  size_t old_size = header->size;
+  #ifdef IRIS_PROFILE_ALLOCATION_SITES
+  iris_profile_record(file, line, (bytes > old_size) ? (bytes - old_size) : 0ULL);
+  #else
+  (void)file;
+  (void)line;
+  #endif
+  kind = header->kind;
+  header = (IrisMeteredHeader*)IRIS_RESIZE(header, METERED_HEADER_SIZE + bytes);
+  header->size = bytes;
+  IrisMetricsSlot* local = metrics_local_slot();
+  metrics_add(local->resizes, 1U);
+  metrics_unaccount(local, kind, old_size);
+  metrics_account(local, kind, bytes);
+  // only growth is counted as allocated bytes
+  metrics_sub(local->kind_total_bytes[kind], (bytes > old_size) ? old_size : bytes);
+  return (unsigned char*)header + METERED_HEADER_SIZE;
+}
+
+void iris_metered_free(void* mem) {
+  assert(pointer_is_valid(mem));
+  IrisMeteredHeader* header = metered_header_of(mem);
+  IrisMetricsSlot* local = metrics_local_slot();
+  metrics_add(local->frees, 1U);
+  metrics_unaccount(local, header->kind, METERED_HEADER_SIZE + header->size);
+  IRIS_FREE(header);
+}
+
+void iris_metrics_retag(void* mem, unsigned int kind) {
+  assert(kind < N_OBJECT_KINDS);
+  if (mem == NULL) {
+    return;
+  }
+  IrisMeteredHeader* header = metered_header_of(mem);
+  size_t bytes = METERED_HEADER_SIZE + header->size;
+  IrisMetricsSlot* local = metrics_local_slot();
+  metrics_unaccount(local, header->kind, bytes);
+  metrics_sub(local->kind_total_bytes[header->kind], bytes);
+  metrics_sub(local->kind_allocations[header->kind], 1U);
+  header->kind = kind;
+  metrics_account(local, kind, bytes);
+  metrics_add(local->kind_allocations[kind], 1U);
+}
+#endif
+
+void iris_metrics_thread_release(void) {
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  if (local_metrics != NULL) {
+    atomic_store_explicit(&local_metrics->taken, false, memory_order_release);
+    local_metrics = NULL;
+  }
+  #endif
+}
+
+bool iris_metrics_snapshot(IrisMemoryMetrics* snapshot) {
+  assert(pointer_is_valid(snapshot));
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  // counters of different threads aren't read at the same instant, so snapshot taken during allocations is approximate
+  memset(snapshot, 0, sizeof(IrisMemoryMetrics));
+  IrisMetricsSlot* slot = atomic_load_explicit(&metrics_slots, memory_order_acquire);
+  for (; slot != NULL; slot = slot->next) {
+    snapshot->allocations += metrics_load(slot->allocations);
+    snapshot->frees += metrics_load(slot->frees);
+    snapshot->resizes += metrics_load(slot->resizes);
+    for (unsigned int bucket = 0U; bucket < IRIS_METRICS_HISTOGRAM_BUCKETS; bucket++) {
+      snapshot->histogram[bucket] += metrics_load(slot->histogram[bucket]);
+    }
+    for (unsigned int kind = 0U; kind < IRIS_METRICS_KINDS; kind++) {
+      snapshot->kind_allocations[kind] += metrics_load(slot->kind_allocations[kind]);
+      snapshot->kind_live_bytes[kind] += metrics_load(slot->kind_live_bytes[kind]);
+      snapshot->kind_total_bytes[kind] += metrics_load(slot->kind_total_bytes[kind]);
+    }
+  }
+  snapshot->live_bytes = atomic_load_explicit(&metrics_live_bytes, memory_order_relaxed);
+  snapshot->peak_bytes = atomic_load_explicit(&metrics_peak_bytes, memory_order_relaxed);
+  return true;
+  #else
+  memset(snapshot, 0, sizeof(IrisMemoryMetrics));
+  return false;
+  #endif
+}
+
+static const char* metrics_kind_names[N_OBJECT_KINDS] = {
+  [irisObjectKindNone] = "other",
+  [irisObjectKindError] = "error",
+  [irisObjectKindRefCell] = "refcell",
+  [irisObjectKindFunc] = "func",
+  [irisObjectKindInt] = "int",
+  [irisObjectKindFloat] = "float",
+  [irisObjectKindString] = "string",
+  [irisObjectKindSymbol] = "symbol",
+  [irisObjectKindList] = "list",
+  [irisObjectKindDict] = "dict",
+  [irisObjectKindVector] = "vector",
+  [irisObjectKindMap] = "map",
+};
+
+const char* iris_metrics_kind_name(unsigned int kind) {
+  assert(kind < N_OBJECT_KINDS);
+  return metrics_kind_names[kind];
+}
+
 void iris_metrics_print_repr() {
   #ifdef IRIS_COLLECT_MEMORY_METRICS
+  IrisMemoryMetrics snapshot;
+  (void)iris_metrics_snapshot(&snapshot);
   (void)fputs("--- memory metrics:\n", stdout);
-  (void)fprintf(stdout, "allocations: %llu\n", n_allocations);
-  (void)fprintf(stdout, "deallocations: %llu, diff: %lld\n", n_frees, (long long int)n_allocations - (long long int)n_frees);
-  (void)fprintf(stdout, "resizes: %llu\n", n_resizes);
+  (void)fprintf(stdout, "allocations: %llu\n", (unsigned long long)snapshot.allocations);
+  (void)fprintf(stdout, "deallocations: %llu, diff: %lld\n", (unsigned long long)snapshot.frees,
+    (long long int)snapshot.allocations - (long long int)snapshot.frees);
+  (void)fprintf(stdout, "resizes: %llu\n", (unsigned long long)snapshot.resizes);
+  (void)fprintf(stdout, "live bytes: %llu, peak bytes: %llu\n", (unsigned long long)snapshot.live_bytes, (unsigned long long)snapshot.peak_bytes);
+  (void)fputs("by kind (allocations, total bytes, live bytes):\n", stdout);
+  for (unsigned int kind = 0U; kind < N_OBJECT_KINDS; kind++) {
+    if (snapshot.kind_allocations[kind] != 0ULL) {
+      (void)fprintf(stdout, "  %s: %llu, %llu, %llu\n", metrics_kind_names[kind],
+        (unsigned long long)snapshot.kind_allocations[kind],
+        (unsigned long long)snapshot.kind_total_bytes[kind],
+        (unsigned long long)snapshot.kind_live_bytes[kind]);
+    }
+  }
+  (void)fputs("sizes (up to bytes: allocations):\n", stdout);
+  for (unsigned int bucket = 0U; bucket < IRIS_METRICS_HISTOGRAM_BUCKETS; bucket++) {
+    if (snapshot.histogram[bucket] != 0ULL) {
+      (void)fprintf(stdout, "  %llu: %llu\n", 1ULL << bucket, (unsigned long long)snapshot.histogram[bucket]);
+    }
+  }
+  #ifdef IRIS_USE_ARENA
+  iris_arena_metrics_print_repr();
+  #endif
+  #ifdef IRIS_USE_POOL
+  iris_pool_metrics_print_repr();
+  #endif
   #else
   (void)fputs("--- memory metrics: no data was collected as collection was turned off on compilation, pass -DIRIS_COLLECT_MEMORY_METRICS to enable\n", stdout);
   fflush(stdout);
@@ -1,6 +1,7 @@
 #ifndef IRIS_MEMORY_H
 #define IRIS_MEMORY_H
 
+#include <stddef.h>
 #include <stdbool.h>
 
 typedef enum {
@@ -15,14 +16,90 @@ IrisPointerStatus pointer_status(const void* p);
 void* iris_standard_alloc(size_t bytes);
 void* iris_standard_resize(void* mem, size_t bytes);
 void  iris_standard_free(void* mem);
-// zero alloc that uses IRIS_ALLOC
-void* iris_alloc0_untyped(size_t size);
+// zero alloc that uses IRIS_ALLOC, kind is IrisObjectKind to which allocation is attributed in metrics
+void* iris_alloc0_untyped(size_t size, unsigned int kind, const char* file, int line);
 void iris_metrics_print_repr(void);
 
+#define IRIS_METRICS_HISTOGRAM_BUCKETS 24U // bucket n counts allocations of (2^(n-1), 2^n] bytes, last one takes the rest
+#define IRIS_METRICS_KINDS 16U             // should be enough for every IrisObjectKind
+
+typedef struct {
+  size_t allocations;
+  size_t frees;
+  size_t resizes;
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t histogram[IRIS_METRICS_HISTOGRAM_BUCKETS];
+  size_t kind_allocations[IRIS_METRICS_KINDS];
+  size_t kind_live_bytes[IRIS_METRICS_KINDS];
+  size_t kind_total_bytes[IRIS_METRICS_KINDS];
+} IrisMemoryMetrics;
+
+/*
+  @brief  Copy current state of memory metrics
+  @return False if metrics aren't collected in this build
+*/
+bool iris_metrics_snapshot(IrisMemoryMetrics*);
+
+/*
+  @brief  Name by which object kind is referred in metrics, "other" for irisObjectKindNone
+*/
+const char* iris_metrics_kind_name(unsigned int kind);
+
+/*
+  @brief  Hand counting slot of calling thread to the next thread that allocates, should be called before thread exits
+*/
+void iris_metrics_thread_release(void);
+
+#if defined(IRIS_PROFILE_ALLOCATION_SITES) && !defined(IRIS_COLLECT_MEMORY_METRICS)
+  #error "IRIS_PROFILE_ALLOCATION_SITES requires IRIS_COLLECT_MEMORY_METRICS"
+#endif
+
+// call site that is passed to metered allocations, see iris_profile.h
+#ifdef IRIS_PROFILE_ALLOCATION_SITES
+  #define IRIS_ALLOCATION_SITE __FILE__, __LINE__
+#else
+  #define IRIS_ALLOCATION_SITE NULL, 0
+#endif
+
+#ifdef IRIS_COLLECT_MEMORY_METRICS
+// every allocation is prefixed with header that is used for tracking of sizes and kinds
+void* iris_metered_alloc(size_t bytes, unsigned int kind, const char* file, int line);
+void* iris_metered_resize(void* mem, size_t bytes, unsigned int kind, const char* file, int line);
+void  iris_metered_free(void* mem);
+
+/*
+  @brief  Attribute already existing allocation to other object kind
+          Used when memory is allocated by one type, but owned by other, for example messages of errors
+*/
+void  iris_metrics_retag(void* mem, unsigned int kind);
+#endif
+
+// heap that is used by default and as fallback for arenas
+#ifdef IRIS_USE_POOL
+  // small blocks are recycled by size classes, see iris_pool.h
+  #include "iris_pool.h"
+  #define IRIS_HEAP_ALLOC(size) iris_pool_alloc(size)
+  #define IRIS_HEAP_RESIZE(ptr, size) iris_pool_resize(ptr, size)
+  #define IRIS_HEAP_FREE(ptr) iris_pool_free(ptr)
+#else
+  #define IRIS_HEAP_ALLOC(size) iris_standard_alloc(size)
+  #define IRIS_HEAP_RESIZE(ptr, size) iris_standard_resize(ptr, size)
+  #define IRIS_HEAP_FREE(ptr) iris_standard_free(ptr)
+#endif
+
 #ifndef IRIS_ALLOC
-  #define IRIS_ALLOC(size) iris_standard_alloc(size)
-  #define IRIS_RESIZE(ptr, size) iris_standard_resize(ptr, size)
-  #define IRIS_FREE(ptr) iris_standard_free(ptr)
+  #ifdef IRIS_USE_ARENA
+    // allocations are bumped from arena that is bound to calling thread, see iris_arena.h
+    #include "iris_arena.h"
+    #define IRIS_ALLOC(size) iris_arena_alloc(size)
+    #define IRIS_RESIZE(ptr, size) iris_arena_resize(ptr, size)
+    #define IRIS_FREE(ptr) iris_arena_free(ptr)
+  #else
+    #define IRIS_ALLOC(size) IRIS_HEAP_ALLOC(size)
+    #define IRIS_RESIZE(ptr, size) IRIS_HEAP_RESIZE(ptr, size)
+    #define IRIS_FREE(ptr) IRIS_HEAP_FREE(ptr)
+  #endif
 #else
   #ifndef IRIS_RESIZE
     #error "no memory resize implementation"
@@ -33,9 +110,22 @@ void iris_metrics_print_repr(void);
 #endif
 
 // todo: macroses are evil, maybe should make something else
-#define iris_alloc(size, type) (type*)IRIS_ALLOC((size) * sizeof(type))
-#define iris_alloc0(size, type) (type*)iris_alloc0_untyped((size) * sizeof(type))
-#define iris_resize(ptr, size, type) (type*)IRIS_RESIZE(ptr, (size) * sizeof(type))
-#define iris_free(ptr) IRIS_FREE(ptr)
+#ifdef IRIS_COLLECT_MEMORY_METRICS
+  #define iris_alloc_kind(size, type, kind) (type*)iris_metered_alloc((size) * sizeof(type), kind, IRIS_ALLOCATION_SITE)
+  #define iris_resize_kind(ptr, size, type, kind) (type*)iris_metered_resize(ptr, (size) * sizeof(type), kind, IRIS_ALLOCATION_SITE)
+  #define iris_free(ptr) iris_metered_free(ptr)
+  #define iris_retag(ptr, kind) iris_metrics_retag(ptr, kind)
+#else
+  #define iris_alloc_kind(size, type, kind) (type*)((void)(kind), IRIS_ALLOC((size) * sizeof(type)))
+  #define iris_resize_kind(ptr, size, type, kind) (type*)((void)(kind), IRIS_RESIZE(ptr, (size) * sizeof(type)))
+  #define iris_free(ptr) IRIS_FREE(ptr)
+  #define iris_retag(ptr, kind)
+#endif
+#define iris_alloc0_kind(size, type, kind) (type*)iris_alloc0_untyped((size) * sizeof(type), kind, IRIS_ALLOCATION_SITE)
+
+// untagged allocations are attributed to irisObjectKindNone
+#define iris_alloc(size, type) iris_alloc_kind(size, type, 0U)
+#define iris_alloc0(size, type) iris_alloc0_kind(size, type, 0U)
+#define iris_resize(ptr, size, type) iris_resize_kind(ptr, size, type, 0U)
 
 #endif
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "iris_os.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include "windows.h"
+  #include <io.h>
+#elif defined(__unix__) || defined(__APPLE__)
+  #define IRIS_OS_POSIX
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <errno.h>
+#endif
+
+#define OS_READ_PREALLOC (64ULL * 1024ULL)
+
+/*
+  @brief  Read stream whole into heap buffer, used when size isn't known or mapping isn't possible
+*/
+static bool os_file_read_whole(FILE* file, IrisMappedFile* result) {
+  size_t cap = OS_READ_PREALLOC;
+  size_t len = 0ULL;
+  char* buffer = iris_alloc(cap, char);
+  for (;;) {
+    len += fread(buffer + len, sizeof(char), cap - len, file);
+    if (len < cap) {
+      break;
+    }
+    cap *= 2ULL;
+    buffer = iris_resize(buffer, cap, char);
+  }
+  if (ferror(file)) {
+    iris_free(buffer);
+    return false;
+  }
+  if (len == 0ULL) {
+    iris_free(buffer);
+    *result = (IrisMappedFile){ .kind = irisMappingNone };
+    return true;
+  }
+  *result = (IrisMappedFile){ .data = buffer, .len = len, .kind = irisMappingBuffer };
+  return true;
+}
+
+static bool os_file_read_fallback(const char* path, IrisMappedFile* result) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  bool status = os_file_read_whole(file, result);
+  fclose(file);
+  return status;
+}
+
+bool os_file_map(const char* path, IrisMappedFile* result) {
+  assert(pointer_is_valid(path));
+  assert(pointer_is_valid(result));
+  #if defined(IRIS_OS_POSIX)
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat info;
+  if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode)) {
+    // pipes and devices cannot be mapped and don't report size
+    close(fd);
+    return os_file_read_fallback(path, result);
+  }
+  if (info.st_size == 0) {
+    close(fd);
+    *result = (IrisMappedFile){ .kind = irisMappingNone };
+    return true;
+  }
+  void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // mapping holds its own reference
+  if (view == MAP_FAILED) {
+    return os_file_read_fallback(path, result);
+  }
+  #ifdef MADV_SEQUENTIAL
+  (void)madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+  #endif
+  *result = (IrisMappedFile){ .data = (const char*)view, .len = (size_t)info.st_size, .kind = irisMappingMapped };
+  return true;
+  #elif defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if ((GetFileSizeEx(file, &size) == 0) || (GetFileType(file) != FILE_TYPE_DISK)) {
+    CloseHandle(file);
+    return os_file_read_fallback(path, result);
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    *result = (IrisMappedFile){ .kind = irisMappingNone };
+    return true;
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file); // mapping holds its own reference
+  if (mapping == NULL) {
+    return os_file_read_fallback(path, result);
+  }
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    return os_file_read_fallback(path, result);
+  }
+  *result = (IrisMappedFile){ .data = (const char*)view, .len = (size_t)size.QuadPart, .kind = irisMappingMapped, .handle = mapping };
+  return true;
+  #else
+  return os_file_read_fallback(path, result);
+  #endif
+}
+
+void os_file_unmap(IrisMappedFile* file) {
+  assert(pointer_is_valid(file));
+  switch (file->kind) {
+    case irisMappingNone: break;
+    case irisMappingBuffer:
+      iris_free((void*)file->data);
+      break;
+    case irisMappingMapped:
+      #if defined(IRIS_OS_POSIX)
+      if (munmap((void*)file->data, file->len) != 0) { errno_panic(); }
+      #elif defined(_WIN32)
+      UnmapViewOfFile(file->data);
+      CloseHandle((HANDLE)file->handle);
+      #else
+      panic("mapping isn't supported on this platform");
+      #endif
+      break;
+    default:
+      panic("unknown file mapping kind");
+  }
+  *file = (IrisMappedFile){ .kind = irisMappingNone };
+}
+
+ptrdiff_t os_fd_read(int fd, char* buffer, size_t len) {
+  assert(pointer_is_valid(buffer));
+  #if defined(IRIS_OS_POSIX)
+  for (;;) {
+    ssize_t result = read(fd, buffer, len);
+    if ((result != -1) || (errno != EINTR)) {
+      return (ptrdiff_t)result;
+    }
+  }
+  #elif defined(_WIN32)
+  // _read takes unsigned int count
+  return (ptrdiff_t)_read(fd, buffer, (len > (size_t)INT_MAX) ? (unsigned int)INT_MAX : (unsigned int)len);
+  #else
+  // without descriptors there's only stdin, which is read line by line
+  (void)fd;
+  if (fgets(buffer, (len > (size_t)INT_MAX) ? INT_MAX : (int)len, stdin) == NULL) {
+    return ferror(stdin) ? -1 : 0;
+  }
+  return (ptrdiff_t)strlen(buffer);
+  #endif
+}
@@ -0,0 +1,39 @@
+#ifndef IRIS_OS_H
+#define IRIS_OS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Platform specific facilities, everything that requires system headers should go through here
+
+typedef enum {
+  irisMappingNone,    // file is empty, there's nothing to release
+  irisMappingMapped,  // view is mapped into address space
+  irisMappingBuffer,  // mapping isn't possible, file is read whole into heap buffer
+} IrisMappingKind;
+
+typedef struct {
+  // Read-only view of file contents, valid until os_file_unmap
+  const char* data;
+  size_t len;
+  IrisMappingKind kind;
+  void* handle; // platform specific
+} IrisMappedFile;
+
+/*
+  @brief  Map whole file for reading, falls back to reading it in one go if mapping isn't supported
+  @return False if file cannot be opened or read
+*/
+bool os_file_map(const char* path, IrisMappedFile* result);
+
+void os_file_unmap(IrisMappedFile*);
+
+#define OS_STDIN_FD 0
+
+/*
+  @brief  Read whatever is available from file descriptor, blocks only if nothing is
+  @return Number of bytes read, 0 on end of file or -1 on error, errno is set then
+*/
+ptrdiff_t os_fd_read(int fd, char* buffer, size_t len);
+
+#endif
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#include "iris_pool.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+// todo: slabs are never returned to system before shutdown, fully free slabs could be reclaimed
+// todo: size classes could be tuned by collected metrics
+
+#define POOL_SLAB_SIZE (32ULL * 1024ULL)
+#define POOL_LARGE UINT32_MAX
+
+static const uint32_t pool_class_sizes[] = {
+  8U, 16U, 24U, 32U, 48U, 64U, 96U, 128U, 192U, 256U, 384U, 512U
+};
+
+#define POOL_N_CLASSES (sizeof(pool_class_sizes) / sizeof(pool_class_sizes[0]))
+#define POOL_MAX_CLASS_SIZE 512U
+
+typedef struct {
+  // stored right before every block
+  uint32_t size_class; // index in pool_class_sizes or POOL_LARGE
+  uint32_t requested;  // bytes requested by user, used for measuring internal fragmentation
+} IrisPoolHeader;
+
+// blocks are aligned like heap blocks, header is placed in the end of padding before them
+#define POOL_ALIGNMENT _Alignof(max_align_t)
+
+static_assert(sizeof(IrisPoolHeader) <= POOL_ALIGNMENT, "pool header should fit in alignment padding");
+
+typedef struct _IrisPoolNode {
+  // free block reuses its own memory as list node
+  struct _IrisPoolNode* next;
+} IrisPoolNode;
+
+typedef struct _IrisPoolSlab {
+  struct _IrisPoolSlab* next;
+} IrisPoolSlab;
+
+#define pool_header_of(mem) ((IrisPoolHeader*)((unsigned char*)(mem) - sizeof(IrisPoolHeader)))
+// slot stride is rounded up, so that every block in slab starts at the same alignment as the first one
+#define pool_slot_size(class) \
+  ((sizeof(IrisPoolHeader) + pool_class_sizes[class] + POOL_ALIGNMENT - 1U) & ~(POOL_ALIGNMENT - 1U))
+#define pool_large_base(mem) ((unsigned char*)(mem) - POOL_ALIGNMENT)
+
+static _Thread_local IrisPoolNode* local_free_lists[POOL_N_CLASSES];
+static _Thread_local unsigned char* local_carve_ptr[POOL_N_CLASSES];
+static _Thread_local unsigned char* local_carve_end[POOL_N_CLASSES];
+
+static _Atomic(IrisPoolNode*) global_free_lists[POOL_N_CLASSES];
+static _Atomic(IrisPoolSlab*) slabs;
+
+#ifdef IRIS_COLLECT_MEMORY_METRICS
+static atomic_size_t n_pool_allocations[POOL_N_CLASSES];
+static atomic_size_t n_pool_hits[POOL_N_CLASSES];   // served from free lists
+static atomic_size_t n_pool_frees[POOL_N_CLASSES];
+static atomic_size_t n_pool_large_allocations;
+static atomic_size_t n_pool_slabs;
+static atomic_size_t pool_live_blocks[POOL_N_CLASSES];
+static atomic_size_t pool_live_requested_bytes;     // sum of requested sizes of live small blocks
+#define pool_metric_add(metric, n) atomic_fetch_add_explicit(&(metric), (n), memory_order_relaxed)
+#define pool_metric_sub(metric, n) atomic_fetch_sub_explicit(&(metric), (n), memory_order_relaxed)
+#else
+#define pool_metric_add(metric, n)
+#define pool_metric_sub(metric, n)
+#endif
+
+__forceinline uint32_t pool_class_of(size_t bytes) {
+  for (uint32_t i = 0U; i < POOL_N_CLASSES; i++) {
+    if (bytes <= pool_class_sizes[i]) {
+      return i;
+    }
+  }
+  return POOL_LARGE;
+}
+
+/*
+  @brief  Push chain of nodes to global stack
+          Only pushes and whole-list takes are done on global stacks, so there's no ABA problem
+*/
+static void pool_global_push_chain(uint32_t class, IrisPoolNode* head, IrisPoolNode* tail) {
+  IrisPoolNode* expected = atomic_load_explicit(&global_free_lists[class], memory_order_relaxed);
+  do {
+    tail->next = expected;
+  } while (!atomic_compare_exchange_weak_explicit(&global_free_lists[class], &expected, head,
+                                                  memory_order_release, memory_order_relaxed));
+}
+
+static void pool_new_slab(uint32_t class) {
+  IrisPoolSlab* slab = (IrisPoolSlab*)iris_standard_alloc(POOL_SLAB_SIZE);
+  IrisPoolSlab* expected = atomic_load_explicit(&slabs, memory_order_relaxed);
+  do {
+    slab->next = expected;
+  } while (!atomic_compare_exchange_weak_explicit(&slabs, &expected, slab,
+                                                  memory_order_release, memory_order_relaxed));
+  // slab header is padded, so that block of first slot is aligned as heap blocks are
+  local_carve_ptr[class] = (unsigned char*)slab + POOL_ALIGNMENT - sizeof(IrisPoolHeader);
+  local_carve_end[class] = (unsigned char*)slab + POOL_SLAB_SIZE;
+  pool_metric_add(n_pool_slabs, 1U);
+}
+
+static IrisPoolHeader* pool_take_slot(uint32_t class) {
+  IrisPoolNode* node = local_free_lists[class];
+  if (node == NULL) {
+    // adopt blocks that were released by exited threads
+    node = atomic_exchange_explicit(&global_free_lists[class], NULL, memory_order_acquire);
+  }
+  if (node != NULL) {
+    local_free_lists[class] = node->next;
+    pool_metric_add(n_pool_hits[class], 1U);
+    return pool_header_of(node);
+  }
+  if ((local_carve_ptr[class] == NULL) ||
+      ((size_t)(local_carve_end[class] - local_carve_ptr[class]) < pool_slot_size(class))) {
+    pool_new_slab(class);
+  }
+  IrisPoolHeader* header = (IrisPoolHeader*)local_carve_ptr[class];
+  local_carve_ptr[class] += pool_slot_size(class);
+  return header;
+}
+
+void* iris_pool_alloc(size_t bytes) {
+  if (bytes == 0ULL) {
+    return NULL;
+  }
+  uint32_t class = pool_class_of(bytes);
+  IrisPoolHeader* header;
+  if (class == POOL_LARGE) {
+    unsigned char* base = (unsigned char*)iris_standard_alloc(POOL_ALIGNMENT + bytes);
+    header = (IrisPoolHeader*)(base + POOL_ALIGNMENT - sizeof(IrisPoolHeader));
+    header->requested = 0U;
+    pool_metric_add(n_pool_large_allocations, 1U);
+  } else {
+    header = pool_take_slot(class);
+    header->requested = (uint32_t)bytes;
+    pool_metric_add(n_pool_allocations[class], 1U);
+    pool_metric_add(pool_live_blocks[class], 1U);
+    pool_metric_add(pool_live_requested_bytes, bytes);
+  }
+  header->size_class = class;
+  return (unsigned char*)header + sizeof(IrisPoolHeader);
+}
+
+void iris_pool_free(void* mem) {
+  assert(pointer_is_valid(mem));
+  IrisPoolHeader* header = pool_header_of(mem);
+  if (header->size_class == POOL_LARGE) {
+    iris_standard_free(pool_large_base(mem));
+    return;
+  }
+  uint32_t class = header->size_class;
+  assert(class < POOL_N_CLASSES);
+  pool_metric_add(n_pool_frees[class], 1U);
+  pool_metric_sub(pool_live_blocks[class], 1U);
+  pool_metric_sub(pool_live_requested_bytes, header->requested);
+  IrisPoolNode* node = (IrisPoolNode*)mem;
+  node->next = local_free_lists[class];
+  local_free_lists[class] = node;
+}
+
+void* iris_pool_resize(void* mem, size_t bytes) {
+  if (mem == NULL) {
+    return iris_pool_alloc(bytes);
+  } else if (bytes == 0ULL) {
+    iris_pool_free(mem);
+    return NULL;
+  }
+  IrisPoolHeader* header = pool_header_of(mem);
+  if (header->size_class == POOL_LARGE) {
+    if (bytes > POOL_MAX_CLASS_SIZE) {
+      unsigned char* base = (unsigned char*)iris_standard_resize(pool_large_base(mem), POOL_ALIGNMENT + bytes);
+      return base + POOL_ALIGNMENT;
+    }
+  } else if (bytes <= pool_class_sizes[header->size_class]) {
+    // block still fits in its slot
+    pool_metric_sub(pool_live_requested_bytes, header->requested);
+    pool_metric_add(pool_live_requested_bytes, bytes);
+    header->requested = (uint32_t)bytes;
+    return mem;
+  }
+  // large blocks are always bigger than any size class
+  size_t old_size = (header->size_class == POOL_LARGE) ? bytes : header->requested;
+  void* resized = iris_pool_alloc(bytes);
+  memcpy(resized, mem, (old_size < bytes) ? old_size : bytes);
+  iris_pool_free(mem);
+  return resized;
+}
+
+void iris_pool_thread_release(void) {
+  for (uint32_t class = 0U; class < POOL_N_CLASSES; class++) {
+    IrisPoolNode* head = local_free_lists[class];
+    if (head == NULL) {
+      continue;
+    }
+    IrisPoolNode* tail = head;
+    while (tail->next != NULL) {
+      tail = tail->next;
+    }
+    pool_global_push_chain(class, head, tail);
+    local_free_lists[class] = NULL;
+  }
+}
+
+void iris_pool_deinit(void) {
+  IrisPoolSlab* slab = atomic_exchange(&slabs, NULL);
+  while (slab != NULL) {
+    IrisPoolSlab* next = slab->next;
+    iris_standard_free(slab);
+    slab = next;
+  }
+  for (uint32_t class = 0U; class < POOL_N_CLASSES; class++) {
+    atomic_store(&global_free_lists[class], NULL);
+    local_free_lists[class] = NULL;
+    local_carve_ptr[class] = NULL;
+    local_carve_end[class] = NULL;
+  }
+}
+
+void iris_pool_metrics_print_repr(void) {
+  #ifdef IRIS_COLLECT_MEMORY_METRICS
+  size_t total_allocations = 0ULL;
+  size_t total_hits = 0ULL;
+  size_t live_slot_bytes = 0ULL;
+  (void)fputs("pool classes (size: allocations, hit rate, frees, live):\n", stdout);
+  for (uint32_t class = 0U; class < POOL_N_CLASSES; class++) {
+    size_t allocations = atomic_load(&n_pool_allocations[class]);
+    size_t hits = atomic_load(&n_pool_hits[class]);
+    size_t live = atomic_load(&pool_live_blocks[class]);
+    total_allocations += allocations;
+    total_hits += hits;
+    live_slot_bytes += live * pool_class_sizes[class];
+    if (allocations == 0ULL) {
+      continue;
+    }
+    (void)fprintf(stdout, "  %u: %llu, %.1f%%, %llu, %llu\n", pool_class_sizes[class],
+      (unsigned long long)allocations, 100.0 * (double)hits / (double)allocations,
+      (unsigned long long)atomic_load(&n_pool_frees[class]), (unsigned long long)live);
+  }
+  size_t slab_bytes = atomic_load(&n_pool_slabs) * POOL_SLAB_SIZE;
+  size_t live_requested = atomic_load(&pool_live_requested_bytes);
+  (void)fprintf(stdout, "pool allocations: %llu, hit rate: %.1f%%, large allocations: %llu\n",
+    (unsigned long long)total_allocations,
+    (total_allocations != 0ULL) ? (100.0 * (double)total_hits / (double)total_allocations) : 0.0,
+    (unsigned long long)atomic_load(&n_pool_large_allocations));
+  (void)fprintf(stdout, "pool slabs: %llu, bytes: %llu, internal fragmentation: %llu bytes, external fragmentation: %llu bytes\n",
+    (unsigned long long)atomic_load(&n_pool_slabs), (unsigned long long)slab_bytes,
+    (unsigned long long)(live_slot_bytes - live_requested),
+    (unsigned long long)(slab_bytes - live_slot_bytes));
+  #endif
+}
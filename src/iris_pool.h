@@ -0,0 +1,29 @@
+#ifndef IRIS_POOL_H
+#define IRIS_POOL_H
+
+#include <stddef.h>
+
+// Size-class pool allocator for small blocks
+// Blocks are carved from slabs and recycled through per-thread free lists, so hot paths don't need any locking
+// Blocks freed by other threads are just adopted by them, lists of exited threads are passed to global lock-free stacks
+// Blocks that are bigger than the biggest size class go directly to heap
+
+void* iris_pool_alloc(size_t bytes);
+void* iris_pool_resize(void* mem, size_t bytes);
+void  iris_pool_free(void* mem);
+
+/*
+  @brief  Pass free lists of calling thread to global ones, so other threads could reuse them
+  @warn   Should be called by every thread that allocated from pool before its exit
+*/
+void iris_pool_thread_release(void);
+
+/*
+  @brief  Release all slabs back to system
+  @warn   Every block allocated from pool is dangling after that, should be called only on shutdown
+*/
+void iris_pool_deinit(void);
+
+void iris_pool_metrics_print_repr(void);
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "iris_profile.h"
+#include "iris_memory.h"
+#include "iris_utils.h"
+
+#ifdef IRIS_PROFILE_ALLOCATION_SITES
+
+// todo: it's possible to capture return addresses instead of zones, but symbolization isn't portable
+
+// profiler memory is taken directly from malloc, so it doesn't spoil profiled data
+#define PROFILE_SITES_PREALLOC 256ULL
+
+typedef struct {
+  const char* frames[IRIS_PROFILE_ZONE_LIMIT];
+  unsigned int depth;
+  const char* file;
+  int line;
+  size_t count;
+  size_t bytes;
+  size_t hash; // 0 marks empty slot
+} IrisProfileSite;
+
+static _Thread_local const char* zone_stack[IRIS_PROFILE_ZONE_LIMIT];
+static _Thread_local unsigned int zone_depth = 0U;
+
+static pthread_mutex_t sites_lock = PTHREAD_MUTEX_INITIALIZER;
+static IrisProfileSite* sites = NULL;
+static size_t sites_cap = 0ULL;
+static size_t sites_card = 0ULL;
+
+IrisProfileZone iris_profile_zone_enter(const char* name) {
+  assert(pointer_is_valid(name));
+  if ((zone_depth == IRIS_PROFILE_ZONE_LIMIT) ||
+      ((zone_depth != 0U) && (strcmp(zone_stack[zone_depth - 1U], name) == 0))) {
+    return (IrisProfileZone){ .entered = false };
+  }
+  zone_stack[zone_depth++] = name;
+  return (IrisProfileZone){ .entered = true };
+}
+
+void iris_profile_zone_leave(IrisProfileZone* zone) {
+  if (zone->entered) {
+    assert(zone_depth != 0U);
+    zone_depth--;
+  }
+}
+
+static const char* profile_basename(const char* path) {
+  const char* result = path;
+  for (const char* ptr = path; *ptr != '\0'; ptr++) {
+    if ((*ptr == '/') || (*ptr == '\\')) {
+      result = ptr + 1;
+    }
+  }
+  return result;
+}
+
+// names are hashed by content, as the same string literal might reside in different places of different units
+__forceinline size_t profile_hash_chars(size_t hash, const char* chars) {
+  for (; *chars != '\0'; chars++) {
+    hash = (hash ^ (unsigned char)*chars) * 1099511628211ULL; // FNV-1a
+  }
+  return hash;
+}
+
+static size_t profile_site_hash(const char* file, int line) {
+  size_t hash = 14695981039346656037ULL;
+  for (unsigned int i = 0U; i < zone_depth; i++) {
+    hash = profile_hash_chars(hash, zone_stack[i]);
+    hash = (hash ^ ';') * 1099511628211ULL;
+  }
+  hash = profile_hash_chars(hash, file);
+  hash = (hash ^ (size_t)line) * 1099511628211ULL;
+  return (hash == 0ULL) ? 1ULL : hash;
+}
+
+static bool profile_site_matches(const IrisProfileSite* site, size_t hash, const char* file, int line) {
+  if ((site->hash != hash) || (site->line != line) || (site->depth != zone_depth) || (strcmp(site->file, file) != 0)) {
+    return false;
+  }
+  for (unsigned int i = 0U; i < zone_depth; i++) {
+    if (strcmp(site->frames[i], zone_stack[i]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void profile_sites_grow(void) {
+  size_t new_cap = (sites_cap == 0ULL) ? PROFILE_SITES_PREALLOC : (sites_cap << 1ULL);
+  IrisProfileSite* new_sites = calloc(new_cap, sizeof(IrisProfileSite));
+  if (new_sites == NULL) { errno_panic(); }
+  for (size_t i = 0ULL; i < sites_cap; i++) {
+    if (sites[i].hash != 0ULL) {
+      size_t idx = sites[i].hash & (new_cap - 1ULL);
+      while (new_sites[idx].hash != 0ULL) {
+        idx = (idx + 1ULL) & (new_cap - 1ULL);
+      }
+      new_sites[idx] = sites[i];
+    }
+  }
+  free(sites);
+  sites = new_sites;
+  sites_cap = new_cap;
+}
+
+void iris_profile_record(const char* file, int line, size_t bytes) {
+  assert(pointer_is_valid(file));
+  file = profile_basename(file);
+  size_t hash = profile_site_hash(file, line);
+  pthread_mutex_lock(&sites_lock);
+  if ((sites_card + 1ULL) * 2ULL > sites_cap) {
+    profile_sites_grow();
+  }
+  size_t idx = hash & (sites_cap - 1ULL);
+  while ((sites[idx].hash != 0ULL) && !profile_site_matches(&sites[idx], hash, file, line)) {
+    idx = (idx + 1ULL) & (sites_cap - 1ULL);
+  }
+  IrisProfileSite* site = &sites[idx];
+  if (site->hash == 0ULL) {
+    site->hash = hash;
+    site->file = file;
+    site->line = line;
+    site->depth = zone_depth;
+    memcpy(site->frames, zone_stack, zone_depth * sizeof(const char*));
+    sites_card++;
+  }
+  site->count++;
+  site->bytes += bytes;
+  pthread_mutex_unlock(&sites_lock);
+}
+
+static void profile_write_folded(const char* suffix, bool bytes) {
+  char path[FILENAME_MAX];
+  (void)snprintf(path, sizeof(path), "%s%s", IRIS_PROFILE_OUTPUT, suffix);
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    warning("cannot open file for writing allocation profile");
+    return;
+  }
+  for (size_t i = 0ULL; i < sites_cap; i++) {
+    const IrisProfileSite* site = &sites[i];
+    if (site->hash == 0ULL) {
+      continue;
+    }
+    for (unsigned int f = 0U; f < site->depth; f++) {
+      (void)fprintf(file, "%s;", site->frames[f]);
+    }
+    (void)fprintf(file, "%s:%d %llu\n", site->file, site->line,
+      (unsigned long long)(bytes ? site->bytes : site->count));
+  }
+  if (ferror(file)) { ferror_panic(file); }
+  fclose(file);
+}
+
+void iris_profile_dump(void) {
+  pthread_mutex_lock(&sites_lock);
+  profile_write_folded(".bytes.folded", true);
+  profile_write_folded(".count.folded", false);
+  (void)fprintf(stdout, "--- allocation sites: %llu written to %s.{bytes,count}.folded\n",
+    (unsigned long long)sites_card, IRIS_PROFILE_OUTPUT);
+  free(sites);
+  sites = NULL;
+  sites_cap = 0ULL;
+  sites_card = 0ULL;
+  pthread_mutex_unlock(&sites_lock);
+}
+
+#endif
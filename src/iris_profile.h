@@ -0,0 +1,50 @@
+#ifndef IRIS_PROFILE_H
+#define IRIS_PROFILE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Allocation-site profiler, enabled by IRIS_PROFILE_ALLOCATION_SITES
+// Every allocation and resize is attributed to C call site of iris_alloc/iris_resize
+// prefixed by stack of profiling zones that are entered by calling thread, for example: reader;resolve;iris_string.c:77
+// Result is written as folded stacks that could be fed directly to flamegraph.pl
+
+#ifndef IRIS_PROFILE_OUTPUT
+  #define IRIS_PROFILE_OUTPUT "iris-allocations" // .bytes.folded and .count.folded suffixes are appended
+#endif
+
+#define IRIS_PROFILE_ZONE_LIMIT 32U // zones above it are not recorded
+
+#ifdef IRIS_PROFILE_ALLOCATION_SITES
+  #ifndef __GNUC__
+    #error "allocation site profiling requires cleanup attribute support"
+  #endif
+
+typedef struct {
+  bool entered; // false if zone was collapsed with the same one above or limit was hit
+} IrisProfileZone;
+
+IrisProfileZone iris_profile_zone_enter(const char* name);
+void iris_profile_zone_leave(IrisProfileZone*);
+
+/*
+  @brief  Attribute allocation of given bytes to call site and current zone stack of thread
+*/
+void iris_profile_record(const char* file, int line, size_t bytes);
+
+/*
+  @brief  Write collected sites as folded stacks and release profiler memory
+*/
+void iris_profile_dump(void);
+
+/*
+  @brief  Marks the rest of enclosing block as profiling zone with given static name
+          Nested zones with the same name as enclosing one are collapsed, so recursion doesn't blow stacks
+*/
+  #define IRIS_PROFILE_ZONE(name) \
+    IrisProfileZone iris_profile_zone __attribute__((cleanup(iris_profile_zone_leave))) = iris_profile_zone_enter(name)
+#else
+  #define IRIS_PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -1,390 +1,932 @@
 #include <stdbool.h>
+#include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #include "iris_reader.h"
 #include "types/iris_types.h"
 #include "iris_utf8.h"
 #include "iris_utils.h"
+#include "iris_memory.h"
+#include "iris_profile.h"
+#include "iris_hash.h"
+#include "iris_os.h"
+#include "iris_pool.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #define IRIS_READER_X86
+  #include <immintrin.h> // SSE2 is part of x86-64 baseline
+#endif
 
 // todo: require spaces between in-list objects?
 //       it could be optional for easier creation of code in hosts
 //       tho possibly you should not enter code as text, but create it as lists from the start
 // todo: floats
 
+// Reader is single pass: class of the first byte of every form selects how it's read,
+// tokens are scanned to their end once, eight bytes at a time where possible
+// Nesting of lists and quotes is kept on explicit heap stack, so deep input cannot overflow C stack
+// Every delimiter is ASCII, so bytes of multi-byte UTF-8 sequences are always part of symbols
+
 typedef enum {
-  psAbort, // returned on failure without error
-  psError, // returned on error, target has error object
-  psResult // returned when target has valid object
-} ParseStatus;
-
-typedef ParseStatus (*ParseProc)(IrisObject* target, size_t* parsed, const char* slice, const char* limit);
-
-static ParseStatus parse_quote(IrisObject*, size_t*, const char*, const char*);
-static ParseStatus parse_int(IrisObject*, size_t*, const char*, const char*);
-static ParseStatus parse_atomic_symbol(IrisObject*, size_t*, const char*, const char*);
-static ParseStatus parse_marked_symbol(IrisObject*, size_t*, const char*, const char*);
-static ParseStatus parse_list(IrisObject*, size_t*, const char*, const char*);
-
-static const ParseProc parsing_procs[] = {
-  parse_quote,
-  parse_int,
-  parse_atomic_symbol,
-  parse_marked_symbol,
-  parse_list
+  // classes below lexWhitespace could be part of symbol
+  lexSymbol, // 0, so every byte that isn't listed in table is symbol byte
+  lexDigit,
+  lexMinus,
+  lexWhitespace,
+  lexComment,
+  lexListOpen,
+  lexListClose,
+  lexQuote,
+  lexString,
+  N_LEX_CLASSES
+} LexClass;
+
+static const unsigned char lex_classes[256] = {
+  ['\t'] = lexWhitespace, ['\n'] = lexWhitespace, ['\v'] = lexWhitespace,
+  ['\f'] = lexWhitespace, ['\r'] = lexWhitespace, [' '] = lexWhitespace,
+  [';'] = lexComment,
+  ['('] = lexListOpen,
+  [')'] = lexListClose,
+  ['\''] = lexQuote,
+  ['\"'] = lexString,
+  ['0'] = lexDigit, ['1'] = lexDigit, ['2'] = lexDigit, ['3'] = lexDigit, ['4'] = lexDigit,
+  ['5'] = lexDigit, ['6'] = lexDigit, ['7'] = lexDigit, ['8'] = lexDigit, ['9'] = lexDigit,
+  ['-'] = lexMinus,
 };
 
-__forceinline bool is_whitespace(char ch) {
-  if (utf8_codepoint_width(ch) != 1U) {
-    return false;
+#define lex_class_of(ch) ((LexClass)lex_classes[(unsigned char)(ch)])
+
+// SWAR helpers, each of them tells whether any byte of 64 bit word satisfies condition
+#define LEX_ONES 0x0101010101010101ULL
+#define LEX_HIGHS 0x8080808080808080ULL
+#define lex_has_less(word, n) (((word) - (LEX_ONES * (n))) & ~(word) & LEX_HIGHS) // n should be <= 128
+#define lex_has_byte(word, byte) lex_has_less((word) ^ (LEX_ONES * (byte)), 1ULL)
+
+#define READER_SYMBOL_CACHE 256U // direct mapped, should be power of 2
+
+typedef struct {
+  // recently read names, so that repeating ones don't go through locking of global symbol table
+  IrisSymbol symbols[READER_SYMBOL_CACHE];
+  bool present[READER_SYMBOL_CACHE];
+} ReaderSymbolCache;
+
+#define READER_FRAMES_PREALLOC 16U
+#define READER_VALUES_PREALLOC 64U
+
+typedef struct {
+  // list or quote that is being read, nesting is kept on heap instead of C stack
+  size_t base;    // items of frame are values from this index up to the top of value stack
+  bool is_quote;  // quote frame is finished by the first form that is read in it
+} ReaderFrame;
+
+typedef struct {
+  const char* ptr;
+  const char* end;
+  IrisStringSource* source; // NULL if read objects should own their bytes, otherwise long strings borrow them
+  // stacks are allocated on first nesting and reused between forms
+  ReaderFrame* frames;
+  size_t n_frames;
+  size_t frames_cap;
+  size_t depth_limit;
+  IrisObject* values;       // items of every open list, so that each list is allocated once with exact size when closed
+  size_t n_values;
+  size_t values_cap;
+  ReaderSymbolCache cache;
+} ReaderState;
+
+static void reader_state_release(ReaderState* state) {
+  assert((state->n_frames == 0ULL) && (state->n_values == 0ULL));
+  if (state->frames != NULL) {
+    iris_free(state->frames);
+    state->frames = NULL;
+    state->frames_cap = 0ULL;
   }
-  switch (ch) {
-    case  9: return true;
-    case 10: return true;
-    case 11: return true;
-    case 12: return true;
-    case 13: return true;
-    case 32: return true;
-    default: return false;
+  if (state->values != NULL) {
+    iris_free(state->values);
+    state->values = NULL;
+    state->values_cap = 0ULL;
   }
 }
 
-__forceinline bool is_reserved_char(char ch) {
-  if (utf8_codepoint_width(ch) != 1U) {
-    return false;
+__forceinline uint64_t lex_load_word(const char* ptr) {
+  uint64_t word;
+  memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+/*
+  @brief  Find end of symbol or number that starts at ptr
+*/
+__forceinline const char* lex_token_end(const char* ptr, const char* end) {
+  while ((end - ptr) >= (ptrdiff_t)sizeof(uint64_t)) {
+    uint64_t word = lex_load_word(ptr);
+    // any byte below '!' is either whitespace or control character, which are rare enough to be checked by table
+    if (lex_has_less(word, 0x21ULL) | lex_has_byte(word, '(') | lex_has_byte(word, ')') |
+        lex_has_byte(word, ';') | lex_has_byte(word, '\"') | lex_has_byte(word, '\'')) {
+      break;
+    }
+    ptr += sizeof(uint64_t);
   }
-  switch (ch) {
-    case '\'': return true;
-    case '\"': return true;
-    case '(': return true;
-    case ')': return true;
-    case ';': return true;
-    default:   return false;
+  while ((ptr < end) && (lex_class_of(*ptr) < lexWhitespace)) {
+    ptr++;
   }
+  return ptr;
 }
 
 // todo: should we care about Unicode whitespace characters?
 /*
   @brief  Skip any whitespace characters, also skip comments
-  @return How many characters are skipped
 */
-static size_t eat_whitespace(const char* slice, const char* limit) {
-  assert(slice <= limit);
-  const char* ptr = slice;
-  while ((ptr <= limit)) {
-    if (is_whitespace(*ptr)) {
-      ptr++;
-    } else if (*ptr == ';') {
-      do {
-        ptr += utf8_codepoint_width(*ptr);
-      } while (!ascii_cmp(*ptr, '\n'));
+static void reader_skip_trivia(ReaderState* state) {
+  const char* ptr = state->ptr;
+  const char* end = state->end;
+  while (ptr < end) {
+    LexClass class = lex_class_of(*ptr);
+    if (class == lexWhitespace) {
+      // indentation tends to come in long runs of spaces
+      if (((end - ptr) >= (ptrdiff_t)sizeof(uint64_t)) && (lex_load_word(ptr) == (LEX_ONES * ' '))) {
+        ptr += sizeof(uint64_t);
+      } else {
+        ptr++;
+      }
+    } else if (class == lexComment) {
+      const char* newline = memchr(ptr, '\n', (size_t)(end - ptr));
+      ptr = (newline != NULL) ? (newline + 1) : end;
     } else {
       break;
     }
   }
-  return (size_t)(((ptrdiff_t)ptr - (ptrdiff_t)slice) / sizeof(char));
+  state->ptr = ptr;
 }
 
-static ParseStatus parse_int(IrisObject* target, size_t* parsed, const char* slice, const char* limit) {
-  assert(slice <= limit);
-  assert(target != NULL);
-  assert(parsed != NULL);
-  const char* ptr = slice;
-  bool is_negative = false;
-  if (ascii_cmp(*ptr, '-')) {
-    is_negative = true;
-    ptr++;
-    if (ptr > limit)
-      return psAbort;
+/*
+  @brief  Parse decimal integer with optional leading minus
+          Overflow is detected before multiplication, so the whole range of intmax_t is covered
+  @return False if token isn't integer literal, in such case it's a symbol
+*/
+static bool lex_int(const char* low, const char* high, IrisObject* result) {
+  bool is_negative = (*low == '-');
+  const char* ptr = low + (is_negative ? 1 : 0);
+  if (ptr == high) {
+    return false;
   }
-  if (ascii_cmp(*ptr, '0')) {
-    ptr++;
-    *target = (IrisObject){ .kind = irisObjectKindInt, .int_variant = 0 };
-    *parsed = (size_t)(((ptrdiff_t)ptr - (ptrdiff_t)slice) / sizeof(char));
-    return psResult;
+  for (const char* digit = ptr; digit < high; digit++) {
+    if (lex_class_of(*digit) != lexDigit) {
+      return false;
+    }
   }
-  if ((utf8_codepoint_width(*ptr) == 1U) && (*ptr >= '1') && (*ptr <= '9')) {
-    IrisObject result = { .kind = irisObjectKindInt, .int_variant = (*ptr - '0') };
-    ptr++;
-    while ((ptr <= limit) && (utf8_codepoint_width(*ptr) == 1U) && (*ptr >= '0') && (*ptr <= '9')) {
-      // todo: we should not check result, but predict overflow / underflow beforehand
-      intmax_t check = result.int_variant;
-      result.int_variant = result.int_variant * 10 + (*ptr - '0');
-      if (check >= result.int_variant) { // todo: lower bound truncates incorrectly
-        *target = error_to_object(error_new(is_negative? irisErrorUnderflowError : irisErrorOverflowError));
-        return psError;
-      }
-      ptr++;
+  uintmax_t limit = is_negative ? ((uintmax_t)INTMAX_MAX + 1U) : (uintmax_t)INTMAX_MAX;
+  uintmax_t value = 0U;
+  for (; ptr < high; ptr++) {
+    unsigned int digit = (unsigned int)(*ptr - '0');
+    if (value > ((limit - digit) / 10U)) {
+      *result = error_to_object(is_negative ?
+        error_from_chars(irisErrorUnderflowError, "integer literal is too small") :
+        error_from_chars(irisErrorOverflowError, "integer literal is too big"));
+      return true;
     }
-    if (is_negative) {
-      result.int_variant = 0 - result.int_variant;
+    value = value * 10U + digit;
+  }
+  if (is_negative) {
+    // negation is done in unsigned space, as magnitude of minimum doesn't fit positive range
+    *result = int_to_object((value == 0U) ? 0 : (-(intmax_t)(value - 1U) - 1));
+  } else {
+    *result = int_to_object((intmax_t)value);
+  }
+  return true;
+}
+
+static IrisSymbol reader_intern(ReaderState* state, const char* low, const char* high) {
+  size_t len = (size_t)(high - low);
+  size_t slot = iris_hash_bytes(low, len) & (READER_SYMBOL_CACHE - 1U);
+  if (state->cache.present[slot]) {
+    const IrisString* name = symbol_name(state->cache.symbols[slot]);
+    if ((name->len == len) && (memcmp(string_bytes(*name), low, len) == 0)) {
+      return state->cache.symbols[slot];
     }
-    *target = result;
-    *parsed = (size_t)(((ptrdiff_t)ptr - (ptrdiff_t)slice) / sizeof(char));
-    return psResult;
   }
-  return psAbort;
+  IrisSymbol result = symbol_from_view(low, high);
+  state->cache.symbols[slot] = result;
+  state->cache.present[slot] = true;
+  return result;
 }
 
-static ParseStatus parse_atomic_symbol(IrisObject* target, size_t* parsed, const char* slice, const char* limit) {
-  assert(slice <= limit);
-  assert(target != NULL);
-  assert(parsed != NULL);
-  const char* ptr = slice;
-  while (ptr <= limit) {
-    if (is_reserved_char(*ptr) || is_whitespace(*ptr)) {
-      break;
+static IrisObject read_atom(ReaderState* state) {
+  const char* low = state->ptr;
+  const char* high = lex_token_end(low, state->end);
+  state->ptr = high;
+  IrisObject result;
+  if ((lex_class_of(*low) != lexSymbol) && lex_int(low, high, &result)) {
+    return result;
+  }
+  return symbol_to_object(reader_intern(state, low, high));
+}
+
+static IrisObject read_string(ReaderState* state) {
+  const char* low = state->ptr + 1;
+  const char* high = memchr(low, '\"', (size_t)(state->end - low));
+  if (high == NULL) {
+    state->ptr = state->end;
+    return error_to_object(error_from_chars(irisErrorSyntaxError, "trailing unclosed string"));
+  }
+  state->ptr = high + 1;
+  return string_to_object((state->source != NULL) ?
+    string_from_source(state->source, low, high) : string_from_view(low, high));
+}
+
+/*
+  @brief  Open new list or quote frame
+  @return False if depth limit is reached
+*/
+static bool reader_push_frame(ReaderState* state, bool is_quote) {
+  if (state->n_frames == state->depth_limit) {
+    return false;
+  }
+  if (state->n_frames == state->frames_cap) {
+    state->frames_cap = (state->frames_cap == 0ULL) ? READER_FRAMES_PREALLOC : (state->frames_cap * 2ULL);
+    state->frames = iris_resize(state->frames, state->frames_cap, ReaderFrame);
+  }
+  state->frames[state->n_frames++] = (ReaderFrame){ .base = state->n_values, .is_quote = is_quote };
+  return true;
+}
+
+__forceinline void reader_push_value(ReaderState* state, IrisObject value) {
+  if (state->n_values == state->values_cap) {
+    state->values_cap = (state->values_cap == 0ULL) ? READER_VALUES_PREALLOC : (state->values_cap * 2ULL);
+    state->values = iris_resize(state->values, state->values_cap, IrisObject);
+  }
+  state->values[state->n_values++] = value;
+}
+
+/*
+  @brief  Close innermost frame, moving its items into list of exact size
+*/
+static IrisObject reader_pop_frame(ReaderState* state) {
+  assert(state->n_frames != 0ULL);
+  size_t base = state->frames[--state->n_frames].base;
+  size_t len = state->n_values - base;
+  IrisList result = { .len = len, .cap = len };
+  if (len != 0ULL) {
+    result.items = iris_alloc_kind(len, IrisObject, irisObjectKindList);
+    memcpy(result.items, state->values + base, len * sizeof(IrisObject));
+  }
+  state->n_values = base;
+  return list_to_object(result);
+}
+
+/*
+  @brief  Drop every frame that is still open, used when form cannot be finished
+*/
+static IrisObject reader_unwind(ReaderState* state, IrisObject error) {
+  while (state->n_values != 0ULL) {
+    object_destroy(&state->values[--state->n_values]);
+  }
+  state->n_frames = 0ULL;
+  return error;
+}
+
+/*
+  @brief  Read single form, trivia should be skipped beforehand and state shouldn't be at the end
+          Lists and quotes are read without recursion, their nesting is limited by state->depth_limit
+*/
+static IrisObject read_form(ReaderState* state) {
+  assert(state->ptr < state->end);
+  assert(state->n_frames == 0ULL);
+  for (;;) {
+    if (state->n_frames != 0ULL) {
+      reader_skip_trivia(state);
+      if (state->ptr == state->end) {
+        return reader_unwind(state, error_to_object(state->frames[state->n_frames - 1ULL].is_quote ?
+          error_from_chars(irisErrorSyntaxError, "nothing to quote") :
+          error_from_chars(irisErrorSyntaxError, "trailing unclosed list")));
+      }
     }
-    ptr += utf8_codepoint_width(*ptr);
-  }
-  if (ptr == slice) 
-    return psAbort;
-  IrisObject result = string_to_object(string_from_view(slice, ptr));
-  *target = result;
-  *parsed = result.string_variant.len;
-  return psResult;
-}
-
-static ParseStatus parse_marked_symbol(IrisObject* target, size_t* parsed, const char* slice, const char* limit) {
-  assert(slice <= limit);
-  assert(target != NULL);
-  assert(parsed != NULL);
-  const char* ptr = slice;
-  if (ascii_cmp(*ptr, '\"')) {
-    ptr++;
-    while (ptr <= limit) {
-      if (ascii_cmp(*ptr, '\"')) {
-        IrisObject result = string_to_object(string_from_view(slice + 1U, ptr));
-        *target = result;
-        *parsed = result.string_variant.len + 2ULL;
-        return psResult;
+    IrisObject value;
+    LexClass class = lex_class_of(*state->ptr);
+    if (class <= lexMinus) {
+      value = read_atom(state);
+    } else if (class == lexString) {
+      value = read_string(state);
+    } else if ((class == lexListOpen) || (class == lexQuote)) {
+      if (!reader_push_frame(state, class == lexQuote)) {
+        return reader_unwind(state, error_to_object(error_from_chars(irisErrorStackError, "nesting of forms is too deep")));
+      }
+      state->ptr++;
+      continue;
+    } else {
+      assert(class == lexListClose);
+      if (state->n_frames == 0ULL) {
+        state->ptr++;
+        return error_to_object(error_from_chars(irisErrorSyntaxError, "unexpected closing of list"));
       }
-      ptr += utf8_codepoint_width(*ptr);
+      if (state->frames[state->n_frames - 1ULL].is_quote) {
+        // closing is left for enclosing list
+        return reader_unwind(state, error_to_object(error_from_chars(irisErrorSyntaxError, "nothing to quote")));
+      }
+      state->ptr++;
+      value = reader_pop_frame(state);
     }
-    *target = error_to_object(error_from_chars(irisErrorSyntaxError, "trailing unclosed string"));
-    return psError;
-  }
-  return psAbort;
-}
-
-static ParseStatus parse_quote(IrisObject* target, size_t* parsed, const char* slice, const char* limit) {
-  assert(slice <= limit);
-  assert(target != NULL);
-  assert(parsed != NULL);
-  const char* ptr = slice;
-  if (ascii_cmp(*ptr, '\'')) {
-    ptr++; // skip past '\'
-    if (ptr > limit) {
-      *target = error_to_object(error_from_chars(irisErrorSyntaxError, "nothing to quote"));
-      return psError;
+    if (value.kind == irisObjectKindError) {
+      return reader_unwind(state, value);
     }
-    ptr += eat_whitespace(ptr, limit);
-    if (ptr > limit) {
-      *target = error_to_object(error_from_chars(irisErrorSyntaxError, "nothing to quote"));
-      return psError;
+    // finished form goes to enclosing frame, quotes are finished by it as well
+    while ((state->n_frames != 0ULL) && state->frames[state->n_frames - 1ULL].is_quote) {
+      static const char quote_name[] = "quote!";
+      reader_push_value(state, symbol_to_object(reader_intern(state, quote_name, quote_name + (sizeof(quote_name) - 1U))));
+      reader_push_value(state, value);
+      value = reader_pop_frame(state);
     }
-    IrisList result = list_new();
-    IrisString quote_sym = string_from_chars("quote!");
-    list_push_string(&result, &quote_sym);
-    IrisObject obj_parsed;
-    size_t chars_parsed;
-    ParseStatus status = psAbort;
-    size_t i = 0ULL;
-    while ((status == psAbort) && (i < (sizeof(parsing_procs) / sizeof(ParseProc)))) {
-      status = parsing_procs[i](&obj_parsed, &chars_parsed, ptr, limit);
-      if (status == psError) {
-        list_destroy(&result);
-        *target = obj_parsed;
-        return psError;
-      } else if (status == psResult) {
-        list_push_object(&result, &obj_parsed);
-        ptr += chars_parsed;
-        *target = list_to_object(result);
-        *parsed = (size_t)(((ptrdiff_t)ptr - (ptrdiff_t)slice) / sizeof(char));
-        return psResult;
-      }
-      i++;
+    if (state->n_frames == 0ULL) {
+      return value;
+    }
+    reader_push_value(state, value);
+  }
+}
+
+typedef struct {
+  // position of some byte of source, line and column start from 1, column is counted in codepoints
+  size_t line;
+  size_t column;
+  size_t offset;
+} ReaderPosition;
+
+#define READER_ORIGIN (ReaderPosition){ .line = 1ULL, .column = 1ULL, .offset = 0ULL }
+
+/*
+  @brief  Position of byte that follows given bytes, which start at origin
+  @warn   Bytes should be valid UTF-8
+*/
+static ReaderPosition reader_advance_position(ReaderPosition origin, const char* bytes, size_t len) {
+  const char* end = bytes + len;
+  const char* line_start = bytes;
+  const char* newline;
+  while ((newline = memchr(line_start, '\n', (size_t)(end - line_start))) != NULL) {
+    origin.line++;
+    line_start = newline + 1;
+  }
+  size_t tail = utf8_count(line_start, (size_t)(end - line_start));
+  origin.column = (line_start == bytes) ? (origin.column + tail) : (tail + 1ULL);
+  origin.offset += len;
+  return origin;
+}
+
+/*
+  @brief  Report position of ill-formed byte, everything before it is known to be valid
+*/
+static IrisObject reader_encoding_error(const char* bytes, size_t offset, ReaderPosition origin) {
+  ReaderPosition position = reader_advance_position(origin, bytes, offset);
+  char msg[128];
+  (void)snprintf(msg, sizeof(msg), "source isn't encoded in UTF-8, ill-formed byte at line %zu, column %zu (byte %zu)",
+    position.line, position.column, position.offset);
+  return error_to_object(error_from_chars(irisErrorEncodingError, msg));
+}
+
+/*
+  @brief  Read forms until the end of state, appending them to result
+  @return Nil or the first error
+*/
+static IrisObject read_forms(ReaderState* state, IrisList* result) {
+  for (;;) {
+    reader_skip_trivia(state);
+    if (state->ptr == state->end) {
+      return (IrisObject){0}; // nil
     }
-    *target = error_to_object(error_from_chars(irisErrorSyntaxError, "unknown symbol sequence"));
+    IrisObject form = read_form(state);
+    if (form.kind == irisObjectKindError) {
+      return form;
+    }
+    list_push_object(result, &form);
+  }
+}
+
+static IrisObject read_range(const char* bytes, size_t len, IrisStringSource* source) {
+  IRIS_PROFILE_ZONE("reader");
+  assert(pointer_is_valid(bytes) || (len == 0ULL));
+  size_t error_offset;
+  if (!utf8_validate(bytes, len, &error_offset)) {
+    return reader_encoding_error(bytes, error_offset, READER_ORIGIN);
+  }
+  ReaderState state = { .ptr = bytes, .end = bytes + len, .source = source, .depth_limit = IRIS_READER_DEPTH_LIMIT };
+  IrisList result = list_new();
+  IrisObject error = read_forms(&state, &result);
+  reader_state_release(&state);
+  if (error.kind == irisObjectKindError) {
     list_destroy(&result);
-    return psError;
+    return error;
   }
-  return psAbort;
+  list_shrink_to_fit(&result); // codelist is kept for whole evaluation
+  return list_to_object(result);
 }
 
-static ParseStatus parse_list(IrisObject* target, size_t* parsed, const char* slice, const char* limit) {
-  assert(slice <= limit);
-  assert(target != NULL);
-  assert(parsed != NULL);
-  const char* ptr = slice;
-  if (ascii_cmp(*ptr, '(')) {
-    ptr++; // skip past '('
-    if (ptr > limit) {
-      *target = error_to_object(error_from_chars(irisErrorSyntaxError, "trailing unclosed list"));
-      return psError;
+#define READER_PARALLEL_MIN_LEN (1024ULL * 1024ULL) // smaller sources aren't worth starting threads for
+#define READER_CHUNKS_PER_THREAD 4U // chunks are picked dynamically, so that threads that got simpler ones don't idle
+
+/*
+  @brief  Bit mask of bytes that affect nesting: parens, string quotes and comment starts, in the next 64 bytes
+*/
+static uint64_t lex_nesting_mask(const char* ptr, const char* end) {
+  uint64_t mask = 0ULL;
+  size_t i = 0ULL;
+  #ifdef IRIS_READER_X86
+  if ((end - ptr) >= 64) {
+    const __m128i open = _mm_set1_epi8('('), close = _mm_set1_epi8(')');
+    const __m128i quote = _mm_set1_epi8('\"'), comment = _mm_set1_epi8(';');
+    for (; i < 64ULL; i += 16ULL) {
+      __m128i chunk = _mm_loadu_si128((const __m128i*)(ptr + i));
+      __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, open), _mm_cmpeq_epi8(chunk, close)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, comment)));
+      mask |= (uint64_t)(unsigned int)_mm_movemask_epi8(hits) << i;
     }
-    ptr += eat_whitespace(ptr, limit);
-    if (ptr > limit) {
-      *target = error_to_object(error_from_chars(irisErrorSyntaxError, "trailing unclosed list"));
-      return psError;
+    return mask;
+  }
+  #endif
+  for (; (i < 64ULL) && ((ptr + i) < end); i++) {
+    char ch = ptr[i];
+    if ((ch == '(') || (ch == ')') || (ch == '\"') || (ch == ';')) {
+      mask |= 1ULL << i;
     }
-    IrisList result = list_new();
-    IrisObject obj_parsed;
-    size_t chars_parsed;
-    while (ptr <= limit) {
-      ptr += eat_whitespace(ptr, limit);
-      if (ptr > limit) { break; }
-      if (ascii_cmp(*ptr, ')')) {
-        *target = list_to_object(result);
-        *parsed = (size_t)(((ptrdiff_t)ptr - (ptrdiff_t)slice) / sizeof(char)) + 1ULL;
-        return psResult;
+  }
+  return mask;
+}
+
+/*
+  @brief  Find where top-level forms end, so that source could be read in independent chunks
+          Only bytes that affect nesting are looked at, they're found 64 at a time,
+          boundary is placed after list or string that is closed at depth 0, no sooner than step bytes after previous one
+  @return Number of boundaries written, last chunk always ends at len and isn't counted
+*/
+static size_t lex_split_points(const char* bytes, size_t len, size_t step, size_t* points, size_t max_points) {
+  size_t n_points = 0ULL;
+  size_t next_split = step;
+  size_t depth = 0ULL;
+  const char* ptr = bytes;
+  const char* end = bytes + len;
+  while ((ptr < end) && (n_points < max_points)) {
+    uint64_t mask = lex_nesting_mask(ptr, end);
+    const char* resume = ((end - ptr) >= 64) ? (ptr + 64) : end;
+    while (mask != 0ULL) {
+      const char* at = ptr + __builtin_ctzll(mask);
+      mask &= mask - 1ULL;
+      bool is_closed = false;
+      if (*at == '(') {
+        depth++;
+        continue;
+      } else if (*at == ')') {
+        // unmatched closing is left for reader to report
+        if (depth != 0ULL) { depth--; }
+        is_closed = (depth == 0ULL);
+      } else {
+        // rest of the block might be inside of string or comment, so scanning restarts past its end
+        const char* stop = memchr(at + 1, (*at == ';') ? '\n' : '\"', (size_t)(end - (at + 1)));
+        resume = (stop != NULL) ? (stop + 1) : end;
+        is_closed = (*at == '\"') && (depth == 0ULL);
+        mask = 0ULL;
+        at = resume - 1;
       }
-      ParseStatus status = psAbort;
-      size_t i = 0ULL;
-      while ((status == psAbort) && (i < (sizeof(parsing_procs) / sizeof(ParseProc)))) {
-        status = parsing_procs[i](&obj_parsed, &chars_parsed, ptr, limit);
-        if (status == psError) {
-          *target = obj_parsed;
-          list_destroy(&result);
-          return psError;
-        } else if (status == psResult) {
-          list_push_object(&result, &obj_parsed);
-          ptr += chars_parsed;
+      size_t offset = (size_t)((at + 1) - bytes);
+      if (is_closed && (offset >= next_split) && (offset < len)) {
+        points[n_points++] = offset;
+        next_split = offset + step;
+        if (n_points == max_points) {
           break;
         }
-        i++;
       }
     }
-    list_destroy(&result);
-    *target = error_to_object(error_from_chars(irisErrorSyntaxError, "trailing unclosed list"));
-    return psError;
+    ptr = resume;
   }
-  return psAbort;
+  return n_points;
 }
 
-IrisObject string_read(const IrisString source) {
-  if (utf8_check_validity(source)) {
-    IrisList result = list_new();
-    if (source.len == 0ULL) {
-      return list_to_object(result);
-    }
-    const char* limit = &source.data[source.len - 1ULL];
-    const char* ptr = source.data;
-    ptr += eat_whitespace(ptr, limit);
-    while (ptr <= limit) {
-      ptr += eat_whitespace(ptr, limit);
-      if (ptr > limit) { break; }
-      IrisObject obj_parsed;
-      size_t chars_parsed;
-      ParseStatus status = psAbort;
-      size_t i = 0ULL;
-      while ((status == psAbort) && (i < (sizeof(parsing_procs) / sizeof(ParseProc)))) {
-        status = parsing_procs[i](&obj_parsed, &chars_parsed, ptr, limit);
-        if (status == psError) {
-          list_destroy(&result);
-          return obj_parsed;
-        } else if (status == psResult) {
-          list_push_object(&result, &obj_parsed);
-          ptr += chars_parsed;
-          break;
-        }
-        i++;
-      }
+typedef struct {
+  IrisList forms;
+  IrisObject error;       // nil if chunk is read fine
+  bool is_ill_formed;     // encoding is checked before reading, as whole source is checked by sequential reader
+  size_t error_offset;    // of ill-formed byte, relative to chunk
+} ReaderChunk;
+
+typedef struct {
+  const char* bytes;
+  IrisStringSource* source;
+  const size_t* bounds;   // chunk i spans [bounds[i], bounds[i + 1])
+  ReaderChunk* chunks;
+  size_t n_chunks;
+  atomic_size_t next_chunk;
+} ReaderSplit;
+
+static void read_chunks(ReaderSplit* split) {
+  size_t i;
+  while ((i = atomic_fetch_add_explicit(&split->next_chunk, 1U, memory_order_relaxed)) < split->n_chunks) {
+    IRIS_PROFILE_ZONE("reader");
+    const char* low = split->bytes + split->bounds[i];
+    size_t len = split->bounds[i + 1ULL] - split->bounds[i];
+    ReaderChunk* chunk = &split->chunks[i];
+    if (!utf8_validate(low, len, &chunk->error_offset)) {
+      chunk->is_ill_formed = true;
+      continue;
     }
-    return list_to_object(result);
-  } else {
-    return error_to_object(error_from_chars(irisErrorEncodingError, "source string isn't encoded in UTF-8"));
+    ReaderState state = { .ptr = low, .end = low + len, .source = split->source, .depth_limit = IRIS_READER_DEPTH_LIMIT };
+    chunk->error = read_forms(&state, &chunk->forms);
+    reader_state_release(&state);
   }
 }
 
-static bool try_resolve_macro(IrisObject* target, const IrisList list, const IrisDict scope) {
-  if (list.len != 0ULL) {
-    IrisObject leading = list.items[0];
-    if ((leading.kind == irisObjectKindString) && dict_has(scope, leading)) {
-      const IrisObject* resolved = dict_get_view(scope, leading);
-      if ((resolved->kind == irisObjectKindFunc) && func_is_macro(resolved->func_variant)) {
-        *target = func_call(resolved->func_variant, &list.items[1], list.len - 1ULL);
-        return true;
+static void* read_chunks_thread(void* split) {
+  read_chunks((ReaderSplit*)split);
+  iris_metrics_thread_release();
+  #ifdef IRIS_USE_POOL
+  iris_pool_thread_release();
+  #endif
+  return NULL;
+}
+
+/*
+  @brief  Join chunk results in order, reporting the same error as sequential reader would
+*/
+static IrisObject read_chunks_join(ReaderSplit* split) {
+  IrisObject error = {0};
+  size_t total = 0ULL;
+  for (size_t i = 0ULL; i < split->n_chunks; i++) {
+    ReaderChunk* chunk = &split->chunks[i];
+    if (chunk->is_ill_formed) {
+      // every chunk before is valid, so position could be counted from the start
+      if (error.kind == irisObjectKindError) {
+        object_destroy(&error);
       }
+      error = reader_encoding_error(split->bytes, split->bounds[i] + chunk->error_offset, READER_ORIGIN);
+      break;
+    }
+    if ((chunk->error.kind == irisObjectKindError) && (error.kind != irisObjectKindError)) {
+      error = chunk->error;
+      object_move(&chunk->error);
+    }
+    total += chunk->forms.len;
+  }
+  IrisList result = list_new();
+  if (error.kind != irisObjectKindError) {
+    list_reserve(&result, total);
+  }
+  for (size_t i = 0ULL; i < split->n_chunks; i++) {
+    ReaderChunk* chunk = &split->chunks[i];
+    if (chunk->error.kind == irisObjectKindError) {
+      object_destroy(&chunk->error);
+    }
+    if (error.kind == irisObjectKindError) {
+      list_destroy(&chunk->forms);
+      continue;
     }
+    // items are moved, so only array of chunk list is released
+    list_extend(&result, &chunk->forms);
+  }
+  if (error.kind == irisObjectKindError) {
+    return error;
   }
-  return false;
+  return list_to_object(result);
 }
 
-static bool try_resolve_name(IrisObject* target, const IrisString str, const IrisDict scope) {
-  if (dict_has(scope, string_to_object(str)) == true) {
-    *target = dict_get(scope, string_to_object(str)); 
-    return true;
+static IrisObject read_range_parallel(const char* bytes, size_t len, IrisStringSource* source, unsigned int n_threads) {
+  assert(pointer_is_valid(bytes) || (len == 0ULL));
+  if ((n_threads <= 1U) || (len < READER_PARALLEL_MIN_LEN)) {
+    return read_range(bytes, len, source);
+  }
+  size_t max_points = (size_t)n_threads * READER_CHUNKS_PER_THREAD - 1ULL;
+  size_t* bounds = iris_alloc(max_points + 2ULL, size_t);
+  size_t n_points;
+  {
+    IRIS_PROFILE_ZONE("split");
+    n_points = lex_split_points(bytes, len, len / (max_points + 1ULL), bounds + 1, max_points);
+  }
+  bounds[0] = 0ULL;
+  bounds[n_points + 1ULL] = len;
+  ReaderSplit split = {
+    .bytes = bytes,
+    .source = source,
+    .bounds = bounds,
+    .chunks = iris_alloc0(n_points + 1ULL, ReaderChunk),
+    .n_chunks = n_points + 1ULL,
+  };
+  atomic_init(&split.next_chunk, 0U);
+  size_t n_workers = ((size_t)n_threads < split.n_chunks) ? (size_t)n_threads - 1ULL : split.n_chunks - 1ULL;
+  pthread_t workers[n_workers + 1ULL]; // calling thread reads as well
+  size_t n_started = 0ULL;
+  for (; n_started < n_workers; n_started++) {
+    if (pthread_create(&workers[n_started], NULL, &read_chunks_thread, &split) != 0) {
+      break; // whatever isn't picked up is read by calling thread
+    }
   }
-  return false;
+  read_chunks(&split);
+  for (size_t i = 0ULL; i < n_started; i++) {
+    if (pthread_join(workers[i], NULL) != 0) {
+      panic("error on reader thread joining");
+    }
+  }
+  IrisObject result = read_chunks_join(&split);
+  iris_free(split.chunks);
+  iris_free(bounds);
+  return result;
 }
 
-// ! should reflect codelist_resolve
-// difference between top-most resolving and nested is that it's required for nested lists to have function as its first elements
-static IrisObject codelist_resolve_nested(const IrisObject obj, const IrisDict scope) {
-  switch (obj.kind) {
-    case irisObjectKindString: {
-      IrisObject result;
-      if (try_resolve_name(&result, obj.string_variant, scope) == true) {
-        return result;
+// todo: forward name resolving
+
+/*
+  @brief  Resolve names and expand macros of object in place, leaves are replaced and lists are reused
+          Nested lists are required to have function as their first element
+  @return Nil or the first error, object is then left partially resolved
+*/
+static IrisObject resolve_in_place(IrisObject* obj, const IrisMap scope, bool is_nested) {
+  switch (obj->kind) {
+    case irisObjectKindSymbol: {
+      const IrisObject* found = map_find(scope, *obj);
+      if (found != NULL) {
+        *obj = object_copy(*found); // symbols don't own anything
       }
       break;
     }
     case irisObjectKindList: {
-      IrisObject result;
-      if (try_resolve_macro(&result, obj.list_variant, scope) == true) {
-        return result;
-      } else {
-        result = list_to_object(list_new());
-        for (size_t i = 0ULL; i < obj.list_variant.len; i++) {
-          IrisObject resolved = codelist_resolve_nested(obj.list_variant.items[i], scope);
-          if (resolved.kind == irisObjectKindError) {
-            object_destroy(&result);
-            return resolved;
+      object_unshare(obj); // list could be shared with quoted data or with caller of codelist_resolve
+      IrisList* list = obj->list_variant;
+      size_t i = 0ULL;
+      if ((list->len != 0ULL) && (list->items[0].kind == irisObjectKindSymbol)) {
+        // leading symbol is looked up once, both for macro expansion and as a name
+        const IrisObject* leading = map_find(scope, list->items[0]);
+        if (leading != NULL) {
+          if ((leading->kind == irisObjectKindFunc) && func_is_macro(*leading->func_variant)) {
+            IrisObject expanded = func_call(*leading->func_variant, &list->items[1], list->len - 1ULL);
+            object_destroy(obj);
+            if (expanded.kind == irisObjectKindError) {
+              return expanded;
+            }
+            *obj = expanded;
+            break;
           }
-          list_push_object(&result.list_variant, &resolved);
+          list->items[0] = object_copy(*leading);
         }
-        if ((obj.list_variant.len > 0ULL) && (result.list_variant.items[0].kind != irisObjectKindFunc)) {
-          object_destroy(&result);
-          return error_to_object(error_from_chars(irisErrorNameError, "unknown function name"));
+        i = 1ULL;
+      }
+      for (; i < list->len; i++) {
+        IrisObject error = resolve_in_place(&list->items[i], scope, true);
+        if (error.kind == irisObjectKindError) {
+          return error;
         }
-        return result;
       }
+      if (is_nested && (list->len != 0ULL) && (list->items[0].kind != irisObjectKindFunc)) {
+        return error_to_object(error_from_chars(irisErrorNameError, "unknown function name"));
+      }
+      break;
     }
     default: break;
   }
-  return object_copy(obj);
+  return (IrisObject){0}; // nil
 }
 
-// todo: forward name resolving
+/*
+  @brief  Take ownership of object and resolve it, object is destroyed on error
+*/
+static IrisObject resolve_owned(IrisObject* obj, const IrisMap scope, bool is_nested) {
+  IRIS_PROFILE_ZONE("resolve");
+  assert(pointer_is_valid(obj));
+  IrisObject error = resolve_in_place(obj, scope, is_nested);
+  if (error.kind == irisObjectKindError) {
+    object_destroy(obj);
+    return error;
+  }
+  IrisObject result = *obj;
+  object_move(obj);
+  return result;
+}
+
+IrisObject codelist_resolve_in_place(IrisObject* codelist, const IrisMap scope) {
+  return resolve_owned(codelist, scope, false);
+}
+
+IrisObject form_resolve_in_place(IrisObject* form, const IrisMap scope) {
+  return resolve_owned(form, scope, true);
+}
+
+IrisObject codelist_resolve(const IrisObject obj, const IrisMap scope) {
+  IrisObject copy = object_copy(obj);
+  return codelist_resolve_in_place(&copy, scope);
+}
+
+IrisObject string_read(const IrisString source) {
+  return read_range(string_bytes(source), source.len, NULL);
+}
 
-IrisObject codelist_resolve(const IrisObject obj, const IrisDict scope) {
-  switch (obj.kind) {
-    case irisObjectKindString: {
-      IrisObject result;
-      if (try_resolve_name(&result, obj.string_variant, scope) == true) {
-        return result;
+IrisObject chars_read(const char* source, size_t len) {
+  return read_range(source, len, NULL);
+}
+
+IrisObject source_read(IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  return read_range(string_source_data(source), string_source_len(source), source);
+}
+
+IrisObject chars_read_parallel(const char* source, size_t len, unsigned int n_threads) {
+  return read_range_parallel(source, len, NULL, n_threads);
+}
+
+IrisObject source_read_parallel(IrisStringSource* source, unsigned int n_threads) {
+  assert(pointer_is_valid(source));
+  return read_range_parallel(string_source_data(source), string_source_len(source), source, n_threads);
+}
+
+#define READER_STREAM_BUFFER (64ULL * 1024ULL)
+#define READER_NO_FD (-1)
+
+typedef struct {
+  // progress of looking for the end of top-level form in stream, so that refilling doesn't rescan from the start
+  size_t depth;
+  bool in_form;     // something besides trivia was met, used for choosing prompt
+  bool in_atom;
+  bool in_string;
+  bool in_comment;
+} ReaderScan;
+
+struct _IrisReader {
+  ReaderState state;        // symbol cache persists between forms
+  IrisStringSource* source; // NULL for streams
+  int fd;                   // READER_NO_FD if whole source is available
+  char* buffer;             // streams only, holds at least one top-level form
+  size_t cap;
+  const char* data;
+  size_t len;
+  size_t pos;               // start of unread bytes
+  size_t scan;              // how far form end scanner got
+  ReaderScan scan_state;
+  bool at_eof;
+  ReaderPosition origin;    // position of data[0], bytes before it are already discarded
+  const char* prompt;
+  const char* continuation_prompt;
+};
+
+IrisReader* reader_from_source(IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  IrisReader* result = iris_alloc0(1, IrisReader);
+  result->source = string_source_retain(source);
+  result->state.source = source;
+  result->state.depth_limit = IRIS_READER_DEPTH_LIMIT;
+  result->fd = READER_NO_FD;
+  result->data = string_source_data(source);
+  result->len = string_source_len(source);
+  result->at_eof = true;
+  result->origin = READER_ORIGIN;
+  return result;
+}
+
+IrisReader* reader_from_fd(int fd) {
+  assert(fd != READER_NO_FD);
+  IrisReader* result = iris_alloc0(1, IrisReader);
+  result->state.depth_limit = IRIS_READER_DEPTH_LIMIT;
+  result->fd = fd;
+  result->buffer = iris_alloc(READER_STREAM_BUFFER, char);
+  result->cap = READER_STREAM_BUFFER;
+  result->data = result->buffer;
+  result->origin = READER_ORIGIN;
+  return result;
+}
+
+void reader_set_prompts(IrisReader* reader, const char* prompt, const char* continuation_prompt) {
+  assert(pointer_is_valid(reader));
+  reader->prompt = prompt;
+  reader->continuation_prompt = continuation_prompt;
+}
+
+void reader_set_depth_limit(IrisReader* reader, size_t depth_limit) {
+  assert(pointer_is_valid(reader));
+  reader->state.depth_limit = depth_limit;
+}
+
+void reader_destroy(IrisReader** reader) {
+  assert(reader != NULL);
+  assert(pointer_is_valid(*reader));
+  reader_state_release(&(*reader)->state);
+  if ((*reader)->buffer != NULL) {
+    iris_free((*reader)->buffer);
+  }
+  if ((*reader)->source != NULL) {
+    string_source_release((*reader)->source);
+  }
+  iris_free(*reader);
+  *reader = NULL;
+}
+
+/*
+  @brief  Continue looking for the end of top-level form in buffered bytes
+  @return True if form is complete, its end is then written to form_end
+*/
+static bool reader_scan(IrisReader* reader, size_t* form_end) {
+  ReaderScan* scan = &reader->scan_state;
+  const char* data = reader->data;
+  size_t len = reader->len;
+  size_t i = reader->scan;
+  bool is_complete = false;
+  while (!is_complete && (i < len)) {
+    if (scan->in_comment) {
+      const char* newline = memchr(data + i, '\n', len - i);
+      i = (newline != NULL) ? (size_t)(newline - data) + 1ULL : len;
+      scan->in_comment = (newline == NULL);
+    } else if (scan->in_string) {
+      const char* quote = memchr(data + i, '\"', len - i);
+      i = (quote != NULL) ? (size_t)(quote - data) + 1ULL : len;
+      scan->in_string = (quote == NULL);
+      is_complete = !scan->in_string && (scan->depth == 0ULL);
+    } else if (scan->in_atom) {
+      // delimiter that ends atom isn't consumed, as it could close the list
+      i = (size_t)(lex_token_end(data + i, data + len) - data);
+      scan->in_atom = (i == len);
+      is_complete = !scan->in_atom && (scan->depth == 0ULL);
+    } else {
+      switch (lex_class_of(data[i++])) {
+        case lexWhitespace: break;
+        case lexComment: scan->in_comment = true; break;
+        case lexListOpen: scan->depth++; scan->in_form = true; break;
+        case lexListClose:
+          // unmatched closing is reported as form of its own
+          if (scan->depth != 0ULL) { scan->depth--; }
+          is_complete = (scan->depth == 0ULL);
+          break;
+        case lexQuote: scan->in_form = true; break; // quoted form is what completes it
+        case lexString: scan->in_string = true; scan->in_form = true; break;
+        default: scan->in_atom = true; scan->in_form = true; break;
       }
-      break;
     }
-    case irisObjectKindList: {
-      IrisObject result;
-      if (try_resolve_macro(&result, obj.list_variant, scope) == true) {
-        return result;
-      } else {
-        result = list_to_object(list_new());
-        for (size_t i = 0ULL; i < obj.list_variant.len; i++) {
-          IrisObject resolved = codelist_resolve_nested(obj.list_variant.items[i], scope);
-          if (resolved.kind == irisObjectKindError) {
-            object_destroy(&result);
-            return resolved;
-          }
-          list_push_object(&result.list_variant, &resolved);
-        }
-        return result;
-      }
+  }
+  reader->scan = i;
+  if (is_complete) {
+    *form_end = i;
+  }
+  return is_complete;
+}
+
+/*
+  @brief  Discard bytes that were read and read more from stream, buffer is grown only if form doesn't fit it
+*/
+static void reader_refill(IrisReader* reader) {
+  if (reader->pos != 0ULL) {
+    // discarded bytes were already validated
+    reader->origin = reader_advance_position(reader->origin, reader->buffer, reader->pos);
+    memmove(reader->buffer, reader->buffer + reader->pos, reader->len - reader->pos);
+    reader->len -= reader->pos;
+    reader->scan -= reader->pos;
+    reader->pos = 0ULL;
+  }
+  if (reader->len == reader->cap) {
+    reader->cap *= 2ULL;
+    reader->buffer = iris_resize(reader->buffer, reader->cap, char);
+    reader->data = reader->buffer;
+  }
+  const char* prompt = reader->scan_state.in_form ? reader->continuation_prompt : reader->prompt;
+  if (prompt != NULL) {
+    (void)fputs(prompt, stdout);
+    fflush(stdout);
+  }
+  ptrdiff_t n_read = os_fd_read(reader->fd, reader->buffer + reader->len, reader->cap - reader->len);
+  if (n_read < 0) { errno_panic(); }
+  reader->len += (size_t)n_read;
+  reader->at_eof = (n_read == 0);
+}
+
+bool reader_next(IrisReader* reader, IrisObject* result) {
+  IRIS_PROFILE_ZONE("reader");
+  assert(pointer_is_valid(reader));
+  assert(pointer_is_valid(result));
+  // extent of form is found first even when whole source is available, so that it's validated before being read
+  size_t end;
+  while (!reader_scan(reader, &end)) {
+    if (reader->at_eof) {
+      // incomplete form is passed as is, so that reader reports what's missing
+      end = reader->len;
+      break;
     }
-    default: break;
+    reader_refill(reader);
+  }
+  const char* low = reader->data + reader->pos;
+  bool has_form;
+  IrisObject form;
+  size_t consumed;
+  size_t error_offset;
+  if (!utf8_validate(low, end - reader->pos, &error_offset)) {
+    // ill-formed bytes never reach read_form, so none of them are interned as symbols
+    form = reader_encoding_error(reader->data, reader->pos + error_offset, reader->origin);
+    has_form = true;
+    consumed = end - reader->pos;
+  } else {
+    ReaderState* state = &reader->state;
+    state->ptr = low;
+    state->end = reader->data + end;
+    reader_skip_trivia(state);
+    has_form = (state->ptr != state->end);
+    form = has_form ? read_form(state) : (IrisObject){0};
+    consumed = (size_t)(state->ptr - low);
+  }
+  reader->pos += consumed;
+  reader->scan = reader->pos;
+  reader->scan_state = (ReaderScan){0};
+  if (has_form) {
+    *result = form;
   }
-  return object_copy(obj);
+  return has_form;
 }
@@ -3,6 +3,11 @@
 
 #include "types/iris_types.h"
 
+// forms that are nested deeper are rejected with irisErrorStackError
+#ifndef IRIS_READER_DEPTH_LIMIT
+  #define IRIS_READER_DEPTH_LIMIT 4096U
+#endif
+
 /*
   @brief  Apply name and macro resolution to given object
           Should be done before passing data to eval
@@ -10,7 +15,21 @@
   @return Runnable list or error obj
 */
 // IrisObject codelist_resolve(const IrisObject, IrisScopeUnformed* scope);
-IrisObject codelist_resolve(const IrisObject, const IrisDict scope);
+IrisObject codelist_resolve(const IrisObject, const IrisMap scope);
+
+/*
+  @brief  Same as codelist_resolve, but given tree is taken and transformed in place instead of being copied
+          Names are replaced in their slots and lists are reused, on error tree is destroyed
+  @warn   Passed object is moved and should no longer be used
+*/
+IrisObject codelist_resolve_in_place(IrisObject* codelist, const IrisMap scope);
+
+/*
+  @brief  Resolve single top-level form in place, as it would be resolved as part of codelist
+          Lists are required to have function as their first element
+  @warn   Passed object is moved and should no longer be used
+*/
+IrisObject form_resolve_in_place(IrisObject* form, const IrisMap scope);
 
 /*
   @brief  Apply default reader procedure to given string
@@ -18,4 +37,57 @@ IrisObject codelist_resolve(const IrisObject, const IrisDict scope);
 */
 IrisObject string_read(const IrisString);
 
+/*
+  @brief  Same as string_read, but for borrowed byte range, for example mapped file
+          Produced objects don't reference source, so it could be released right after
+*/
+IrisObject chars_read(const char* source, size_t len);
+
+/*
+  @brief  Read whole source, strings that don't fit inline borrow their bytes from it instead of copying
+          Source is retained by every such string, so caller could release its own reference right after
+*/
+IrisObject source_read(IrisStringSource*);
+
+/*
+  @brief  Same as chars_read and source_read, but source is split by top-level forms first,
+          then parts are read on up to n_threads threads and joined in order
+          Small sources are read on calling thread
+*/
+IrisObject chars_read_parallel(const char* source, size_t len, unsigned int n_threads);
+IrisObject source_read_parallel(IrisStringSource*, unsigned int n_threads);
+
+// Incremental reader that yields one top-level form at a time, so that evaluation could start before whole source is read
+typedef struct _IrisReader IrisReader;
+
+/*
+  @brief  Read forms from source that is available whole, strings borrow their bytes from it
+*/
+IrisReader* reader_from_source(IrisStringSource*);
+
+/*
+  @brief  Read forms from stream, such as pipe or terminal
+          Buffer holds only unread bytes and grows only when single form doesn't fit into it
+*/
+IrisReader* reader_from_fd(int fd);
+
+/*
+  @brief  Set text that is printed to stdout before reading more from stream,
+          continuation is used when form that is being read is incomplete, either could be NULL
+*/
+void reader_set_prompts(IrisReader*, const char* prompt, const char* continuation_prompt);
+
+/*
+  @brief  Read next top-level form, reading errors are returned as error objects and reading could continue past them
+  @return False if there are no forms left
+*/
+bool reader_next(IrisReader*, IrisObject* result);
+
+/*
+  @brief  Override IRIS_READER_DEPTH_LIMIT for forms that are read after this call
+*/
+void reader_set_depth_limit(IrisReader*, size_t depth_limit);
+
+void reader_destroy(IrisReader**);
+
 #endif
@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "types/iris_types.h"
+#include "iris_utf8.h"
+
+// Most of sources are ASCII, so validation is built around skipping ASCII runs with vector registers,
+// multi-byte sequences are then checked one by one by strict scalar decoder
+// todo: validation of multi-byte sequences could be vectorized as well (Keiser & Lemire, 2020),
+//       it would matter for sources that are written mostly in non-Latin scripts
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #define IRIS_UTF8_X86
+  #include <immintrin.h>
+#endif
+
+typedef size_t (*Utf8AsciiProc)(const unsigned char* bytes, size_t len);
+
+/*
+  @brief  Length of leading ASCII run, eight bytes at a time
+*/
+static size_t utf8_ascii_prefix_scalar(const unsigned char* bytes, size_t len) {
+  size_t i = 0ULL;
+  for (; (i + sizeof(uint64_t)) <= len; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, bytes + i, sizeof(word));
+    if ((word & 0x8080808080808080ULL) != 0ULL) {
+      break;
+    }
+  }
+  while ((i < len) && (bytes[i] < 0x80U)) {
+    i++;
+  }
+  return i;
+}
+
+#ifdef IRIS_UTF8_X86
+// SSE2 is part of x86-64 baseline, so it doesn't require any checks
+static size_t utf8_ascii_prefix_sse2(const unsigned char* bytes, size_t len) {
+  size_t i = 0ULL;
+  for (; (i + 64ULL) <= len; i += 64ULL) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(bytes + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(bytes + i + 16U));
+    __m128i c = _mm_loadu_si128((const __m128i*)(bytes + i + 32U));
+    __m128i d = _mm_loadu_si128((const __m128i*)(bytes + i + 48U));
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0) {
+      break;
+    }
+  }
+  for (; (i + 16ULL) <= len; i += 16ULL) {
+    int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(bytes + i)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+  return i + utf8_ascii_prefix_scalar(bytes + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t utf8_ascii_prefix_avx2(const unsigned char* bytes, size_t len) {
+  size_t i = 0ULL;
+  for (; (i + 128ULL) <= len; i += 128ULL) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(bytes + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(bytes + i + 32U));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(bytes + i + 64U));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(bytes + i + 96U));
+    if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) != 0) {
+      break;
+    }
+  }
+  for (; (i + 32ULL) <= len; i += 32ULL) {
+    int mask = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(bytes + i)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+  return i + utf8_ascii_prefix_scalar(bytes + i, len - i);
+}
+#endif
+
+static Utf8AsciiProc utf8_select_ascii_proc(void) {
+  #ifdef IRIS_UTF8_X86
+  // result of cpuid is cached by runtime, so it's cheap to ask on every call
+  if (__builtin_cpu_supports("avx2")) {
+    return utf8_ascii_prefix_avx2;
+  }
+  return utf8_ascii_prefix_sse2;
+  #else
+  return utf8_ascii_prefix_scalar;
+  #endif
+}
+
+/*
+  @brief  Width of well-formed sequence that starts at given non-ASCII byte, by Table 3-7 of Unicode Standard
+  @return 0 if sequence is ill-formed: stray continuation, overlong form, surrogate, above U+10FFFF or truncated
+*/
+static unsigned int utf8_sequence_width(const unsigned char* bytes, size_t len) {
+  assert(len != 0ULL);
+  unsigned char lead = bytes[0];
+  unsigned char low = 0x80U, high = 0xBFU; // allowed range of second byte
+  unsigned int width;
+  if ((lead >= 0xC2U) && (lead <= 0xDFU)) {
+    width = 2U;
+  } else if ((lead >= 0xE0U) && (lead <= 0xEFU)) {
+    width = 3U;
+    if (lead == 0xE0U) { low = 0xA0U; }       // overlong
+    else if (lead == 0xEDU) { high = 0x9FU; } // surrogates
+  } else if ((lead >= 0xF0U) && (lead <= 0xF4U)) {
+    width = 4U;
+    if (lead == 0xF0U) { low = 0x90U; }       // overlong
+    else if (lead == 0xF4U) { high = 0x8FU; } // above U+10FFFF
+  } else {
+    return 0U;
+  }
+  if ((len < width) || (bytes[1] < low) || (bytes[1] > high)) {
+    return 0U;
+  }
+  for (unsigned int i = 2U; i < width; i++) {
+    if ((bytes[i] & 0xC0U) != 0x80U) {
+      return 0U;
+    }
+  }
+  return width;
+}
+
+bool utf8_validate(const char* bytes, size_t len, size_t* error_offset) {
+  assert((bytes != NULL) || (len == 0ULL));
+  const unsigned char* ptr = (const unsigned char*)bytes;
+  Utf8AsciiProc ascii_prefix = utf8_select_ascii_proc();
+  size_t i = 0ULL;
+  while (i < len) {
+    i += ascii_prefix(ptr + i, len - i);
+    while ((i < len) && (ptr[i] >= 0x80U)) {
+      unsigned int width = utf8_sequence_width(ptr + i, len - i);
+      if (width == 0U) {
+        if (error_offset != NULL) {
+          *error_offset = i;
+        }
+        return false;
+      }
+      i += width;
+    }
+  }
+  return true;
+}
+
+size_t utf8_count(const char* bytes, size_t len) {
+  assert((bytes != NULL) || (len == 0ULL));
+  // every codepoint has exactly one byte that isn't continuation byte, 0b10xxxxxx
+  const signed char* ptr = (const signed char*)bytes;
+  size_t result = 0ULL;
+  size_t i = 0ULL;
+  #ifdef IRIS_UTF8_X86
+  const __m128i continuation_bound = _mm_set1_epi8(-65); // 0xBF as signed, continuation bytes are below it
+  for (; (i + 16ULL) <= len; i += 16ULL) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(ptr + i));
+    result += (size_t)__builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(chunk, continuation_bound)));
+  }
+  #endif
+  for (; i < len; i++) {
+    result += (ptr[i] > -65) ? 1U : 0U;
+  }
+  return result;
+}
@@ -1,11 +1,14 @@
 #ifndef IRIS_UTF8_H
 #define IRIS_UTF8_H
 
+#include <stddef.h>
+#include <stdbool.h>
+
 #include "iris_utils.h"
 
 /*
   @brief  Check to what codepoint width given octet corresponds
-  @warn   Should be valid starting UTF-8 octet
+  @return 0 if octet cannot start codepoint
 */
 __forceinline unsigned int utf8_codepoint_width(char ch) {
   if (!(ch & 0b10000000)) {
@@ -14,47 +17,38 @@ __forceinline unsigned int utf8_codepoint_width(char ch) {
     return 2U;
   } else if (!(ch & 0b00010000) && ((ch & 0b11100000) == 0b11100000)) {
     return 3U;
-  } else if (!(ch & 0b00001000) && ((ch & 0b11110000) == 0b11110000)) { // should we care about ISO/IEC 10646?
+  } else if (!(ch & 0b00001000) && ((ch & 0b11110000) == 0b11110000)) {
     return 4U;
   }
-  panic("invalid utf8 codepoint");
+  return 0U;
 }
 
 // todo: skip BOM? windows is bitch with it
+/*
+  @brief  Strict check of UTF-8 encoding, rejects overlong forms, surrogates and codepoints above U+10FFFF
+          ASCII runs are skipped with widest vector extension that is available at runtime
+  @return False if bytes are ill-formed, error_offset then receives position of first offending byte, it could be NULL
+*/
+bool utf8_validate(const char* bytes, size_t len, size_t* error_offset);
+
+/*
+  @brief  Number of codepoints in bytes
+  @warn   Bytes should be valid UTF-8
+*/
+size_t utf8_count(const char* bytes, size_t len);
+
+__forceinline bool utf8_check_bytes(const char* bytes, size_t len) {
+  return utf8_validate(bytes, len, NULL);
+}
+
 __forceinline bool utf8_check_validity(const IrisString str) {
-  const char* ptr = str.data;
-  while (ptr < &str.data[str.len]) {
-    if ((*ptr & 0b10000000) & (!(*ptr & 0b01000000))) {
-      // first bit cannot be 1 and then followed by 0
-      return false;
-    }
-    unsigned int width = utf8_codepoint_width(*ptr);
-    if ((ptr + width) > &str.data[str.len]) {
-      // codepoint is outside of string bounds
-      return false;
-    }
-    ptr++;
-    for (unsigned int i = 0U; i < width - 1U; i++) {
-      // each octet should start with 0b10xxxxxx
-      if (!(*ptr & 0b10000000) || (*ptr & 0b01000000)) {
-        return false;
-      }
-      ptr++;
-    }
-  }
-  return true;
+  return utf8_validate(string_bytes(str), str.len, NULL);
 }
 
 __forceinline size_t utf8_count_chars(const IrisString str) {
-  size_t result = 0;
-  const char* ptr = str.data;
-  while (ptr < &str.data[str.len]) {
-    ptr += utf8_codepoint_width(*ptr);
-    result++;
-  }
-  return result;
+  return utf8_count(string_bytes(str), str.len);
 }
 
-#define ascii_cmp(ch, c_ch) (utf8_codepoint_width(ch) == 1U) && (ch == c_ch)
+#define ascii_cmp(ch, c_ch) ((utf8_codepoint_width(ch) == 1U) && ((ch) == (c_ch)))
 
 #endif
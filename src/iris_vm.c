@@ -0,0 +1,285 @@
+#include <stdint.h>
+#include <assert.h>
+
+#include "iris_vm.h"
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_utils.h"
+#include "iris_profile.h"
+#include "iris_jit.h"
+
+// todo: constant folding and caching of compiled chunks for code that is evaluated more than once, such as function bodies
+// todo: macros still have their arguments evaluated, as in eval_object
+
+#if defined(__GNUC__)
+  #define IRIS_VM_COMPUTED_GOTO // labels as values are GNU extension
+#endif
+
+#define VM_PREALLOC 64U
+
+struct _IrisVm {
+  uint32_t* code;
+  size_t code_len;
+  size_t code_cap;
+  const IrisObject** constants; // borrowed from compiled code
+  size_t n_constants;
+  size_t constants_cap;
+  IrisObject* stack;
+  bool* owned; // per stack slot, false if value is a borrowed constant that shouldn't be destroyed
+  size_t stack_cap;
+  size_t depth;     // stack depth at current point of compilation
+  size_t max_depth; // stack size that compiled code requires
+  #ifdef IRIS_USE_TCC
+  IrisJit* jit; // hot chunks are run natively
+  #endif
+};
+
+IrisVm* vm_new(void) {
+  IrisVm* result = iris_alloc0(1, IrisVm);
+  #ifdef IRIS_USE_TCC
+  result->jit = jit_new();
+  #endif
+  return result;
+}
+
+void vm_destroy(IrisVm** vm) {
+  assert(vm != NULL);
+  assert(pointer_is_valid(*vm));
+  if ((*vm)->code != NULL) { iris_free((*vm)->code); }
+  if ((*vm)->constants != NULL) { iris_free((void*)(*vm)->constants); }
+  if ((*vm)->stack != NULL) { iris_free((*vm)->stack); }
+  if ((*vm)->owned != NULL) { iris_free((*vm)->owned); }
+  #ifdef IRIS_USE_TCC
+  jit_destroy(&(*vm)->jit);
+  #endif
+  iris_free(*vm);
+  *vm = NULL;
+}
+
+/*
+  @brief  Capacity that fits at least required elements, grown geometrically
+*/
+static size_t vm_grown_cap(size_t cap, size_t required) {
+  size_t result = (cap == 0ULL) ? VM_PREALLOC : cap;
+  while (result < required) {
+    result *= 2ULL;
+  }
+  return result;
+}
+
+// buffers outlive evaluation of any particular form, so they're always grown on heap, even when arena is bound
+
+static void vm_grow_code(IrisVm* vm, size_t n) {
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  vm->code_cap = vm_grown_cap(vm->code_cap, vm->code_len + n);
+  vm->code = iris_resize(vm->code, vm->code_cap, uint32_t);
+  arena_bind(arena);
+}
+
+static void vm_reserve_stack(IrisVm* vm, size_t n) {
+  if (n > vm->stack_cap) {
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    vm->stack_cap = vm_grown_cap(vm->stack_cap, n);
+    vm->stack = iris_resize(vm->stack, vm->stack_cap, IrisObject);
+    vm->owned = iris_resize(vm->owned, vm->stack_cap, bool);
+    arena_bind(arena);
+  }
+}
+
+static void vm_grow_constants(IrisVm* vm) {
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  vm->constants_cap = vm_grown_cap(vm->constants_cap, vm->n_constants + 1ULL);
+  vm->constants = (const IrisObject**)iris_resize((void*)vm->constants, vm->constants_cap, const IrisObject*);
+  arena_bind(arena);
+}
+
+// compilation is done for every evaluated form, so emitting is kept inline and out of slow paths
+
+static inline uint32_t vm_push_constant(IrisVm* vm, const IrisObject* obj) {
+  if (vm->n_constants == vm->constants_cap) {
+    vm_grow_constants(vm);
+  }
+  // every constant is a distinct object in memory, so their count couldn't realistically overflow
+  assert(vm->n_constants < UINT32_MAX);
+  vm->constants[vm->n_constants] = obj;
+  return (uint32_t)vm->n_constants++;
+}
+
+static inline void vm_emit(IrisVm* vm, IrisVmOp op, const uint32_t* operands, size_t n_operands) {
+  if ((vm->code_len + 1ULL + n_operands) > vm->code_cap) {
+    vm_grow_code(vm, 1ULL + n_operands);
+  }
+  uint32_t* code = vm->code + vm->code_len;
+  code[0] = (uint32_t)op;
+  for (size_t i = 0ULL; i < n_operands; i++) {
+    code[i + 1ULL] = operands[i];
+  }
+  vm->code_len += 1ULL + n_operands;
+}
+
+static inline void vm_adjust_depth(IrisVm* vm, size_t popped, size_t pushed) {
+  assert(vm->depth >= popped);
+  vm->depth = vm->depth - popped + pushed;
+  if (vm->depth > vm->max_depth) {
+    vm->max_depth = vm->depth;
+  }
+}
+
+static void vm_reset(IrisVm* vm) {
+  vm->code_len = 0ULL;
+  vm->n_constants = 0ULL;
+  vm->depth = 0ULL;
+  vm->max_depth = 0ULL;
+}
+
+/*
+  @brief  Emit code that leaves result of evaluation of object on top of stack
+          Arguments are evaluated left to right before call, the same order in which eval_object does it
+*/
+static void vm_compile_object(IrisVm* vm, const IrisObject* obj) {
+  assert(object_is_valid(*obj));
+  if ((obj->kind == irisObjectKindList) &&
+      (obj->list_variant->len > 0ULL) &&
+      (obj->list_variant->items[0].kind == irisObjectKindFunc)) {
+    const IrisList* list = obj->list_variant;
+    for (size_t i = 1ULL; i < list->len; i++) {
+      vm_compile_object(vm, &list->items[i]);
+    }
+    iris_check((list->len - 1ULL) <= UINT32_MAX, "too many arguments for bytecode call");
+    uint32_t operands[2] = { vm_push_constant(vm, &list->items[0]), (uint32_t)(list->len - 1ULL) };
+    vm_emit(vm, irisVmOpCall, operands, 2ULL);
+    vm_adjust_depth(vm, list->len - 1ULL, 1ULL);
+  } else {
+    uint32_t idx = vm_push_constant(vm, obj);
+    vm_emit(vm, irisVmOpPushConst, &idx, 1ULL);
+    vm_adjust_depth(vm, 0ULL, 1ULL);
+  }
+}
+
+/*
+  @brief  Destroy values that were produced by calls, borrowed ones are left alone
+*/
+static inline void vm_release(IrisObject* values, const bool* owned, size_t count) {
+  for (size_t i = 0ULL; i < count; i++) {
+    if (owned[i]) {
+      object_destroy(&values[i]);
+    }
+  }
+}
+
+static IrisObject vm_run(IrisVm* vm) {
+  IRIS_PROFILE_ZONE("eval");
+  assert(vm->code_len != 0ULL);
+  vm_reserve_stack(vm, vm->max_depth);
+  const uint32_t* ip = vm->code;
+  const IrisObject** constants = vm->constants;
+  IrisObject* stack = vm->stack;
+  bool* owned = vm->owned;
+  size_t sp = 0ULL;
+
+  #ifdef IRIS_VM_COMPUTED_GOTO
+  static const void* const dispatch_table[N_VM_OPS] = {
+    [irisVmOpPushConst] = &&vm_label_irisVmOpPushConst,
+    [irisVmOpCall] = &&vm_label_irisVmOpCall,
+    [irisVmOpPop] = &&vm_label_irisVmOpPop,
+    [irisVmOpReturn] = &&vm_label_irisVmOpReturn,
+  };
+  #define vm_case(op) vm_label_##op:
+  #define vm_dispatch() goto *dispatch_table[*ip++]
+  vm_dispatch();
+  #else
+  #define vm_case(op) case op:
+  #define vm_dispatch() continue
+  for (;;) switch ((IrisVmOp)*ip++) {
+  #endif
+
+    vm_case(irisVmOpPushConst) {
+      stack[sp] = *constants[ip[0]];
+      owned[sp] = false;
+      sp++;
+      ip += 1;
+      vm_dispatch();
+    }
+
+    vm_case(irisVmOpCall) {
+      const IrisFunc* func = constants[ip[0]]->func_variant;
+      size_t arg_count = (size_t)ip[1];
+      ip += 2;
+      assert(sp >= arg_count);
+      sp -= arg_count;
+      IrisObject result = func_call(*func, stack + sp, arg_count);
+      vm_release(stack + sp, owned + sp, arg_count);
+      if (result.kind == irisObjectKindError) {
+        vm_release(stack, owned, sp);
+        return result;
+      }
+      stack[sp] = result;
+      owned[sp] = true;
+      sp++;
+      vm_dispatch();
+    }
+
+    vm_case(irisVmOpPop) {
+      assert(sp != 0ULL);
+      sp--;
+      if (owned[sp]) {
+        object_destroy(&stack[sp]);
+      }
+      vm_dispatch();
+    }
+
+    vm_case(irisVmOpReturn) {
+      assert(sp == 1ULL);
+      // borrowed constants are copied only once they leave the machine
+      return owned[0] ? stack[0] : object_copy(stack[0]);
+    }
+
+  #ifndef IRIS_VM_COMPUTED_GOTO
+    default:
+      panic("unknown bytecode operation");
+  }
+  #endif
+  #undef vm_case
+  #undef vm_dispatch
+}
+
+static IrisObject vm_execute(IrisVm* vm) {
+  #ifdef IRIS_USE_TCC
+  IrisJitProc proc = jit_lookup(vm->jit, vm->code, vm->code_len, vm->constants, vm->max_depth);
+  if (proc != NULL) {
+    return proc(vm->constants);
+  }
+  #endif
+  return vm_run(vm);
+}
+
+IrisObject vm_eval_object(IrisVm* vm, const IrisObject obj) {
+  assert(pointer_is_valid(vm));
+  assert(object_is_valid(obj));
+  vm_reset(vm);
+  vm_compile_object(vm, &obj);
+  vm_emit(vm, irisVmOpReturn, NULL, 0ULL);
+  return vm_execute(vm);
+}
+
+IrisObject vm_eval_codelist(IrisVm* vm, const IrisList list) {
+  assert(pointer_is_valid(vm));
+  assert(list_is_valid(list));
+  if (list.len == 0ULL) {
+    return (IrisObject){0}; // nil
+  }
+  vm_reset(vm);
+  for (size_t i = 0ULL; i < list.len; i++) {
+    if (i != 0ULL) {
+      vm_emit(vm, irisVmOpPop, NULL, 0ULL);
+      vm_adjust_depth(vm, 1ULL, 0ULL);
+    }
+    vm_compile_object(vm, &list.items[i]);
+  }
+  vm_emit(vm, irisVmOpReturn, NULL, 0ULL);
+  return vm_execute(vm);
+}
@@ -0,0 +1,38 @@
+#ifndef IRIS_VM_H
+#define IRIS_VM_H
+
+#include "types/iris_types.h"
+
+// Resolved code is compiled into flat bytecode of stack machine before evaluation,
+// which replaces recursive walk over the tree by a single dispatch loop over contiguous value stack
+// Every form is compiled anew before it's run and top-level forms are run only once, so compilation isn't
+// paid back and vm is slower than tree walking for now, see vm case of iris-bench
+
+typedef enum {
+  irisVmOpPushConst,  // idx : push constant, it's borrowed from compiled tree and isn't copied
+  irisVmOpCall,       // idx argc : call func constant with argc topmost values, which are replaced by result
+  irisVmOpPop,        // discard topmost value
+  irisVmOpReturn,     // topmost value is the result
+  N_VM_OPS
+} IrisVmOp;
+
+// opaque type, code and stack buffers of which are reused between evaluations
+typedef struct _IrisVm IrisVm;
+
+IrisVm* vm_new(void);
+void vm_destroy(IrisVm**);
+
+/*
+  @brief  Compile resolved form to bytecode and evaluate it, result is the same as of eval_object
+  @warn   Constants are borrowed from form, so it should be kept intact until evaluation is done
+          Machine isn't reentrant, builtins shouldn't evaluate through the same one
+*/
+IrisObject vm_eval_object(IrisVm*, const IrisObject);
+
+/*
+  @brief  Compile resolved codelist to bytecode and evaluate it, result is the same as of eval_codelist
+  @warn   Same as for vm_eval_object
+*/
+IrisObject vm_eval_codelist(IrisVm*, const IrisList);
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "iris.h"
 #include "iris_misc.h"
+#include "iris_jit.h"
 
 // todo: interpreter instances should be incapsulated and not rely on any global data
 //       as all data they share is const they should be able to run concurrently
@@ -12,7 +13,12 @@ const char* help_text =
   "| compiled -- "__DATE__"\n"
   "| commands:\n"
   "|   r         : enter interactive REPL mode\n"
-  "|   f <file>  : evaluate file\n"
+  "|   f <file>  : evaluate file, '-' reads from stdin\n"
+  "|   c <file>  : translate file to C, written to <file>.c\n"
+  "|   -j <n>    : read files on n threads, should precede f\n"
+  "|   -b        : experimental, evaluate through bytecode vm, should precede r or f\n"
+  "|               every form is compiled before it's run, so it's slower than default mode,\n"
+  "|               hot code is compiled natively in builds with IRIS_USE_TCC\n"
   "|   -h --help : show this\n";
 
 /*
@@ -29,12 +35,12 @@ void run_with_args(const IrisList argument_list) {
     if (item.kind != irisObjectKindString) {
       continue;
     }
-    if (string_compare_chars(item.string_variant, "-h") ||
-        string_compare_chars(item.string_variant, "--help")) {
+    if (string_compare_chars(*item.string_variant, "-h") ||
+        string_compare_chars(*item.string_variant, "--help")) {
       (void)fputs(help_text, stdout);
-    } else if (string_compare_chars(item.string_variant, "r")) {
+    } else if (string_compare_chars(*item.string_variant, "r")) {
       enter_repl();
-    } else if (string_compare_chars(item.string_variant, "f")) {
+    } else if (string_compare_chars(*item.string_variant, "f")) {
       if (i == argument_list.len - 1ULL) {
         panic("filename unspecified");
       }
@@ -42,7 +48,37 @@ void run_with_args(const IrisList argument_list) {
       if (file.kind != irisObjectKindString) {
         panic("filename should be string");
       }
-      eval_file(file.string_variant);
+      eval_file(*file.string_variant);
+      i++;
+    } else if (string_compare_chars(*item.string_variant, "c")) {
+      if (i == argument_list.len - 1ULL) {
+        panic("filename unspecified");
+      }
+      IrisObject file = argument_list.items[i + 1ULL];
+      if (file.kind != irisObjectKindString) {
+        panic("filename should be string");
+      }
+      transpile_file(*file.string_variant);
+      i++;
+    } else if (string_compare_chars(*item.string_variant, "-b")) {
+      eval_set_mode(irisEvalModeBytecode);
+    } else if (string_compare_chars(*item.string_variant, "-j")) {
+      if (i == argument_list.len - 1ULL) {
+        panic("number of threads unspecified");
+      }
+      IrisObject count = argument_list.items[i + 1ULL];
+      if ((count.kind != irisObjectKindString) || (count.string_variant->len > 9ULL)) {
+        panic("number of threads should be positive integer");
+      }
+      unsigned int n_threads = 0U;
+      for (size_t c = 0ULL; c < count.string_variant->len; c++) {
+        char ch = string_nth(*count.string_variant, c);
+        if ((ch < '0') || (ch > '9')) {
+          panic("number of threads should be positive integer");
+        }
+        n_threads = n_threads * 10U + (unsigned int)(ch - '0');
+      }
+      eval_set_read_threads(n_threads);
       i++;
     } else {
       panic("unknown option");
@@ -59,5 +95,8 @@ int main(int argc, const char* argv[]) {
   #ifdef IRIS_COLLECT_MEMORY_METRICS
   iris_metrics_print_repr();
   #endif
+  #ifdef IRIS_USE_TCC
+  jit_metrics_print_repr();
+  #endif
   return 0;
 }
@@ -1,122 +1,269 @@
 #include <types/iris_string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
+#include <limits.h>
 
 #include "types/iris_types.h"
 #include "iris_utils.h"
 #include "iris_memory.h"
 
-#define DICT_PREALLOC 4U
-#define DICT_GROW_FACTOR 4U // == 1 - (1 / 4) // capacity multiplies by two when factor is equal or greater than cardinality
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+  #include <emmintrin.h>
+  #define DICT_USE_SSE2
+#endif
 
-static_assert(DICT_PREALLOC > 0U && (DICT_PREALLOC & (DICT_PREALLOC - 1U)) == 0U, "starting bucket capacity of dict should be power of 2");
-static_assert(DICT_GROW_FACTOR > 1U, "invalid dict grow factor");
+#define DICT_PREALLOC 8U // allocated on the first push
+#define DICT_GROUP 16U   // control bytes that are compared at once
+#define DICT_CTRL_EMPTY 0x80U
 
-typedef struct {
-  size_t key; // hash
+static_assert(DICT_PREALLOC > 0U && (DICT_PREALLOC & (DICT_PREALLOC - 1U)) == 0U, "starting capacity of dict should be power of 2");
+
+typedef struct _IrisDictSlot {
+  size_t hash; // mixed hash of key, kept for rehashing and shifting on erasure
+  IrisObject key;
   IrisObject item;
-} IrisDictPair;
+} IrisDictSlot;
 
-typedef struct _IrisDictBucket {
-  // dict buckets are implemented as vectors
-  IrisDictPair* pairs;
-  size_t len;
-} IrisDictBucket;
+/*
+  @brief  Spread bits of object hash, as integers hash to themselves
+          Low bits pick starting slot, while high ones go to control byte
+*/
+static inline size_t dict_mix(size_t hash) {
+  uint64_t h = (uint64_t)hash * 0x9e3779b97f4a7c15ULL;
+  return (size_t)(h ^ (h >> 32U));
+}
 
-IrisDict dict_new() {
-  IrisDict result = {
-    .buckets = iris_alloc0(DICT_PREALLOC, IrisDictBucket),
-    .cap = DICT_PREALLOC,
-    .card = 0ULL,
-  };
+static inline uint8_t dict_h2(size_t hash) {
+  return (uint8_t)(hash >> ((sizeof(size_t) * CHAR_BIT) - 7U));
+}
+
+/*
+  @brief  Bit mask of control bytes in group that are equal to given 7 bits of hash
+*/
+static inline uint32_t dict_group_match(const uint8_t* group, uint8_t h2) {
+  #ifdef DICT_USE_SSE2
+  __m128i bytes = _mm_loadu_si128((const __m128i*)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)h2)));
+  #else
+  uint32_t result = 0U;
+  for (uint32_t i = 0U; i < DICT_GROUP; i++) {
+    result |= (uint32_t)(group[i] == h2) << i;
+  }
   return result;
+  #endif
 }
 
-IrisDict dict_copy(const IrisDict dict) {
-  assert(dict_is_valid(dict));
-  IrisDict result = {
-    .buckets = iris_alloc(dict.cap, IrisDictBucket),
-    .cap = dict.cap,
-    .card = dict.card,
-  };
-  for (size_t b = 0ULL; b < dict.cap; b++) {
-    result.buckets[b].pairs = iris_alloc(dict.buckets[b].len, IrisDictPair);
-    result.buckets[b].len = dict.buckets[b].len;
-    for (size_t p = 0ULL; p < dict.buckets[b].len; p++) {
-      result.buckets[b].pairs[p].item = object_copy(dict.buckets[b].pairs[p].item);
-      result.buckets[b].pairs[p].key = dict.buckets[b].pairs[p].key;
-    }
+/*
+  @brief  Bit mask of empty slots in group
+*/
+static inline uint32_t dict_group_empty(const uint8_t* group) {
+  #ifdef DICT_USE_SSE2
+  // only empty marker has high bit set
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+  #else
+  uint32_t result = 0U;
+  for (uint32_t i = 0U; i < DICT_GROUP; i++) {
+    result |= (uint32_t)(group[i] == DICT_CTRL_EMPTY) << i;
   }
   return result;
+  #endif
+}
+
+static inline bool dict_slot_is_full(const IrisDict* dict, size_t idx) {
+  return dict->ctrl[idx] != DICT_CTRL_EMPTY;
+}
+
+static inline void dict_set_ctrl(IrisDict* dict, size_t idx, uint8_t value) {
+  dict->ctrl[idx] = value;
+  // bytes of the first group are mirrored past the end, so that group that is loaded near the end sees the beginning
+  // with less slots than group has, probing stops at empty one before unmirrored bytes are reached
+  if (idx < DICT_GROUP) {
+    dict->ctrl[dict->cap + idx] = value;
+  }
+}
+
+/*
+  @brief  Allocate slots and control bytes in a single block, every slot is empty
+*/
+static void dict_alloc(IrisDict* dict, size_t cap) {
+  assert((cap & (cap - 1ULL)) == 0ULL);
+  uint8_t* block = iris_alloc_kind((cap * sizeof(IrisDictSlot)) + cap + DICT_GROUP, uint8_t, irisObjectKindDict);
+  dict->slots = (IrisDictSlot*)block;
+  dict->ctrl = block + (cap * sizeof(IrisDictSlot));
+  dict->cap = cap;
+  memset(dict->ctrl, DICT_CTRL_EMPTY, cap + DICT_GROUP);
+}
+
+/*
+  @brief  Keys are equal if they're equal objects, but also symbols and strings of the same name are, as they hash the same
+*/
+static inline bool dict_key_equal(const IrisObject x, const IrisObject y) {
+  if (x.kind == y.kind) {
+    return object_equal(x, y);
+  } else if ((x.kind == irisObjectKindSymbol) && (y.kind == irisObjectKindString)) {
+    return string_equal(*symbol_name(x.symbol_variant), *y.string_variant);
+  } else if ((x.kind == irisObjectKindString) && (y.kind == irisObjectKindSymbol)) {
+    return string_equal(*x.string_variant, *symbol_name(y.symbol_variant));
+  }
+  return false;
+}
+
+/*
+  @brief  Index of slot that holds given key or SIZE_MAX if there's none
+*/
+static size_t dict_find_slot(const IrisDict* dict, const IrisObject key, size_t hash) {
+  if (dict->cap == 0ULL) {
+    return SIZE_MAX;
+  }
+  size_t mask = dict->cap - 1ULL;
+  uint8_t h2 = dict_h2(hash);
+  size_t pos = hash & mask;
+  for (;;) {
+    const uint8_t* group = dict->ctrl + pos;
+    uint32_t empty = dict_group_empty(group);
+    uint32_t match = dict_group_match(group, h2);
+    if (empty != 0U) {
+      // probe sequence ends at the first empty slot
+      match &= (empty & (~empty + 1U)) - 1U;
+    }
+    while (match != 0U) {
+      size_t idx = (pos + (size_t)__builtin_ctz(match)) & mask;
+      if (dict_key_equal(dict->slots[idx].key, key)) {
+        return idx;
+      }
+      match &= match - 1U;
+    }
+    if (empty != 0U) {
+      return SIZE_MAX;
+    }
+    pos = (pos + DICT_GROUP) & mask;
+  }
 }
 
-// todo: we shouldn't have two versions of funcs, they make maintaining harder
-// todo: inline in dict_destroy?
-__forceinline void dict_free_buckets(IrisDictBucket* buckets, size_t len) {
-  assert(pointer_is_valid(buckets));
-  for (size_t b = 0ULL; b < len; b++) {
-    assert((buckets[b].len > 0 && pointer_is_valid(buckets[b].pairs)) ||
-      (buckets[b].len == 0 && !pointer_is_valid(buckets[b].pairs))
-    );
-    for (size_t p = 0ULL; p < buckets[b].len; p++) {
-      object_destroy(&buckets[b].pairs[p].item);
+/*
+  @brief  Same as dict_find_slot, but for symbol key, which is the case of every scope lookup
+          Symbols are compared by id in place, probe falls back to generic one only if string key is met
+*/
+static size_t dict_find_symbol_slot(const IrisDict* dict, const IrisObject key, size_t hash) {
+  assert(key.kind == irisObjectKindSymbol);
+  if (dict->cap == 0ULL) {
+    return SIZE_MAX;
+  }
+  size_t mask = dict->cap - 1ULL;
+  uint8_t h2 = dict_h2(hash);
+  size_t pos = hash & mask;
+  for (;;) {
+    const uint8_t* group = dict->ctrl + pos;
+    uint32_t empty = dict_group_empty(group);
+    uint32_t match = dict_group_match(group, h2);
+    if (empty != 0U) {
+      match &= (empty & (~empty + 1U)) - 1U;
+    }
+    while (match != 0U) {
+      const IrisObject* candidate = &dict->slots[(pos + (size_t)__builtin_ctz(match)) & mask].key;
+      if (candidate->kind != irisObjectKindSymbol) {
+        return dict_find_slot(dict, key, hash);
+      }
+      if (candidate->symbol_variant.id == key.symbol_variant.id) {
+        return (pos + (size_t)__builtin_ctz(match)) & mask;
+      }
+      match &= match - 1U;
     }
-    if (buckets[b].len > 0) {
-      iris_free(buckets[b].pairs);
+    if (empty != 0U) {
+      return SIZE_MAX;
     }
+    pos = (pos + DICT_GROUP) & mask;
   }
-  iris_free(buckets);
 }
 
-// todo: just inline in dict_grow?
-__forceinline void dict_free_buckets_after_move(IrisDictBucket* buckets, size_t len) {
-  for (size_t b = 0ULL; b < len; b++) {
-    assert((buckets[b].len > 0 && pointer_is_valid(buckets[b].pairs)) ||
-      (buckets[b].len == 0 && !pointer_is_valid(buckets[b].pairs))
-    );
-    if (buckets[b].len > 0) {
-      iris_free(buckets[b].pairs);
+/*
+  @brief  Index of the first empty slot in probe sequence of hash
+*/
+static size_t dict_probe_empty(const IrisDict* dict, size_t hash) {
+  size_t mask = dict->cap - 1ULL;
+  size_t pos = hash & mask;
+  for (;;) {
+    uint32_t empty = dict_group_empty(dict->ctrl + pos);
+    if (empty != 0U) {
+      return (pos + (size_t)__builtin_ctz(empty)) & mask;
     }
+    pos = (pos + DICT_GROUP) & mask;
   }
-  iris_free(buckets);
 }
 
-__forceinline void dict_grow(IrisDict* dict) {
-  if (dict->card >= (dict->cap - (dict->cap / DICT_GROW_FACTOR))) {
-    size_t new_cap = dict->cap << 1ULL;
-    IrisDictBucket* new_buckets = iris_alloc0(new_cap, IrisDictBucket);
-    for (size_t b = 0; b < dict->cap; b++) {
-      for (size_t p = 0; p < dict->buckets[b].len; p++) {
-        size_t idx = dict->buckets[b].pairs[p].key % new_cap;
-        new_buckets[idx].pairs = iris_resize(new_buckets[idx].pairs, new_buckets[idx].len + 1ULL, IrisDictPair);
-        new_buckets[idx].pairs[new_buckets[idx].len] = dict->buckets[b].pairs[p];
-        new_buckets[idx].len++;
-      }
+/*
+  @brief  Make room for one more pair, table is kept at most 7/8 full, so that there's always empty slot to stop probing
+*/
+static void dict_grow(IrisDict* dict) {
+  if (dict->cap == 0ULL) {
+    dict_alloc(dict, DICT_PREALLOC);
+    return;
+  }
+  if ((dict->card + 1ULL) <= (dict->cap - (dict->cap / 8ULL))) {
+    return;
+  }
+  IrisDict old = *dict;
+  dict_alloc(dict, old.cap * 2ULL);
+  // pairs are moved as they are, every key is known to be distinct
+  for (size_t i = 0ULL; i < old.cap; i++) {
+    if (dict_slot_is_full(&old, i)) {
+      size_t idx = dict_probe_empty(dict, old.slots[i].hash);
+      dict->slots[idx] = old.slots[i];
+      dict_set_ctrl(dict, idx, old.ctrl[i]);
     }
-    dict_free_buckets_after_move(dict->buckets, dict->cap);
-    dict->buckets = new_buckets;
-    dict->cap = new_cap;
   }
+  iris_free(old.slots);
 }
 
-static void dict_push(IrisDict* dict, size_t key, IrisObject obj) {
-  dict_grow(dict);
-  size_t idx = key % dict->cap;
-  for (size_t i = 0; i < dict->buckets[idx].len; i++) {
-    if (dict->buckets[idx].pairs[i].key == key) {
-      object_destroy(&dict->buckets[idx].pairs[i].item);
-      dict->buckets[idx].pairs[i].item = obj;
-      return;
+IrisDict dict_new() {
+  return (IrisDict){0};
+}
+
+/*
+  @brief  Table of the same layout, which pairs are made by given copy function
+*/
+static IrisDict dict_duplicate(const IrisDict dict, IrisObject (*copy)(const IrisObject)) {
+  assert(dict_is_valid(dict));
+  IrisDict result = dict_new();
+  if (dict.cap == 0ULL) {
+    return result;
+  }
+  dict_alloc(&result, dict.cap);
+  memcpy(result.ctrl, dict.ctrl, dict.cap + DICT_GROUP);
+  for (size_t i = 0ULL; i < dict.cap; i++) {
+    if (dict_slot_is_full(&dict, i)) {
+      result.slots[i] = (IrisDictSlot){
+        .hash = dict.slots[i].hash,
+        .key = copy(dict.slots[i].key),
+        .item = copy(dict.slots[i].item),
+      };
     }
   }
-  dict->buckets[idx].pairs = iris_resize(
-    dict->buckets[idx].pairs,
-    dict->buckets[idx].len + 1ULL,
-    IrisDictPair
-  );
-  dict->buckets[idx].pairs[dict->buckets[idx].len].item = obj;
-  dict->buckets[idx].pairs[dict->buckets[idx].len].key = key;
-  dict->buckets[idx].len++;
+  result.card = dict.card;
+  return result;
+}
+
+IrisDict dict_copy(const IrisDict dict) {
+  return dict_duplicate(dict, object_copy);
+}
+
+IrisDict dict_clone(const IrisDict dict) {
+  return dict_duplicate(dict, object_clone);
+}
+
+static void dict_push(IrisDict* dict, const IrisObject key, IrisObject obj) {
+  size_t hash = dict_mix(object_hash(key));
+  size_t idx = dict_find_slot(dict, key, hash);
+  if (idx != SIZE_MAX) {
+    object_destroy(&dict->slots[idx].item);
+    dict->slots[idx].item = obj;
+    return;
+  }
+  dict_grow(dict);
+  idx = dict_probe_empty(dict, hash);
+  dict->slots[idx] = (IrisDictSlot){ .hash = hash, .key = object_copy(key), .item = obj };
+  dict_set_ctrl(dict, idx, dict_h2(hash));
   dict->card++;
 }
 
@@ -125,7 +272,7 @@ void dict_push_object(IrisDict* dict, const IrisObject key, IrisObject* item) {
   assert(object_is_valid(key));
   assert(object_is_valid(*item));
   // iris_check(key != item, "can't push item to dict with itself as a key");
-  dict_push(dict, object_hash(key), *item);
+  dict_push(dict, key, *item);
   // object_move(key);
   object_move(item);
 }
@@ -134,7 +281,7 @@ void dict_push_string(IrisDict* dict, const IrisObject key, IrisString* str) {
   assert(dict_is_valid(*dict));
   assert(object_is_valid(key));
   assert(string_is_valid(*str));
-  dict_push(dict, object_hash(key), string_to_object(*str));
+  dict_push(dict, key, string_to_object(*str));
   string_move(str);
 }
 
@@ -142,7 +289,7 @@ void dict_push_func(IrisDict* dict, const IrisObject key, IrisFunc* func) {
   assert(dict_is_valid(*dict));
   assert(object_is_valid(key));
   assert(func_is_valid(*func));
-  dict_push(dict, object_hash(key), func_to_object(*func));
+  dict_push(dict, key, func_to_object(*func));
   func_move(func);
 }
 
@@ -150,107 +297,102 @@ void dict_push_list(IrisDict* dict, const IrisObject key, IrisList* list) {
   assert(dict_is_valid(*dict));
   assert(object_is_valid(key));
   assert(list_is_valid(*list));
-  dict_push(dict, object_hash(key), list_to_object(*list));
+  dict_push(dict, key, list_to_object(*list));
   list_move(list);
 }
 
-bool dict_has(const IrisDict dict, const IrisObject key) {
+const IrisObject* dict_find(const IrisDict dict, const IrisObject key) {
   assert(dict_is_valid(dict));
   assert(object_is_valid(key));
-  size_t hash = object_hash(key);
-  size_t idx = hash % dict.cap;
-  for (size_t i = 0; i < dict.buckets[idx].len; i++) {
-    if (dict.buckets[idx].pairs[i].key == hash) {
-      return true;
-    }
-  }
-  return false;
+  size_t hash = dict_mix(object_hash(key));
+  size_t idx = (key.kind == irisObjectKindSymbol) ? dict_find_symbol_slot(&dict, key, hash) : dict_find_slot(&dict, key, hash);
+  return (idx != SIZE_MAX) ? &dict.slots[idx].item : NULL;
 }
 
-// todo: should it resize the memory block?
-//       it should be okay that bucket forgets its capacity, as it will not attempt to use junk
-//       but memory will be freed only on next insertion in the same bucket which is quite random
-//       we could probably introduce some switch IRIS_KEEP_MINIMUM_RAM_USAGE for always shrinking memory to minimum
+bool dict_has(const IrisDict dict, const IrisObject key) {
+  return dict_find(dict, key) != NULL;
+}
+
+// todo: capacity isn't shrunk, table that was emptied keeps its size until it's destroyed
 void dict_erase(IrisDict* dict, const IrisObject key) {
   assert(dict_is_valid(*dict));
   assert(object_is_valid(key));
-  iris_check(dict_has(*dict, key), "attempt to erase nonexistent key in dict"); // todo: could be inlined into the end of for
-  size_t hash = object_hash(key);
-  size_t idx = hash % dict->cap;
-  for (size_t i = 0; i < dict->buckets[idx].len; i++) {
-    if (dict->buckets[idx].pairs[i].key == hash) {
-      object_destroy(&dict->buckets[idx].pairs[i].item);
-      dict->buckets[idx].pairs[i].item = dict->buckets[idx].pairs[dict->buckets[idx].len - 1ULL].item;
-      dict->buckets[idx].len--;
-      return;
+  size_t hole = dict_find_slot(dict, key, dict_mix(object_hash(key)));
+  iris_check(hole != SIZE_MAX, "attempt to erase nonexistent key in dict");
+  object_destroy(&dict->slots[hole].key);
+  object_destroy(&dict->slots[hole].item);
+  // pairs that follow in the same run are shifted back if hole is between their home slot and them,
+  // so that lookups never skip over it and no tombstones are needed
+  size_t mask = dict->cap - 1ULL;
+  for (size_t i = (hole + 1ULL) & mask; dict_slot_is_full(dict, i); i = (i + 1ULL) & mask) {
+    size_t home = dict->slots[i].hash & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      dict->slots[hole] = dict->slots[i];
+      dict_set_ctrl(dict, hole, dict->ctrl[i]);
+      hole = i;
     }
   }
-  __builtin_unreachable();
+  dict_set_ctrl(dict, hole, DICT_CTRL_EMPTY);
+  dict->card--;
 }
 
 struct _IrisObject dict_get(const IrisDict dict, const IrisObject key) {
-  assert(dict_is_valid(dict));
-  assert(object_is_valid(key));
-  iris_check(dict_has(dict, key), "attempt to get copy of nonexistent key in dict"); // todo: could be inlined into the end of for
-  size_t hash = object_hash(key);
-  size_t idx = hash % dict.cap;
-  for (size_t i = 0; i < dict.buckets[idx].len; i++) {
-    if (dict.buckets[idx].pairs[i].key == hash) {
-      IrisObject copy = object_copy(dict.buckets[idx].pairs[i].item);
-      return copy;
-    }
-  }
-  __builtin_unreachable();
+  const IrisObject* found = dict_find(dict, key);
+  iris_check(found != NULL, "attempt to get copy of nonexistent key in dict");
+  return object_copy(*found);
 }
 
 const IrisObject* dict_get_view(const IrisDict dict, const IrisObject key) {
-  assert(dict_is_valid(dict));
-  assert(object_is_valid(key));
-  iris_check(dict_has(dict, key), "attempt to get view of nonexistent key in dict"); // todo: could be inlined into the end of for
-  size_t hash = object_hash(key);
-  size_t idx = hash % dict.cap;
-  for (size_t i = 0; i < dict.buckets[idx].len; i++) {
-    if (dict.buckets[idx].pairs[i].key == hash) {
-      return &dict.buckets[idx].pairs[i].item;
-    }
-  }
-  __builtin_unreachable();
+  const IrisObject* found = dict_find(dict, key);
+  iris_check(found != NULL, "attempt to get view of nonexistent key in dict");
+  return found;
 }
 
-// todo: maybe it should check how well each bucket is formed too 
 bool dict_is_valid(const IrisDict dict) {
-  return pointer_is_valid(dict.buckets);
+  if (dict.cap == 0ULL) {
+    return (dict.slots == NULL) && (dict.card == 0ULL);
+  }
+  return pointer_is_valid(dict.slots) && ((dict.cap & (dict.cap - 1ULL)) == 0ULL) &&
+    (dict.ctrl == (uint8_t*)(dict.slots + dict.cap)) && (dict.card < dict.cap);
 }
 
 void dict_destroy(IrisDict* dict) {
   assert(pointer_is_valid(dict));
   assert(dict_is_valid(*dict));
-  dict_free_buckets(dict->buckets, dict->cap);
+  if (dict->slots != NULL) {
+    for (size_t i = 0ULL; i < dict->cap; i++) {
+      if (dict_slot_is_full(dict, i)) {
+        object_destroy(&dict->slots[i].key);
+        object_destroy(&dict->slots[i].item);
+      }
+    }
+    iris_free(dict->slots);
+  }
   dict_move(dict);
 }
 
 void dict_move(IrisDict* dict) {
   assert(pointer_is_valid(dict));
   assert(dict_is_valid(*dict));
-  dict->buckets = NULL;
-  dict->card = 0ULL;
-  dict->cap = 0ULL;
+  *dict = dict_new();
 }
 
 void dict_print_repr(const IrisDict dict, bool newline) {
   assert(dict_is_valid(dict));
   (void)fputc('{', stdout);
   bool put_comma = false;
-  for (size_t b = 0; b < dict.cap; b++) {
-    for (size_t p = 0; p < dict.buckets[b].len; p++) {
-      if (!put_comma) {
-        put_comma = true;
-      } else {
-        (void)fputs(", ", stdout);
-      }
-      (void)fprintf(stdout, "%llu: ", dict.buckets[b].pairs[p].key);
-      object_print_repr(dict.buckets[b].pairs[p].item, false);
+  for (size_t i = 0ULL; i < dict.cap; i++) {
+    if (!dict_slot_is_full(&dict, i)) {
+      continue;
+    }
+    if (!put_comma) {
+      put_comma = true;
+    } else {
+      (void)fputs(", ", stdout);
     }
+    object_print_repr(dict.slots[i].key, false);
+    (void)fputs(": ", stdout);
+    object_print_repr(dict.slots[i].item, false);
   }
   (void)fputc('}', stdout);
   if (newline) { (void)fputc('\n', stdout); }
@@ -3,23 +3,30 @@
 
 #include <stddef.h>
 #include <stdbool.h>
-
-// todo: it's not convenient to have back-reference to pushed object
-//       maybe dict_push_* should return hash key to which item was assigned?
+#include <stdint.h>
 
 typedef struct _IrisDict {
-  // iris hash tables only store hashes of objects and are designed mostly for lookup of module scopes
-  // as original objects from which hash is coming aren't saved you can't use them again
-  // but you really shouldn't in the first place, hash tables aren't designed for that
+  // open addressing hash table with linear probing, designed mostly for lookup of module scopes
+  // keys are stored, so pairs with colliding hashes are told apart by equality of keys
+  // every slot has control byte that is either empty marker or 7 bits of hash,
+  // which are compared for whole group of slots at once before keys are
+  // erasure shifts following pairs back instead of leaving tombstones
   // order isn't preserved
-  // frankly, current implementation doesn't really care about distributions and probings, we might focus on that in the future
-  struct _IrisDictBucket* buckets;
+  struct _IrisDictSlot* slots; // NULL until the first push
+  uint8_t* ctrl; // control bytes, they reside in the same allocation right after slots
   size_t card; // cardinality aka amount of key/item pairs
-  size_t cap;  // allocated buckets
+  size_t cap;  // allocated slots, power of two
 } IrisDict;
 
 IrisDict dict_new(void);
 IrisDict dict_copy(const IrisDict);
+
+/*
+  @brief  Copy which keys and items are cloned, see object_clone
+*/
+IrisDict dict_clone(const IrisDict);
+
+// key is copied into dict, item is moved, pushing with present key replaces its item
 void dict_push_object(IrisDict*, const struct _IrisObject key, struct _IrisObject* item);
 void dict_push_string(IrisDict*, const struct _IrisObject key, struct _IrisString* item);
 void dict_push_func(IrisDict*, const struct _IrisObject key, struct _IrisFunc* item);
@@ -44,11 +51,18 @@ struct _IrisObject dict_get(const IrisDict, const struct _IrisObject key);
 */
 const struct _IrisObject* dict_get_view(const IrisDict, const struct _IrisObject key);
 
+/*
+  @brief  Get reference to object in dictionary or NULL if there's no item with given key
+          Key is hashed once, so it's preferable to dict_has() followed by dict_get_view()
+  @warn   Same restrictions as for dict_get_view() apply to returned reference
+*/
+const struct _IrisObject* dict_find(const IrisDict, const struct _IrisObject key);
+
 bool dict_is_valid(const IrisDict);
 void dict_destroy(IrisDict*);
 void dict_move(IrisDict*);
 void dict_print_repr(const IrisDict, bool newline);
 
-#define dict_to_object(dict) (struct _IrisObject){ .kind = irisObjectKindDict, .dict_variant = dict }
+#define dict_to_object(dict) object_box_dict(dict)
 
 #endif
@@ -2,6 +2,7 @@
 
 #include "iris_error.h"
 #include "types/iris_types.h"
+#include "iris_memory.h"
 #include "iris_utils.h"
 
 static IrisString error_desc_table[IRIS_N_BUILTIN_ERRORS]; // todo: make it growable?
@@ -33,18 +34,20 @@ void deinit_error_module(void) {
 }
 
 IrisError error_new(IrisErrorType type) {
-  IrisError result = { .type = type, .msg = (IrisString){0} };
+  IrisError result = { .type = type, .msg = (IrisString){ .len = 0ULL } };
   return result;
 }
 
 IrisError error_from_chars(IrisErrorType type, const char* chars) {
   IrisString msg = string_from_chars(chars);
+  iris_retag(string_owned_data(msg), irisObjectKindError);
   IrisError result = { .type = type, .msg = msg };
   return result;
 }
 
 IrisError error_from_string(IrisErrorType type, IrisString* str) {
   IrisError result = { .type = type, .msg = *str };
+  iris_retag(string_owned_data(result.msg), irisObjectKindError);
   string_move(str);
   return result;
 }
@@ -53,6 +56,7 @@ IrisError error_copy(const IrisError err) {
   IrisError result = { .type = err.type };
   if (!string_is_empty(err.msg)) {
     result.msg = string_copy(err.msg);
+    iris_retag(string_owned_data(result.msg), irisObjectKindError);
   }
   return result;
 }
@@ -52,6 +52,6 @@ void error_destroy(IrisError*);
 void error_move(IrisError*);
 void error_print_repr(const IrisError, bool newline);
 
-#define error_to_object(err) (struct _IrisObject){ .kind = irisObjectKindError, .error_variant = (err) }
+#define error_to_object(err) object_box_error(err)
 
 #endif
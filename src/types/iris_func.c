@@ -3,6 +3,7 @@
 #include "types/iris_types.h"
 #include "iris_memory.h"
 #include "iris_utils.h"
+#include "iris_profile.h"
 
 // todo: it could be quite dangerous to have function pointers in data
 //       such things should be locked from user access
@@ -30,6 +31,7 @@ IrisFunc func_copy(const IrisFunc func) {
 }
 
 IrisObject func_call(const IrisFunc func, const IrisObject* args, size_t arg_count) {
+  IRIS_PROFILE_ZONE("builtin");
   assert(func_is_valid(func));
   assert(((arg_count > 0ULL) && pointer_is_valid(args)) || (arg_count == 0ULL /*&& !pointer_is_valid(args)*/));
   IrisObject result = {0};
@@ -55,6 +55,6 @@ void func_move(IrisFunc*);
 void func_print_repr(const IrisFunc, bool newline);
 void func_print_internal(const IrisFunc, bool newline);
 
-#define func_to_object(func) (struct _IrisObject){ .kind = irisObjectKindFunc, .func_variant = func }
+#define func_to_object(func) object_box_func(func)
 
 #endif
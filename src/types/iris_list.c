@@ -2,13 +2,14 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "types/iris_types.h"
 #include "iris_utils.h"
 #include "iris_memory.h"
 
-#define LIST_GROW_N 4ULL
-static_assert(LIST_GROW_N > 0ULL, "list item grow amount shouldn't be 0");
+#define LIST_PREALLOC 4ULL
+static_assert(LIST_PREALLOC > 0ULL, "list preallocation shouldn't be 0");
 
 IrisList list_new() {
   IrisList result = {0};
@@ -19,6 +20,7 @@ IrisList list_new() {
 
 IrisList list_from_chars_array(int count, const char** strs) {
   IrisList result = list_new();
+  list_reserve(&result, (count > 0) ? (size_t)count : 0ULL);
   for (int i = 0; i < count; i++) {
     IrisString str = string_from_chars(strs[i]);
     assert(string_is_valid(str));
@@ -32,23 +34,109 @@ IrisList list_copy(const IrisList list) {
   if (list_is_empty(list)) {
     return (IrisList){0};
   } else {
-    IrisList result = {0};
-    for (size_t i = 0; i < list.len; i++) {
-      IrisObject item_copy = object_copy(list.items[i]);
-      list_push_object(&result, &item_copy);
+    IrisList result = {
+      .items = iris_alloc_kind(list.len, IrisObject, irisObjectKindList),
+      .len = list.len,
+      .cap = list.len,
+    };
+    for (size_t i = 0ULL; i < list.len; i++) {
+      result.items[i] = object_copy(list.items[i]);
     }
     return result;
   }
 }
 
+IrisList list_clone(const IrisList list) {
+  assert(list_is_valid(list));
+  IrisList result = list_new();
+  list_reserve(&result, list.len);
+  for (size_t i = 0ULL; i < list.len; i++) {
+    result.items[i] = object_clone(list.items[i]);
+  }
+  result.len = list.len;
+  return result;
+}
+
+/*
+  @brief  Make capacity fit at least required items, it's at least doubled, so that pushing n items is amortized O(n)
+*/
+static void list_grow_to(IrisList* list, size_t required) {
+  size_t cap = (list->cap == 0ULL) ? LIST_PREALLOC : list->cap;
+  while (cap < required) {
+    iris_check(cap <= (SIZE_MAX / 2ULL / sizeof(IrisObject)), "list capacity overflow");
+    cap *= 2ULL;
+  }
+  list->cap = cap;
+  list->items = iris_resize_kind(list->items, list->cap, IrisObject, irisObjectKindList);
+}
+
 __forceinline void list_grow(IrisList* list) {
+  assert(!list_is_borrowed(*list));
   assert(list->len <= list->cap);
   if (list->len == list->cap) {
-    list->cap += LIST_GROW_N;
-    list->items = iris_resize(list->items, list->cap, IrisObject);
+    list_grow_to(list, list->len + 1ULL);
   }
 }
 
+void list_reserve(IrisList* list, size_t additional) {
+  assert(pointer_is_valid(list));
+  assert(list_is_valid(*list));
+  assert(!list_is_borrowed(*list));
+  if ((list->cap - list->len) < additional) {
+    // exact size is allocated, callers that reserve usually know how much they need
+    iris_check(additional <= ((SIZE_MAX / sizeof(IrisObject)) - list->len), "list capacity overflow");
+    list->cap = list->len + additional;
+    list->items = iris_resize_kind(list->items, list->cap, IrisObject, irisObjectKindList);
+  }
+}
+
+void list_shrink_to_fit(IrisList* list) {
+  assert(pointer_is_valid(list));
+  assert(list_is_valid(*list));
+  assert(!list_is_borrowed(*list));
+  if (list->len == list->cap) {
+    return;
+  }
+  if (list->len == 0ULL) {
+    iris_free(list->items);
+    list_move(list);
+  } else {
+    list->cap = list->len;
+    list->items = iris_resize_kind(list->items, list->cap, IrisObject, irisObjectKindList);
+  }
+}
+
+void list_extend_array(IrisList* list, IrisObject* objects, size_t count) {
+  assert(pointer_is_valid(list));
+  assert(list_is_valid(*list));
+  assert(!list_is_borrowed(*list));
+  assert(pointer_is_valid(objects) || (count == 0ULL));
+  if (count == 0ULL) {
+    return;
+  }
+  if ((list->cap - list->len) < count) {
+    list_grow_to(list, list->len + count);
+  }
+  memcpy(list->items + list->len, objects, count * sizeof(IrisObject));
+  list->len += count;
+}
+
+void list_extend(IrisList* list, IrisList* other) {
+  assert(pointer_is_valid(list));
+  assert(pointer_is_valid(other));
+  assert(list_is_valid(*list));
+  assert(list_is_valid(*other));
+  assert(!list_is_borrowed(*list) && !list_is_borrowed(*other));
+  if (list->items == NULL) {
+    // nothing to append to, array of other list is taken whole
+    *list = *other;
+  } else if (other->items != NULL) {
+    list_extend_array(list, other->items, other->len);
+    iris_free(other->items);
+  }
+  list_move(other);
+}
+
 void list_push_object(IrisList* list, IrisObject* obj) {
   assert(pointer_is_valid(list));
   assert(pointer_is_valid(obj));
@@ -73,7 +161,7 @@ void list_push_string(IrisList* list, IrisString* str) {
   assert(pointer_is_valid(list));
   assert(list_is_valid(*list));
   list_grow(list);
-  IrisObject item = { .kind = irisObjectKindString, .string_variant = *str };
+  IrisObject item = string_to_object(*str);
   list->items[list->len] = item;
   list->len++;
   string_move(str);
@@ -84,7 +172,7 @@ void list_push_list(IrisList* list, IrisList* val_list) {
   assert(list_is_valid(*list));
   assert(list_is_valid(*val_list));
   list_grow(list);
-  IrisObject item = { .kind = irisObjectKindList, .list_variant = *val_list };
+  IrisObject item = list_to_object(*val_list);
   list->items[list->len] = item;
   list->len++;
   list_move(val_list);
@@ -101,8 +189,11 @@ bool list_is_empty(const IrisList list) {
 }
 
 bool list_is_valid(const IrisList list) {
+  if (list_is_borrowed(list)) {
+    return pointer_is_valid(list.items) && (list.len != 0ULL) && (list.len == list.cap);
+  }
   return (((list.len == 0ULL) && (list.cap == 0ULL)) && !pointer_is_valid(list.items)) ||
-    (pointer_is_valid(list.items) && (list.len <= list.cap) && (list.len != 0ULL));
+    (pointer_is_valid(list.items) && (list.len <= list.cap) && (list.cap != 0ULL));
 }
 
 // const struct _IrisObject*
@@ -126,9 +217,9 @@ IrisList list_slice(const IrisList list, size_t l, size_t h) {
   iris_check(l < list.len, "low bound is outside of list");
   iris_check(h < list.len, "high bound is outside of list");
   IrisList result = {
-    .items = iris_alloc(h - l + 1ULL, IrisObject),
+    .items = iris_alloc_kind(h - l + 1ULL, IrisObject, irisObjectKindList),
     .len = h - l + 1ULL,
-    .cap = (((h - l + 1ULL) / LIST_GROW_N) + 1ULL) * LIST_GROW_N, // todo: isn't really necessary i think?
+    .cap = h - l + 1ULL,
   };
   size_t counter = 0ULL;
   for (size_t i = l; i <= h; i++) {
@@ -137,8 +228,27 @@ IrisList list_slice(const IrisList list, size_t l, size_t h) {
   return result;
 }
 
+IrisList list_rest(const IrisList* list) {
+  assert(pointer_is_valid(list));
+  assert(list_is_valid(*list));
+  if (list->len <= 1ULL) {
+    return list_new();
+  }
+  // rest of borrowed list borrows from the same owner, so that walking a list doesn't chain boxes
+  IrisList* owner = list_is_borrowed(*list) ? list->owner : (IrisList*)list;
+  IrisObject retained = object_copy((IrisObject){ .kind = irisObjectKindList, .list_variant = owner });
+  IrisList result = {
+    .items = list->items + 1,
+    .len = list->len - 1ULL,
+    .cap = list->len - 1ULL,
+    .owner = retained.list_variant,
+  };
+  return result;
+}
+
 void list_nth_set(IrisList* list, size_t idx, IrisObject* obj) {
   assert(list_is_valid(*list));
+  assert(!list_is_borrowed(*list));
   iris_check(idx < list->len, "idx out of bounds");
   object_destroy(&list->items[idx]);
   list->items[idx] = *obj;
@@ -170,6 +280,13 @@ bool list_has(const IrisList list, const IrisObject obj) {
 void list_destroy(IrisList* list) {
   assert(pointer_is_valid(list));
   assert(list_is_valid(*list));
+  if (list_is_borrowed(*list)) {
+    // items belong to owner, only its box is released
+    IrisObject owner = { .kind = irisObjectKindList, .list_variant = list->owner };
+    object_destroy(&owner);
+    list_move(list);
+    return;
+  }
   for (size_t i = 0ULL; i < list->len; i++) {
     object_destroy(&list->items[i]);
   }
@@ -184,6 +301,7 @@ void list_move(IrisList* list) {
   list->items = NULL;
   list->len = 0ULL;
   list->cap = 0ULL;
+  list->owner = NULL;
 }
 
 void list_print_repr(const IrisList list, bool newline) {
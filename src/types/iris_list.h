@@ -11,15 +11,25 @@ typedef struct _IrisList {
   // tho we don't really have to conform to this tradition even?
   // optionally we could just provide special function interface for interpreting lists as linked lists
   // but that's really not a good idea, but we will see
+  // lists either own their items or borrow a range of items of boxed list, which is kept alive by them
   struct _IrisObject* items;
   size_t len;
   size_t cap;
+  struct _IrisList* owner; // NULL if items are owned
 } IrisList;
 
+#define list_is_borrowed(list) ((list).owner != NULL)
+
 IrisList list_new(void);
 IrisList list_from_chars_array(int count, const char**);
 IrisList list_copy(const IrisList);
 
+/*
+  @brief  Copy which items are cloned, see object_clone
+          Result always owns its items, even if given list is borrowed
+*/
+IrisList list_clone(const IrisList);
+
 /*
   @brief  Moves variant object to list
   @warn   Passed object should no longer be used!
@@ -29,6 +39,29 @@ void list_push_object(IrisList*, struct _IrisObject*);
 void list_push_int(IrisList*, intmax_t); // todo: should it be passed by ref to?
 void list_push_string(IrisList*, struct _IrisString*);
 void list_push_list(IrisList*, IrisList*);
+
+/*
+  @brief  Make room for at least given number of items past the current ones, so that pushing them doesn't reallocate
+*/
+void list_reserve(IrisList*, size_t additional);
+
+/*
+  @brief  Release capacity that isn't used by items
+*/
+void list_shrink_to_fit(IrisList*);
+
+/*
+  @brief  Moves objects of array to the end of list with a single copy
+  @warn   Passed objects should no longer be used, array itself isn't released
+*/
+void list_extend_array(IrisList*, struct _IrisObject* objects, size_t count);
+
+/*
+  @brief  Moves every item of other list to the end of list
+  @warn   Passed list should no longer be used!
+*/
+void list_extend(IrisList*, IrisList* other);
+
 bool list_is_valid(const IrisList);
 bool list_is_empty(const IrisList);
 size_t list_card(const IrisList);
@@ -47,6 +80,13 @@ bool list_is_valid(const IrisList);
 */
 struct _IrisList list_slice(const IrisList, size_t l, size_t h);
 
+/*
+  @brief  Get list without the first item that borrows items of given one, O(1)
+          Borrowed list shares box of its owner, so it's never mutated in place, see object_unshare
+  @warn   Given list should be boxed value of object
+*/
+IrisList list_rest(const IrisList*);
+
 /*
   @brief  Push object to certain position replacing already existing one
 */
@@ -60,6 +100,6 @@ void list_move(IrisList*);
 void list_print_repr(const IrisList, bool newline);
 void list_print_internal(const IrisList, bool newline);
 
-#define list_to_object(list) (struct _IrisObject){ .kind = irisObjectKindList, .list_variant = list }
+#define list_to_object(list) object_box_list(list)
 
 #endif
@@ -0,0 +1,558 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_utils.h"
+
+#define MAP_MASK ((size_t)IRIS_MAP_WIDTH - 1ULL)
+#define MAP_HASH_BITS (sizeof(size_t) * CHAR_BIT) // nodes that are this deep hold pairs which hashes are equal
+
+typedef struct _IrisMapPair {
+  size_t hash; // mixed hash of key
+  IrisObject key;
+  IrisObject item;
+} IrisMapPair;
+
+typedef union _IrisMapEntry {
+  IrisMapPair pair;
+  struct _IrisMapNode* child;
+} IrisMapEntry;
+
+typedef struct _IrisMapNode {
+  atomic_uint refcount; // maps and parent nodes that reference node
+  uint32_t bitmap;      // positions that have entries, 0 for collision nodes
+  uint32_t pairs;       // positions which entries are pairs, others refer to children
+  unsigned int len;     // entries, they're ordered by position
+  unsigned int cap;     // entries that fit in node, there's spare room only in nodes grown by transient or left by erase
+  IrisMapEntry entries[];
+} IrisMapNode;
+
+// nodes are shared by copies that could outlive the form that created them, so they're always kept on heap,
+// arena is unbound for whole duration of mutation, which makes copies of keys and items that are put into nodes be on heap too
+
+/*
+  @brief  Spread bits of object hash, as integers hash to themselves, trie is indexed starting from the low bits
+*/
+static inline size_t map_mix(size_t hash) {
+  uint64_t h = (uint64_t)hash * 0x9e3779b97f4a7c15ULL;
+  return (size_t)(h ^ (h >> 32U));
+}
+
+/*
+  @brief  Keys are equal if they're equal objects, but also symbols and strings of the same name are, as they hash the same
+*/
+static inline bool map_key_equal(const IrisObject x, const IrisObject y) {
+  if (x.kind == y.kind) {
+    return (x.kind == irisObjectKindSymbol) ? (x.symbol_variant.id == y.symbol_variant.id) : object_equal(x, y);
+  } else if ((x.kind == irisObjectKindSymbol) && (y.kind == irisObjectKindString)) {
+    return string_equal(*symbol_name(x.symbol_variant), *y.string_variant);
+  } else if ((x.kind == irisObjectKindString) && (y.kind == irisObjectKindSymbol)) {
+    return string_equal(*x.string_variant, *symbol_name(y.symbol_variant));
+  }
+  return false;
+}
+
+static inline uint32_t map_bit(size_t hash, size_t shift) {
+  return 1U << ((hash >> shift) & MAP_MASK);
+}
+
+static inline unsigned int map_index(uint32_t bitmap, uint32_t bit) {
+  return (unsigned int)__builtin_popcount(bitmap & (bit - 1U));
+}
+
+static IrisMapNode* map_node_new(unsigned int len, unsigned int cap) {
+  assert(len <= cap);
+  IrisMapNode* result = (IrisMapNode*)iris_alloc_kind(sizeof(IrisMapNode) + (cap * sizeof(IrisMapEntry)), char, irisObjectKindMap);
+  atomic_init(&result->refcount, 1U);
+  result->bitmap = 0U;
+  result->pairs = 0U;
+  result->len = len;
+  result->cap = cap;
+  return result;
+}
+
+/*
+  @brief  Room for entries of node that is grown to given length, transient doubles it, so that pushing n pairs into node is amortized O(n)
+*/
+static inline unsigned int map_node_cap(unsigned int len, size_t shift, bool spare) {
+  if (!spare) {
+    return len;
+  }
+  unsigned int cap = len * 2U;
+  return ((shift < MAP_HASH_BITS) && (cap > IRIS_MAP_WIDTH)) ? IRIS_MAP_WIDTH : cap;
+}
+
+/*
+  @brief  Whether entry at position of given bit holds a pair, bits of entries are walked with map_next_bit
+*/
+static inline bool map_entry_is_pair(const IrisMapNode* node, size_t shift, uint32_t bit) {
+  return (shift >= MAP_HASH_BITS) || ((node->pairs & bit) != 0U);
+}
+
+/*
+  @brief  Take the lowest bit out of positions that are left to walk
+*/
+static inline uint32_t map_next_bit(uint32_t* positions) {
+  uint32_t bit = *positions & (~*positions + 1U);
+  *positions &= *positions - 1U;
+  return bit;
+}
+
+static void map_node_release(IrisMapNode* node, size_t shift) {
+  assert(pointer_is_valid(node));
+  if (atomic_fetch_sub_explicit(&node->refcount, 1U, memory_order_acq_rel) != 1U) {
+    return;
+  }
+  uint32_t positions = node->bitmap;
+  for (unsigned int i = 0U; i < node->len; i++) {
+    if (map_entry_is_pair(node, shift, map_next_bit(&positions))) {
+      object_destroy(&node->entries[i].pair.key);
+      object_destroy(&node->entries[i].pair.item);
+    } else {
+      map_node_release(node->entries[i].child, shift + IRIS_MAP_BITS);
+    }
+  }
+  iris_free(node);
+}
+
+static void map_node_retain(IrisMapNode* node) {
+  atomic_fetch_add_explicit(&node->refcount, 1U, memory_order_relaxed);
+}
+
+/*
+  @brief  Get node that could be mutated instead of given one, with room for len entries
+          Node that is referenced only by caller is edited in place and resized if it's out of room,
+          shared one is copied and caller's reference to it is dropped
+          With spare set, as for transient, node is given more room than it needs
+          Entries past the old length are left uninitialized
+*/
+static IrisMapNode* map_node_own(IrisMapNode* node, size_t shift, unsigned int len, bool spare) {
+  if (atomic_load_explicit(&node->refcount, memory_order_acquire) == 1U) {
+    if (len > node->cap) {
+      unsigned int cap = map_node_cap(len, shift, spare);
+      node = (IrisMapNode*)iris_resize_kind(node, sizeof(IrisMapNode) + (cap * sizeof(IrisMapEntry)), char, irisObjectKindMap);
+      node->cap = cap;
+    }
+    node->len = len;
+    return node;
+  }
+  IrisMapNode* result = map_node_new(len, (len > node->len) ? map_node_cap(len, shift, spare) : len);
+  result->bitmap = node->bitmap;
+  result->pairs = node->pairs;
+  unsigned int n = (len < node->len) ? len : node->len;
+  uint32_t positions = node->bitmap;
+  for (unsigned int i = 0U; i < n; i++) {
+    if (map_entry_is_pair(node, shift, map_next_bit(&positions))) {
+      result->entries[i].pair = (IrisMapPair){
+        .hash = node->entries[i].pair.hash,
+        .key = object_copy(node->entries[i].pair.key),
+        .item = object_copy(node->entries[i].pair.item),
+      };
+    } else {
+      result->entries[i].child = node->entries[i].child;
+      map_node_retain(result->entries[i].child);
+    }
+  }
+  map_node_release(node, shift);
+  return result;
+}
+
+/*
+  @brief  Node at given level that holds both pairs, going deeper while their hash bits are the same
+*/
+static IrisMapNode* map_node_from_pairs(size_t shift, IrisMapPair a, IrisMapPair b) {
+  if (shift >= MAP_HASH_BITS) {
+    IrisMapNode* result = map_node_new(2U, 2U);
+    result->entries[0].pair = a;
+    result->entries[1].pair = b;
+    return result;
+  }
+  uint32_t bit_a = map_bit(a.hash, shift);
+  uint32_t bit_b = map_bit(b.hash, shift);
+  if (bit_a == bit_b) {
+    IrisMapNode* result = map_node_new(1U, 1U);
+    result->bitmap = bit_a;
+    result->entries[0].child = map_node_from_pairs(shift + IRIS_MAP_BITS, a, b);
+    return result;
+  }
+  IrisMapNode* result = map_node_new(2U, 2U);
+  result->bitmap = bit_a | bit_b;
+  result->pairs = bit_a | bit_b;
+  result->entries[(bit_a < bit_b) ? 0U : 1U].pair = a;
+  result->entries[(bit_a < bit_b) ? 1U : 0U].pair = b;
+  return result;
+}
+
+/*
+  @brief  Make room for entry at idx, following entries are shifted
+*/
+static IrisMapNode* map_node_insert_at(IrisMapNode* node, size_t shift, unsigned int idx, bool spare) {
+  node = map_node_own(node, shift, node->len + 1U, spare);
+  memmove(&node->entries[idx + 1U], &node->entries[idx], (node->len - 1U - idx) * sizeof(IrisMapEntry));
+  return node;
+}
+
+/*
+  @brief  Drop entry at idx without destroying it, following entries are shifted
+*/
+static void map_node_remove_at(IrisMapNode* node, unsigned int idx) {
+  memmove(&node->entries[idx], &node->entries[idx + 1U], (node->len - 1U - idx) * sizeof(IrisMapEntry));
+  node->len--;
+}
+
+/*
+  @brief  Put pair into subtrie, copying shared nodes along the path
+          Caller's reference to node is taken over, node that replaces it is returned
+          If key is already present, its item is replaced and passed key is destroyed
+*/
+static IrisMapNode* map_node_push(IrisMapNode* node, size_t shift, IrisMapPair pair, bool spare, bool* added) {
+  if (node == NULL) {
+    IrisMapNode* result = map_node_new(1U, map_node_cap(1U, shift, spare));
+    if (shift < MAP_HASH_BITS) {
+      result->bitmap = map_bit(pair.hash, shift);
+      result->pairs = result->bitmap;
+    }
+    result->entries[0].pair = pair;
+    *added = true;
+    return result;
+  }
+  if (shift >= MAP_HASH_BITS) {
+    for (unsigned int i = 0U; i < node->len; i++) {
+      if (map_key_equal(node->entries[i].pair.key, pair.key)) {
+        node = map_node_own(node, shift, node->len, spare);
+        object_destroy(&node->entries[i].pair.item);
+        node->entries[i].pair.item = pair.item;
+        object_destroy(&pair.key);
+        *added = false;
+        return node;
+      }
+    }
+    node = map_node_insert_at(node, shift, node->len, spare);
+    node->entries[node->len - 1U].pair = pair;
+    *added = true;
+    return node;
+  }
+  uint32_t bit = map_bit(pair.hash, shift);
+  unsigned int idx = map_index(node->bitmap, bit);
+  if ((node->bitmap & bit) == 0U) {
+    node = map_node_insert_at(node, shift, idx, spare);
+    node->bitmap |= bit;
+    node->pairs |= bit;
+    node->entries[idx].pair = pair;
+    *added = true;
+    return node;
+  }
+  node = map_node_own(node, shift, node->len, spare);
+  IrisMapEntry* entry = &node->entries[idx];
+  if ((node->pairs & bit) == 0U) {
+    entry->child = map_node_push(entry->child, shift + IRIS_MAP_BITS, pair, spare, added);
+  } else if ((entry->pair.hash == pair.hash) && map_key_equal(entry->pair.key, pair.key)) {
+    object_destroy(&entry->pair.item);
+    entry->pair.item = pair.item;
+    object_destroy(&pair.key);
+    *added = false;
+  } else {
+    // pairs collide at this level, both go to new node
+    entry->child = map_node_from_pairs(shift + IRIS_MAP_BITS, entry->pair, pair);
+    node->pairs &= ~bit;
+    *added = true;
+  }
+  return node;
+}
+
+/*
+  @brief  Release spare room of nodes that are owned by caller, shared nodes weren't grown by transient, so their subtries are skipped
+*/
+static IrisMapNode* map_node_shrink(IrisMapNode* node, size_t shift) {
+  if (atomic_load_explicit(&node->refcount, memory_order_acquire) != 1U) {
+    return node;
+  }
+  uint32_t positions = node->bitmap;
+  for (unsigned int i = 0U; i < node->len; i++) {
+    if (!map_entry_is_pair(node, shift, map_next_bit(&positions))) {
+      node->entries[i].child = map_node_shrink(node->entries[i].child, shift + IRIS_MAP_BITS);
+    }
+  }
+  if (node->cap != node->len) {
+    node = (IrisMapNode*)iris_resize_kind(node, sizeof(IrisMapNode) + (node->len * sizeof(IrisMapEntry)), char, irisObjectKindMap);
+    node->cap = node->len;
+  }
+  return node;
+}
+
+/*
+  @brief  Remove pair of present key from subtrie, copying shared nodes along the path
+          Caller's reference to node is taken over, node that replaces it is returned, which is NULL if none of pairs is left
+*/
+static IrisMapNode* map_node_erase(IrisMapNode* node, size_t shift, const IrisObject key, size_t hash) {
+  assert(pointer_is_valid(node));
+  if (shift >= MAP_HASH_BITS) {
+    unsigned int idx = 0U;
+    while (!map_key_equal(node->entries[idx].pair.key, key)) {
+      idx++;
+      assert(idx < node->len);
+    }
+    if (node->len == 1U) {
+      map_node_release(node, shift);
+      return NULL;
+    }
+    node = map_node_own(node, shift, node->len, false);
+    object_destroy(&node->entries[idx].pair.key);
+    object_destroy(&node->entries[idx].pair.item);
+    map_node_remove_at(node, idx);
+    return node;
+  }
+  uint32_t bit = map_bit(hash, shift);
+  assert((node->bitmap & bit) != 0U);
+  unsigned int idx = map_index(node->bitmap, bit);
+  if ((node->len == 1U) && ((node->pairs & bit) != 0U)) {
+    map_node_release(node, shift);
+    return NULL;
+  }
+  node = map_node_own(node, shift, node->len, false);
+  IrisMapEntry* entry = &node->entries[idx];
+  if ((node->pairs & bit) != 0U) {
+    object_destroy(&entry->pair.key);
+    object_destroy(&entry->pair.item);
+  } else {
+    IrisMapNode* child = map_node_erase(entry->child, shift + IRIS_MAP_BITS, key, hash);
+    if ((child != NULL) && (child->len == 1U) && ((child->pairs != 0U) || ((shift + IRIS_MAP_BITS) >= MAP_HASH_BITS))) {
+      // child that is left with a single pair is collapsed, so trie stays as shallow as it would be without erased pair
+      IrisMapPair pair = child->entries[0].pair;
+      if (atomic_load_explicit(&child->refcount, memory_order_acquire) == 1U) {
+        iris_free(child);
+      } else {
+        pair.key = object_copy(pair.key);
+        pair.item = object_copy(pair.item);
+        map_node_release(child, shift + IRIS_MAP_BITS);
+      }
+      entry->pair = pair;
+      node->pairs |= bit;
+      return node;
+    }
+    if (child != NULL) {
+      entry->child = child;
+      return node;
+    }
+  }
+  map_node_remove_at(node, idx);
+  node->bitmap &= ~bit;
+  node->pairs &= ~bit;
+  if (node->len == 0U) {
+    iris_free(node);
+    return NULL;
+  }
+  return node;
+}
+
+IrisMap map_new(void) {
+  return (IrisMap){0};
+}
+
+IrisMap map_copy(const IrisMap map) {
+  assert(map_is_valid(map));
+  if (map.root != NULL) {
+    map_node_retain(map.root);
+  }
+  return map;
+}
+
+/*
+  @brief  Push pair which key and item are already on heap
+*/
+static void map_push(IrisMap* map, IrisObject key, IrisObject item, bool spare) {
+  IrisMapPair pair = { .hash = map_mix(object_hash(key)), .key = key, .item = item };
+  bool added = false;
+  map->root = map_node_push(map->root, 0ULL, pair, spare, &added);
+  if (added) {
+    map->card++;
+  }
+}
+
+static void map_push_escaped(IrisMap* map, const IrisObject key, IrisObject* item, bool spare) {
+  assert(pointer_is_valid(map));
+  assert(map_is_valid(*map));
+  assert(object_is_valid(key));
+  assert(object_is_valid(*item));
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  if (arena != NULL) {
+    // objects could be allocated from arena, which is reset before nodes are released
+    IrisObject escaped = object_clone(*item);
+    arena_bind(arena);
+    object_destroy(item);
+    arena_bind(NULL);
+    map_push(map, object_clone(key), escaped, spare);
+  } else {
+    map_push(map, object_copy(key), *item, spare);
+    object_move(item);
+  }
+  arena_bind(arena);
+}
+
+void map_push_object(IrisMap* map, const IrisObject key, IrisObject* item) {
+  map_push_escaped(map, key, item, false);
+}
+
+void map_push_func(IrisMap* map, const IrisObject key, IrisFunc* func) {
+  assert(func_is_valid(*func));
+  IrisObject item = func_to_object(*func);
+  func_move(func);
+  map_push_object(map, key, &item);
+}
+
+IrisMapTransient map_transient(IrisMap* map) {
+  assert(pointer_is_valid(map));
+  assert(map_is_valid(*map));
+  IrisMapTransient result = { .map = *map };
+  map_move(map);
+  return result;
+}
+
+void map_transient_push_object(IrisMapTransient* transient, const IrisObject key, IrisObject* item) {
+  assert(pointer_is_valid(transient));
+  map_push_escaped(&transient->map, key, item, true);
+}
+
+void map_transient_push_func(IrisMapTransient* transient, const IrisObject key, IrisFunc* func) {
+  assert(func_is_valid(*func));
+  IrisObject item = func_to_object(*func);
+  func_move(func);
+  map_transient_push_object(transient, key, &item);
+}
+
+IrisMap map_persistent(IrisMapTransient* transient) {
+  assert(pointer_is_valid(transient));
+  assert(map_is_valid(transient->map));
+  IrisMap result = transient->map;
+  if (result.root != NULL) {
+    IrisArena* arena = arena_bound();
+    arena_bind(NULL);
+    result.root = map_node_shrink(result.root, 0ULL);
+    arena_bind(arena);
+  }
+  map_move(&transient->map);
+  return result;
+}
+
+const IrisObject* map_find(const IrisMap map, const IrisObject key) {
+  assert(map_is_valid(map));
+  assert(object_is_valid(key));
+  if (map.root == NULL) {
+    return NULL;
+  }
+  size_t hash = map_mix(object_hash(key));
+  const IrisMapNode* node = map.root;
+  for (size_t shift = 0ULL; shift < MAP_HASH_BITS; shift += IRIS_MAP_BITS) {
+    uint32_t bit = map_bit(hash, shift);
+    if ((node->bitmap & bit) == 0U) {
+      return NULL;
+    }
+    const IrisMapEntry* entry = &node->entries[map_index(node->bitmap, bit)];
+    if ((node->pairs & bit) != 0U) {
+      return ((entry->pair.hash == hash) && map_key_equal(entry->pair.key, key)) ? &entry->pair.item : NULL;
+    }
+    node = entry->child;
+  }
+  for (unsigned int i = 0U; i < node->len; i++) {
+    if (map_key_equal(node->entries[i].pair.key, key)) {
+      return &node->entries[i].pair.item;
+    }
+  }
+  return NULL;
+}
+
+bool map_has(const IrisMap map, const IrisObject key) {
+  return map_find(map, key) != NULL;
+}
+
+void map_erase(IrisMap* map, const IrisObject key) {
+  assert(pointer_is_valid(map));
+  assert(map_is_valid(*map));
+  iris_check(map_has(*map, key), "attempt to erase nonexistent key in map");
+  // nodes that are copied on the way are heap allocated, as well as copies of shared pairs
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  map->root = map_node_erase(map->root, 0ULL, key, map_mix(object_hash(key)));
+  map->card--;
+  arena_bind(arena);
+}
+
+IrisObject map_get(const IrisMap map, const IrisObject key) {
+  const IrisObject* found = map_find(map, key);
+  iris_check(found != NULL, "attempt to get copy of nonexistent key in map");
+  return object_copy(*found);
+}
+
+const IrisObject* map_get_view(const IrisMap map, const IrisObject key) {
+  const IrisObject* found = map_find(map, key);
+  iris_check(found != NULL, "attempt to get view of nonexistent key in map");
+  return found;
+}
+
+size_t map_card(const IrisMap map) {
+  assert(map_is_valid(map));
+  return map.card;
+}
+
+bool map_is_empty(const IrisMap map) {
+  assert(map_is_valid(map));
+  return map.card == 0ULL;
+}
+
+bool map_is_valid(const IrisMap map) {
+  if (map.root == NULL) {
+    return map.card == 0ULL;
+  }
+  return pointer_is_valid(map.root) && (atomic_load_explicit(&map.root->refcount, memory_order_relaxed) != 0U) &&
+    (map.root->len != 0U) && (map.card != 0ULL);
+}
+
+void map_destroy(IrisMap* map) {
+  assert(pointer_is_valid(map));
+  assert(map_is_valid(*map));
+  if (map->root != NULL) {
+    map_node_release(map->root, 0ULL);
+  }
+  map_move(map);
+}
+
+void map_move(IrisMap* map) {
+  assert(pointer_is_valid(map));
+  *map = map_new();
+}
+
+static void map_node_print_repr(const IrisMapNode* node, size_t shift, bool* put_comma) {
+  uint32_t positions = node->bitmap;
+  for (unsigned int i = 0U; i < node->len; i++) {
+    if (!map_entry_is_pair(node, shift, map_next_bit(&positions))) {
+      map_node_print_repr(node->entries[i].child, shift + IRIS_MAP_BITS, put_comma);
+      continue;
+    }
+    if (!*put_comma) {
+      *put_comma = true;
+    } else {
+      (void)fputs(", ", stdout);
+    }
+    object_print_repr(node->entries[i].pair.key, false);
+    (void)fputs(": ", stdout);
+    object_print_repr(node->entries[i].pair.item, false);
+  }
+}
+
+void map_print_repr(const IrisMap map, bool newline) {
+  assert(map_is_valid(map));
+  (void)fputc('{', stdout);
+  if (map.root != NULL) {
+    bool put_comma = false;
+    map_node_print_repr(map.root, 0ULL, &put_comma);
+  }
+  (void)fputc('}', stdout);
+  if (newline) { (void)fputc('\n', stdout); }
+  fflush(stdout);
+}
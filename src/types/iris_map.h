@@ -0,0 +1,86 @@
+#ifndef IRIS_MAP_H
+#define IRIS_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define IRIS_MAP_BITS 5U
+#define IRIS_MAP_WIDTH (1U << IRIS_MAP_BITS)
+
+typedef struct _IrisMap {
+  // immutable persistent hash table, hash array mapped trie of refcounted nodes
+  // every node picks one of 32 entries by the next 5 bits of key hash, entry either holds a pair or refers to deeper node
+  // copies share root, push and erase copy only nodes on the path to the changed pair that are shared,
+  // so older versions are left intact, which makes snapshots of scopes that are later extended cheap
+  // nodes that are referenced by a single map are edited in place, see IrisMapTransient for building maps
+  // nodes could be shared by interpreter threads, their counts are atomic
+  // keys are compared the same way dict compares them, order isn't preserved
+  struct _IrisMapNode* root; // NULL for empty map
+  size_t card; // cardinality aka amount of key/item pairs
+} IrisMap;
+
+typedef struct _IrisMapTransient {
+  // map that is being built by a single owner, nodes that it owns are given spare room,
+  // so that pushing pairs into them doesn't reallocate them every time
+  // shared nodes are still copied once on the first push through them, the copy is owned by transient from then on
+  IrisMap map;
+} IrisMapTransient;
+
+IrisMap map_new(void);
+
+/*
+  @brief  Copy that shares every node, O(1)
+*/
+IrisMap map_copy(const IrisMap);
+
+/*
+  @brief  Key is copied into map, item is moved, pushing with present key replaces its item
+          Other maps that share nodes with it aren't affected
+  @warn   Passed item should no longer be used!
+*/
+void map_push_object(IrisMap*, const struct _IrisObject key, struct _IrisObject* item);
+void map_push_func(IrisMap*, const struct _IrisObject key, struct _IrisFunc* item);
+
+/*
+  @brief  Take map over for building it, it should be turned back with map_persistent before any other use
+*/
+IrisMapTransient map_transient(IrisMap*);
+
+/*
+  @brief  Same as map_push_object, but nodes owned by transient keep spare room
+  @warn   Passed item should no longer be used!
+*/
+void map_transient_push_object(IrisMapTransient*, const struct _IrisObject key, struct _IrisObject* item);
+void map_transient_push_func(IrisMapTransient*, const struct _IrisObject key, struct _IrisFunc* item);
+
+/*
+  @brief  Release spare room of nodes and make map of transient, O(nodes owned by transient)
+*/
+IrisMap map_persistent(IrisMapTransient*);
+
+/*
+  @brief  Get reference to item stored by key, it's valid as long as map isn't changed or destroyed
+  @return NULL if there's no such key
+*/
+const struct _IrisObject* map_find(const IrisMap, const struct _IrisObject key);
+bool map_has(const IrisMap, const struct _IrisObject key);
+
+/*
+  @brief  Other maps that share nodes with it aren't affected
+*/
+void map_erase(IrisMap*, const struct _IrisObject key);
+
+struct _IrisObject map_get(const IrisMap, const struct _IrisObject key);
+const struct _IrisObject* map_get_view(const IrisMap, const struct _IrisObject key);
+
+size_t map_card(const IrisMap);
+bool map_is_empty(const IrisMap);
+bool map_is_valid(const IrisMap);
+
+void map_destroy(IrisMap*);
+void map_move(IrisMap*);
+void map_print_repr(const IrisMap, bool newline);
+
+#define map_to_object(map) object_box_map(map)
+
+#endif
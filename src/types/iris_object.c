@@ -1,68 +1,182 @@
 #include <stdlib.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #include "types/iris_object.h"
+#include "iris_memory.h"
 #include "iris_utils.h"
+#include "iris_profile.h"
+
+typedef struct {
+  atomic_size_t refcount; // objects that share boxed value, it's destroyed with the last one
+} ObjectBoxHeader;
+
+static_assert((sizeof(ObjectBoxHeader) % _Alignof(IrisString)) == 0U, "box header shouldn't break alignment of boxed value");
+
+#define object_box_header(box) ((ObjectBoxHeader*)((char*)(box) - sizeof(ObjectBoxHeader)))
+
+static void* object_box_alloc(size_t size, IrisObjectKind kind) {
+  ObjectBoxHeader* header = (ObjectBoxHeader*)iris_alloc_kind(sizeof(ObjectBoxHeader) + size, char, kind);
+  atomic_init(&header->refcount, 1U);
+  return header + 1;
+}
+
+/*
+  @brief  Drop reference to box of object
+  @return True if it was the last one, then boxed value should be destroyed
+*/
+static bool object_box_release(const IrisObject obj) {
+  return atomic_fetch_sub_explicit(&object_box_header(obj.string_variant)->refcount, 1U, memory_order_acq_rel) == 1U;
+}
+
+static IrisObject object_box_retain(const IrisObject obj) {
+  atomic_fetch_add_explicit(&object_box_header(obj.string_variant)->refcount, 1U, memory_order_relaxed);
+  return obj;
+}
+
+IrisObject object_box_string(IrisString str) {
+  IrisString* box = object_box_alloc(sizeof(IrisString), irisObjectKindString);
+  *box = str;
+  return (IrisObject){ .kind = irisObjectKindString, .string_variant = box };
+}
+
+IrisObject object_box_list(IrisList list) {
+  IrisList* box = object_box_alloc(sizeof(IrisList), irisObjectKindList);
+  *box = list;
+  return (IrisObject){ .kind = irisObjectKindList, .list_variant = box };
+}
+
+IrisObject object_box_dict(IrisDict dict) {
+  IrisDict* box = object_box_alloc(sizeof(IrisDict), irisObjectKindDict);
+  *box = dict;
+  return (IrisObject){ .kind = irisObjectKindDict, .dict_variant = box };
+}
+
+IrisObject object_box_vector(IrisVector vec) {
+  IrisVector* box = object_box_alloc(sizeof(IrisVector), irisObjectKindVector);
+  *box = vec;
+  return (IrisObject){ .kind = irisObjectKindVector, .vector_variant = box };
+}
+
+IrisObject object_box_map(IrisMap map) {
+  IrisMap* box = object_box_alloc(sizeof(IrisMap), irisObjectKindMap);
+  *box = map;
+  return (IrisObject){ .kind = irisObjectKindMap, .map_variant = box };
+}
+
+IrisObject object_box_func(IrisFunc func) {
+  IrisFunc* box = object_box_alloc(sizeof(IrisFunc), irisObjectKindFunc);
+  *box = func;
+  return (IrisObject){ .kind = irisObjectKindFunc, .func_variant = box };
+}
+
+IrisObject object_box_refcell(IrisRefCell ref) {
+  IrisRefCell* box = object_box_alloc(sizeof(IrisRefCell), irisObjectKindRefCell);
+  *box = ref;
+  return (IrisObject){ .kind = irisObjectKindRefCell, .refcell_variant = box };
+}
+
+IrisObject object_box_error(IrisError err) {
+  IrisError* box = object_box_alloc(sizeof(IrisError), irisObjectKindError);
+  *box = err;
+  return (IrisObject){ .kind = irisObjectKindError, .error_variant = box };
+}
 
 struct _IrisObject object_copy(const struct _IrisObject obj) {
+  IRIS_PROFILE_ZONE("object_copy");
   assert(object_is_valid(obj));
   switch (obj.kind) {
+    case irisObjectKindNone:
+      return obj;
     case irisObjectKindInt:
       return (IrisObject){ .kind = irisObjectKindInt, .int_variant = obj.int_variant };
     case irisObjectKindFloat:
-      return (IrisObject){ .kind = irisObjectKindFloat, .int_variant = obj.float_variant };
-    case irisObjectKindString:
-      return string_to_object(string_copy(obj.string_variant));
+      return (IrisObject){ .kind = irisObjectKindFloat, .float_variant = obj.float_variant };
+    case irisObjectKindSymbol:
+      return obj;
     case irisObjectKindRefCell:
-      return refcell_to_object(refcell_copy(obj.refcell_variant));
+      return refcell_to_object(refcell_copy(*obj.refcell_variant));
+    case irisObjectKindString:
     case irisObjectKindList:
-      return list_to_object(list_copy(obj.list_variant));
     case irisObjectKindDict:
-      return dict_to_object(dict_copy(obj.dict_variant));
+    case irisObjectKindVector:
+    case irisObjectKindMap:
     case irisObjectKindFunc:
-      return func_to_object(func_copy(obj.func_variant));
     case irisObjectKindError:
-      return error_to_object(error_copy(obj.error_variant));
+      // copies share the box until one of them is mutated, see object_unshare
+      return object_box_retain(obj);
     default:
       panic("copy behavior for object variant isn't defined");
   }
   __builtin_unreachable();
 }
 
-void object_move(IrisObject* obj) {
-  assert(object_is_valid(*obj));
-  switch (obj->kind) {
-    case irisObjectKindInt: break;
-    case irisObjectKindFloat: break;
+struct _IrisObject object_clone(const struct _IrisObject obj) {
+  assert(object_is_valid(obj));
+  switch (obj.kind) {
+    case irisObjectKindNone:
+    case irisObjectKindInt:
+    case irisObjectKindFloat:
+    case irisObjectKindSymbol:
+      return obj;
     case irisObjectKindString:
-      string_move(&obj->string_variant);
-      break;
+      return string_to_object(string_copy(*obj.string_variant));
+    case irisObjectKindRefCell:
+      // todo: refcells are copied by reference, so their payload would still reside where it was
+      return refcell_to_object(refcell_copy(*obj.refcell_variant));
     case irisObjectKindList:
-      list_move(&obj->list_variant);
-      break;
+      return list_to_object(list_clone(*obj.list_variant));
     case irisObjectKindDict:
-      dict_move(&obj->dict_variant);
-      break;
-    case irisObjectKindRefCell:
-      refcell_move(&obj->refcell_variant);
-      break;
+      return dict_to_object(dict_clone(*obj.dict_variant));
+    case irisObjectKindVector:
+      return vector_to_object(vector_copy(*obj.vector_variant)); // nodes and their items are always on heap
+    case irisObjectKindMap:
+      return map_to_object(map_copy(*obj.map_variant)); // nodes and their pairs are always on heap
     case irisObjectKindFunc:
-      func_move(&obj->func_variant);
-      break;
+      return func_to_object(func_copy(*obj.func_variant));
+    case irisObjectKindError:
+      return error_to_object(error_copy(*obj.error_variant));
     default:
-      panic("move behavior for object variant isn't defined");
+      panic("clone behavior for object variant isn't defined");
+  }
+  __builtin_unreachable();
+}
+
+void object_unshare(IrisObject* obj) {
+  assert(pointer_is_valid(obj));
+  assert(object_is_valid(*obj));
+  if ((obj->kind != irisObjectKindList) && (obj->kind != irisObjectKindDict)) {
+    return; // other boxed values are immutable
+  }
+  // borrowed list is copied even if it isn't shared, as its items belong to owner
+  bool is_borrowed = (obj->kind == irisObjectKindList) && list_is_borrowed(*obj->list_variant);
+  if (!is_borrowed && (atomic_load_explicit(&object_box_header(obj->string_variant)->refcount, memory_order_acquire) == 1U)) {
+    return;
   }
+  IrisObject result = (obj->kind == irisObjectKindList) ?
+    list_to_object(list_copy(*obj->list_variant)) :
+    dict_to_object(dict_copy(*obj->dict_variant));
+  object_destroy(obj);
+  *obj = result;
+}
+
+void object_move(IrisObject* obj) {
+  // box is owned by whoever took the object, moved object is left as nil
+  assert(object_is_valid(*obj));
+  *obj = (IrisObject){ .kind = irisObjectKindNone };
 }
 
 size_t object_hash(const IrisObject obj) {
   assert(object_is_valid(obj));
   switch (obj.kind) {
     case irisObjectKindInt:
-      return obj.int_variant;
+      return (size_t)obj.int_variant;
     case irisObjectKindFloat:
-      return obj.int_variant; // interpret bit layout of int, could be dangerous
+      return (size_t)obj.int_variant; // interpret bit layout of int, could be dangerous
     case irisObjectKindString:
-      return obj.string_variant.hash;
+      return string_hash(obj.string_variant);
+    case irisObjectKindSymbol:
+      return symbol_hash(obj.symbol_variant);
     default:
       panic("hash behavior for object variant isn't defined");
   }
@@ -80,16 +194,24 @@ bool object_is_valid(const IrisObject obj) {
       return true;
     case irisObjectKindFloat:
       return true;
+    case irisObjectKindSymbol:
+      return symbol_is_valid(obj.symbol_variant);
     case irisObjectKindString:
-      return string_is_valid(obj.string_variant);
+      return pointer_is_valid(obj.string_variant) && string_is_valid(*obj.string_variant);
     case irisObjectKindList:
-      return list_is_valid(obj.list_variant);
+      return pointer_is_valid(obj.list_variant) && list_is_valid(*obj.list_variant);
+    case irisObjectKindDict:
+      return pointer_is_valid(obj.dict_variant) && dict_is_valid(*obj.dict_variant);
+    case irisObjectKindVector:
+      return pointer_is_valid(obj.vector_variant) && vector_is_valid(*obj.vector_variant);
+    case irisObjectKindMap:
+      return pointer_is_valid(obj.map_variant) && map_is_valid(*obj.map_variant);
     case irisObjectKindError:
-      return error_is_valid(obj.error_variant);
+      return pointer_is_valid(obj.error_variant) && error_is_valid(*obj.error_variant);
     case irisObjectKindFunc:
-      return func_is_valid(obj.func_variant);
+      return pointer_is_valid(obj.func_variant) && func_is_valid(*obj.func_variant);
     case irisObjectKindRefCell:
-      return refcell_is_valid(obj.refcell_variant);
+      return pointer_is_valid(obj.refcell_variant) && refcell_is_valid(*obj.refcell_variant);
     default:
       panic("validity check for object variant isn't defined");
   }
@@ -106,36 +228,67 @@ void object_destroy(IrisObject* obj) {
   switch (obj->kind) {
     case irisObjectKindNone:
       // panic("attempt to destroy nil"); // todo: should it just silently escape?
+      return;
+    case irisObjectKindInt: return;
+    case irisObjectKindFloat: return;
+    case irisObjectKindSymbol: return;
+    default:
       break;
-    case irisObjectKindInt: break;
-    case irisObjectKindFloat: break;
+  }
+  if (!object_box_release(*obj)) {
+    *obj = (IrisObject){ .kind = irisObjectKindNone };
+    return;
+  }
+  switch (obj->kind) {
     case irisObjectKindString:
-      string_destroy(&obj->string_variant);
+      string_destroy(obj->string_variant);
       break;
     case irisObjectKindList:
-      list_destroy(&obj->list_variant);
+      list_destroy(obj->list_variant);
+      break;
+    case irisObjectKindDict:
+      dict_destroy(obj->dict_variant);
+      break;
+    case irisObjectKindVector:
+      vector_destroy(obj->vector_variant);
+      break;
+    case irisObjectKindMap:
+      map_destroy(obj->map_variant);
       break;
     case irisObjectKindFunc:
-      func_destroy(&obj->func_variant);
+      func_destroy(obj->func_variant);
       break;
     case irisObjectKindError:
-      error_destroy(&obj->error_variant);
+      error_destroy(obj->error_variant);
       break;
     case irisObjectKindRefCell:
-      refcell_destroy(&obj->refcell_variant);
+      refcell_destroy(obj->refcell_variant);
       break;
     default:
       panic("destroy behavior for object variant isn't defined");
   }
+  // every variant shares the same pointer, so box is released uniformly
+  iris_free(object_box_header(obj->string_variant));
+  *obj = (IrisObject){ .kind = irisObjectKindNone };
 }
 
 bool object_equal(const IrisObject x, const IrisObject y) {
   assert(object_is_valid(x));
   assert(object_is_valid(y));
-  iris_check(x.kind == y.kind, "attempt to compare objects of different kinds");
+  if (x.kind != y.kind) {
+    return false;
+  }
   switch (x.kind) {
+    case irisObjectKindNone:
+      return true;
+    case irisObjectKindInt:
+      return x.int_variant == y.int_variant;
+    case irisObjectKindFloat:
+      return x.int_variant == y.int_variant; // bit layout is compared, the same way it's hashed
     case irisObjectKindString:
-      return string_equal(x.string_variant, y.string_variant);
+      return string_equal(*x.string_variant, *y.string_variant);
+    case irisObjectKindSymbol:
+      return symbol_equal(x.symbol_variant, y.symbol_variant);
     default:
       panic("equal comparison for object variant isn't defined");
   }
@@ -150,7 +303,16 @@ void object_print(const IrisObject obj, bool newline) {
       fflush(stdout);
       break;
     case irisObjectKindList:
-      list_print_repr(obj.list_variant, newline);
+      list_print_repr(*obj.list_variant, newline);
+      break;
+    case irisObjectKindDict:
+      dict_print_repr(*obj.dict_variant, newline);
+      break;
+    case irisObjectKindVector:
+      vector_print_repr(*obj.vector_variant, newline);
+      break;
+    case irisObjectKindMap:
+      map_print_repr(*obj.map_variant, newline);
       break;
     case irisObjectKindInt:
       (void)fprintf(stdout, "%lld", obj.int_variant);
@@ -163,16 +325,19 @@ void object_print(const IrisObject obj, bool newline) {
       fflush(stdout);
       break;
     case irisObjectKindString:
-      string_print(obj.string_variant, newline);
+      string_print(*obj.string_variant, newline);
+      break;
+    case irisObjectKindSymbol:
+      symbol_print(obj.symbol_variant, newline);
       break;
     case irisObjectKindFunc:
-      func_print_repr(obj.func_variant, newline);
+      func_print_repr(*obj.func_variant, newline);
       break;
     case irisObjectKindError:
-      error_print_repr(obj.error_variant, newline);
+      error_print_repr(*obj.error_variant, newline);
       break;
     case irisObjectKindRefCell:
-      refcell_print(obj.refcell_variant, newline);
+      refcell_print(*obj.refcell_variant, newline);
       break;
     default:
       panic("printing behaviour for obj type isn't defined");
@@ -188,7 +353,16 @@ void object_print_repr(const IrisObject obj, bool newline) {
       fflush(stdout);
       break;
     case irisObjectKindList:
-      list_print_repr(obj.list_variant, newline);
+      list_print_repr(*obj.list_variant, newline);
+      break;
+    case irisObjectKindDict:
+      dict_print_repr(*obj.dict_variant, newline);
+      break;
+    case irisObjectKindVector:
+      vector_print_repr(*obj.vector_variant, newline);
+      break;
+    case irisObjectKindMap:
+      map_print_repr(*obj.map_variant, newline);
       break;
     case irisObjectKindInt:
       (void)fprintf(stdout, "%lld", obj.int_variant);
@@ -201,16 +375,19 @@ void object_print_repr(const IrisObject obj, bool newline) {
       fflush(stdout);
       break;
     case irisObjectKindString:
-      string_print_repr(obj.string_variant, newline);
+      string_print_repr(*obj.string_variant, newline);
+      break;
+    case irisObjectKindSymbol:
+      symbol_print_repr(obj.symbol_variant, newline);
       break;
     case irisObjectKindFunc:
-      func_print_repr(obj.func_variant, newline);
+      func_print_repr(*obj.func_variant, newline);
       break;
     case irisObjectKindError:
-      error_print_repr(obj.error_variant, newline);
+      error_print_repr(*obj.error_variant, newline);
       break;
     case irisObjectKindRefCell:
-      refcell_print_repr(obj.refcell_variant, newline);
+      refcell_print_repr(*obj.refcell_variant, newline);
       break;
     default:
       panic("printing behaviour for obj type isn't defined");
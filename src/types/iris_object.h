@@ -3,23 +3,30 @@
 
 // todo: hide fields of structs from user, objects should be opaque
 // todo: compile-time option for size of integer type, for example, IRIS_INT_PORTABLE that forces single size of integers and all architectures
-// todo: objects are too heavy. currently they require 40 bytes each which is enormous, for reference: Lua objects are only 12 bytes
+// todo: objects are still heavier than they could be, 16 bytes against 12 of Lua, tag could be stored in spare pointer bits
 
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <assert.h>
 
 struct _IrisObject;
 struct _IrisString;
+struct _IrisSymbol;
 struct _IrisList;
+struct _IrisVector;
 struct _IrisDict;
+struct _IrisMap;
 struct _IrisFunc;
 struct _IrisError;
 struct _IrisRefCell;
 
 #include "types/iris_list.h"
+#include "types/iris_vector.h"
 #include "types/iris_string.h"
+#include "types/iris_symbol.h"
 #include "types/iris_dict.h"
+#include "types/iris_map.h"
 #include "types/iris_func.h"
 #include "types/iris_error.h"
 #include "types/iris_refcell.h"
@@ -32,28 +39,67 @@ typedef enum {
   irisObjectKindInt,
   irisObjectKindFloat,
   irisObjectKindString,
+  irisObjectKindSymbol,
   irisObjectKindList,
   irisObjectKindDict,
+  irisObjectKindVector,
+  irisObjectKindMap,
   N_OBJECT_KINDS
 } IrisObjectKind;
 
 typedef struct _IrisObject {
   // polymorphic container, mostly used for representing code as data
   // homogeneous containers should be proffered
+  // immediate values are stored in place, heap types are reached through pointer to their boxed value
+  // which is owned by object, so object is a single word plus a tag
   IrisObjectKind kind;
   union {
-    intmax_t    int_variant;
-    float       float_variant;  // todo: use double on x64
-    IrisString  string_variant;
-    IrisList    list_variant;
-    IrisDict    dict_variant;
-    IrisFunc    func_variant;
-    IrisRefCell refcell_variant;
-    IrisError   error_variant;
+    intmax_t     int_variant;
+    double       float_variant;
+    IrisSymbol   symbol_variant;
+    IrisString*  string_variant;
+    IrisList*    list_variant;
+    IrisDict*    dict_variant;
+    IrisVector*  vector_variant;
+    IrisMap*     map_variant;
+    IrisFunc*    func_variant;
+    IrisRefCell* refcell_variant;
+    IrisError*   error_variant;
   };
 } IrisObject;
 
+static_assert((sizeof(IrisObject) <= 16U) || (sizeof(intmax_t) > 8U), "objects should fit in two words");
+
+/*
+  @brief  Move value into newly allocated box owned by returned object
+          Use *_to_object macros instead of calling them directly
+*/
+IrisObject object_box_string(IrisString);
+IrisObject object_box_list(IrisList);
+IrisObject object_box_dict(IrisDict);
+IrisObject object_box_vector(IrisVector);
+IrisObject object_box_map(IrisMap);
+IrisObject object_box_func(IrisFunc);
+IrisObject object_box_refcell(IrisRefCell);
+IrisObject object_box_error(IrisError);
+
+/*
+  @brief  Copy that shares boxed value with original, O(1)
+          Lists and dicts are copied on write, see object_unshare
+*/
 IrisObject object_copy(const IrisObject);
+
+/*
+  @brief  Copy that doesn't share any box with original, items of containers are cloned too
+          Should be used when copy has to outlive arena from which original could be allocated
+*/
+IrisObject object_clone(const IrisObject);
+
+/*
+  @brief  Make boxed list or dict referenced only by given object, so it could be mutated in place
+          Shared value or borrowed list is copied, while items of copy are still shared with original
+*/
+void object_unshare(IrisObject*);
 void object_destroy(IrisObject*);
 void object_move(IrisObject*);
 bool object_is_valid(const IrisObject);
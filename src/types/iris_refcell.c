@@ -8,9 +8,9 @@
 IrisRefCell refcell_from_object(IrisObject* obj) {
   assert(object_is_valid(*obj));
   IrisRefCell result;
-  result.ref = iris_alloc(1, IrisObject);
+  result.ref = iris_alloc_kind(1, IrisObject, irisObjectKindRefCell);
   memcpy(result.ref, obj, sizeof(IrisObject));
-  result.counter = iris_alloc(1, unsigned int);
+  result.counter = iris_alloc_kind(1, unsigned int, irisObjectKindRefCell);
   *result.counter = 1U;
   object_move(obj);
   return result;
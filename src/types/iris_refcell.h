@@ -38,6 +38,6 @@ bool refcell_is_valid(const IrisRefCell);
 void refcell_print(const IrisRefCell, bool newline);
 void refcell_print_repr(const IrisRefCell, bool newline);
 
-#define refcell_to_object(ref) (IrisObject){ .kind = irisObjectKindRefCell, .refcell_variant = ref }
+#define refcell_to_object(ref) object_box_refcell(ref)
 
 #endif
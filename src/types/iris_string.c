@@ -1,28 +1,64 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 // todo: when reading from file stream there's no way to singal status of reading to caller,
 //       we should consider some way to do so
 
-// todo: should they be cached on creation or only on first hash request?
-
 // todo: access of runes / individual characters
 // todo: search in utf8 encoded string might be done from the end if end is closer to sought-for rune
 
-// todo: long strings should be compared byte by byte
-
 #include "types/iris_types.h"
 #include "iris_memory.h"
 #include "iris_utils.h"
+#include "iris_profile.h"
 #include "iris_utf8.h"
+#include "iris_hash.h"
 
 #define STRING_PREALLOC 8U
 static_assert(STRING_PREALLOC > 0U, "string preallocation shouldn't be 0");
 
+struct _IrisStringSource {
+  IrisMappedFile file;
+  atomic_size_t refcount; // strings might be shared between interpreter threads
+};
+
+IrisStringSource* string_source_from_file(IrisMappedFile* file) {
+  assert(pointer_is_valid(file));
+  IrisStringSource* result = iris_alloc_kind(1, IrisStringSource, irisObjectKindString);
+  result->file = *file;
+  atomic_init(&result->refcount, 1U);
+  *file = (IrisMappedFile){ .kind = irisMappingNone };
+  return result;
+}
+
+const char* string_source_data(const IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  return source->file.data;
+}
+
+size_t string_source_len(const IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  return source->file.len;
+}
+
+IrisStringSource* string_source_retain(IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  atomic_fetch_add_explicit(&source->refcount, 1U, memory_order_relaxed);
+  return source;
+}
+
+void string_source_release(IrisStringSource* source) {
+  assert(pointer_is_valid(source));
+  if (atomic_fetch_sub_explicit(&source->refcount, 1U, memory_order_acq_rel) == 1U) {
+    os_file_unmap(&source->file);
+    iris_free(source);
+  }
+}
+
 bool string_is_valid(const IrisString str) {
-  return (str.len == 0ULL && !pointer_is_valid(str.data)) ||
-    (str.len != 0ULL && pointer_is_valid(str.data));
+  return string_is_inline(str) || pointer_is_valid(str.data);
 }
 
 bool string_is_empty(const IrisString str) {
@@ -30,42 +66,76 @@ bool string_is_empty(const IrisString str) {
   return str.len == 0ULL;
 }
 
-/*
-  @brief  djb2 hashing algorithm
-          fast, but not sure about distribution
-          main problem is that it's extremely likely to have collisions with integers
-*/
-static void string_hash(IrisString* str) {
+size_t string_hash(IrisString* str) {
   assert(pointer_is_valid(str));
   assert(string_is_valid(*str));
-  size_t hash = 5381ULL;
-  for (size_t i = 0; i < str->len; i++) {
-    hash = ((hash << 5ULL) + hash) + str->data[i];
+  // strings are immutable, so racing threads could only store the same value
+  size_t result = atomic_load_explicit(&str->hash, memory_order_relaxed);
+  if (result == 0ULL) {
+    result = iris_hash_bytes(string_bytes(*str), str->len);
+    atomic_store_explicit(&str->hash, result, memory_order_relaxed);
+  }
+  return result;
+}
+
+/*
+  @brief  Copy bytes into new string, short ones are stored inline
+          Hash isn't computed
+*/
+static IrisString string_from_bytes(const char* bytes, size_t len) {
+  IrisString result = { .len = len };
+  if (string_is_inline(result)) {
+    memcpy(result.inline_data, bytes, len * sizeof(char));
+  } else {
+    result.data = iris_alloc_kind(len, char, irisObjectKindString);
+    memcpy(result.data, bytes, len * sizeof(char));
   }
-  str->hash = hash;
+  return result;
+}
+
+/*
+  @brief  Finish string that was built in heap buffer of cap bytes
+          Buffer is either shrunk to len or released if string fits inline
+*/
+static IrisString string_from_buffer(char* buffer, size_t len) {
+  IrisString result;
+  if (len <= IRIS_STRING_INLINE_CAP) {
+    result = string_from_bytes(buffer, len);
+    if (buffer != NULL) {
+      iris_free(buffer);
+    }
+  } else {
+    result = (IrisString){ .data = iris_resize_kind(buffer, len, char, irisObjectKindString), .len = len };
+  }
+  return result;
 }
 
 IrisString string_copy(const IrisString str) {
   assert(string_is_valid(str));
-  IrisString result = {
-    .data = iris_alloc(str.len, char),
-    .len = str.len,
-    .hash = str.hash
-  };
-  memcpy(result.data, str.data, str.len * sizeof(char));
+  if (string_is_borrowed(str)) {
+    (void)string_source_retain(str.source);
+    return str;
+  }
+  IrisString result = string_from_bytes(string_bytes(str), str.len);
+  // bytes are identical, so is hash
+  atomic_store_explicit(&result.hash, atomic_load_explicit(&str.hash, memory_order_relaxed), memory_order_relaxed);
   return result;
 }
 
+IrisString string_from_source(IrisStringSource* source, const char* low, const char* high) {
+  assert(pointer_is_valid(source));
+  assert(low <= high);
+  assert((low >= source->file.data) && (high <= (source->file.data + source->file.len)));
+  size_t len = (size_t)(((ptrdiff_t)high - (ptrdiff_t)low) / sizeof(char));
+  if (len <= IRIS_STRING_INLINE_CAP) {
+    return string_from_bytes(low, len);
+  }
+  return (IrisString){ .data = (char*)low, .source = string_source_retain(source), .len = len };
+}
+
 IrisString string_from_chars(const char* chars) {
   assert(pointer_is_valid(chars));
-  size_t len = strlen(chars);
-  IrisString result = {
-    .data = iris_alloc(len, char),
-    .len = len
-  };
-  memcpy(result.data, chars, len);
-  string_hash(&result);
-  return result;
+  return string_from_bytes(chars, strlen(chars));
 }
 
 IrisString string_from_view(const char* low, const char* high) {
@@ -73,36 +143,31 @@ IrisString string_from_view(const char* low, const char* high) {
   assert(pointer_is_valid(high));
   assert(low <= high);
   size_t len = (size_t)(((ptrdiff_t)high - (ptrdiff_t)low) / sizeof(char));
-  IrisString result = {
-    .data = iris_alloc(len, char),
-    .len = len
-  };
-  memcpy(result.data, low, high - low);
-  string_hash(&result);
-  return result;
+  return string_from_bytes(low, len);
 }
 
 IrisString string_from_file_line(FILE* file) {
-  IrisString result = {0};
+  char* buffer = NULL;
+  size_t len = 0ULL;
   size_t cap = 0ULL;
 
   int ch;
   while ((ch = getc(file)) != '\n' && ch != EOF) {
-    if (cap <= result.len) {
+    if (cap <= len) {
       cap += STRING_PREALLOC;
-      result.data = iris_resize(result.data, cap, char);
+      buffer = iris_resize_kind(buffer, cap, char, irisObjectKindString);
     }
-    result.data[result.len++] = ch;
+    buffer[len++] = ch;
   }
   if (ferror(file)) { ferror_panic(file); }
-  result.data = iris_resize(result.data, result.len, char);
-  string_hash(&result);
-  return result;
+  return string_from_buffer(buffer, len);
 }
 
 // todo: ignore BOM?
 IrisString string_from_file(FILE* file) {
+  IRIS_PROFILE_ZONE("load");
   IrisString result = {0};
+  size_t cap;
   {
     long int restore_cursor = ftell(file);
     if (restore_cursor == -1L) { errno_panic(); }
@@ -111,62 +176,42 @@ IrisString string_from_file(FILE* file) {
 
     long int end_position = ftell(file);
     if (end_position == -1L) { errno_panic(); }
-    else if (end_position == 0) {
+    else if (end_position == restore_cursor) {
       // no characters in file stream
       return result; // zeroed string, invalid
     }
     if (fseek(file, restore_cursor, SEEK_SET) != 0) { ferror_panic(file); }
+    // position difference is only a hint for text streams, so buffer is still grown when needed
+    cap = (size_t)(end_position - restore_cursor);
   }
-  // todo: we can check length of byte stream directly, but text streams do not provide meaningful hint
-  //       can we check whether it's opened in byte or text mode?
-  size_t cap = STRING_PREALLOC;
-  result.data = iris_alloc(STRING_PREALLOC, char);
-
-  // todo: use fread instead
-  int ch;
-  while ((ch = getc(file)) != EOF) {
-    assert(result.len <= cap);
-    if (result.len == cap) {
-      cap += STRING_PREALLOC;
-      result.data = iris_resize(result.data, cap, char);
+  size_t len = 0ULL;
+  char* buffer = iris_alloc_kind(cap, char, irisObjectKindString);
+  for (;;) {
+    len += fread(buffer + len, sizeof(char), cap - len, file);
+    if (len < cap) {
+      break;
+    }
+    int ch = getc(file);
+    if (ch == EOF) {
+      break;
     }
-    result.data[result.len++] = ch;
+    cap *= 2ULL;
+    buffer = iris_resize_kind(buffer, cap, char, irisObjectKindString);
+    buffer[len++] = (char)ch;
   }
   if (ferror(file)) { ferror_panic(file); }
-  result.data = iris_resize(result.data, result.len, char);
-  string_hash(&result);
-  return result;
+  return string_from_buffer(buffer, len);
 }
 
 bool string_compare(const IrisString x, const IrisString y) {
   assert(string_is_valid(x));
   assert(string_is_valid(y));
-  #ifndef IRIS_SECURE
-  return x.hash == y.hash;
-  #else
-  if (x.len != y.len) {
-    return false;
-  }
-  for (size_t i = 0ULL; i < x.len; i++) {
-    if (x.data[i] != y.data[i]) {
-      return false;
-    }
-  }
-  return true;
-  #endif
+  return (x.len == y.len) && (memcmp(string_bytes(x), string_bytes(y), x.len) == 0);
 }
 
 bool string_compare_chars(const IrisString str, const char* chars) {
   size_t len = strlen(chars);
-  if (len != str.len) {
-    return false;
-  }
-  for (size_t i = 0ULL; i < len; i++) {
-    if (str.data[i] != chars[i]) {
-      return false;
-    }
-  }
-  return true;
+  return (len == str.len) && (memcmp(string_bytes(str), chars, len) == 0);
 }
 
 size_t string_card(const IrisString str) {
@@ -177,47 +222,57 @@ size_t string_card(const IrisString str) {
 char string_nth(const IrisString str, size_t idx) {
   assert(string_is_valid(str));
   iris_check(idx < str.len, "given idx isn't within string boundaries");
-  return str.data[idx];
+  return string_bytes(str)[idx];
 }
 
 bool string_equal(const IrisString x, const IrisString y) {
   assert(string_is_valid(x));
   assert(string_is_valid(y));
-  return x.hash == y.hash;
+  if (x.len != y.len) {
+    return false;
+  }
+  // hashes are only used for early rejection when both are already known
+  size_t x_hash = atomic_load_explicit(&x.hash, memory_order_relaxed);
+  size_t y_hash = atomic_load_explicit(&y.hash, memory_order_relaxed);
+  if ((x_hash != 0ULL) && (y_hash != 0ULL) && (x_hash != y_hash)) {
+    return false;
+  }
+  return memcmp(string_bytes(x), string_bytes(y), x.len) == 0;
 }
 
 void string_destroy(IrisString* str) {
-  // currently we set len to inappropriate value for NULL data
-  // it's kinda hacky, but works for now 
   assert(string_is_valid(*str));
-  // it's assumed that check above will stop str->len == 1ULL && str->data == NULL case
-  if (str->data != NULL) {
+  if (string_is_borrowed(*str)) {
+    string_source_release(str->source);
+  } else if (!string_is_inline(*str)) {
     iris_free(str->data);
   }
   string_move(str);
 }
 
 void string_move(IrisString* str) {
+  // moved string is left empty, which is always inline, hash of former bytes shouldn't stay with it
   str->data = NULL;
   str->len = 0ULL;
+  atomic_store_explicit(&str->hash, 0ULL, memory_order_relaxed);
 }
 
 void string_print(const IrisString str, bool newline) {
-  (void)fwrite((const void*)str.data, sizeof(char), str.len, stdout);
+  (void)fwrite((const void*)string_bytes(str), sizeof(char), str.len, stdout);
   if (newline) (void)fputc('\n', stdout);
   fflush(stdout);
 }
 
 void string_print_repr(const IrisString str, bool newline) {
   (void)fputc('"', stdout);
-  (void)fwrite((const void*)str.data, sizeof(char), str.len, stdout);
+  (void)fwrite((const void*)string_bytes(str), sizeof(char), str.len, stdout);
   (void)fputc('"', stdout);
   if (newline) (void)fputc('\n', stdout);
   fflush(stdout);
 }
 
 void string_print_internal(const IrisString str, bool newline) {
-  (void)fprintf(stdout, "<string | bytes: \"%.*s\" : len: %llu, hash: %llu)", (int)str.len, str.data, str.len, str.hash);
+  (void)fprintf(stdout, "<string | bytes: \"%.*s\" : len: %llu, hash: %llu)", (int)str.len, string_bytes(str), str.len, atomic_load_explicit(&str.hash, memory_order_relaxed));
   if (newline) (void)fputc('\n', stdout);
   fflush(stdout);
 }
@@ -4,19 +4,68 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+
+#include "iris_os.h"
 
 // todo: string builder for making strings from individual parts, could be particularly helpful for reporting
 
+#define IRIS_STRING_INLINE_CAP 16U // strings of up to this many bytes are stored in place without allocation
+
+typedef struct _IrisStringSource IrisStringSource;
+
 typedef struct _IrisString {
   // iris byte strings are immutable and not null terminated
-  // they don't have eny encoding attached and are hashed on creation
-  char*  data;
+  // they don't have eny encoding attached and are hashed on first request
+  // short strings are stored inline, len decides which representation is used, so use string_bytes for access
+  // long strings either own their heap bytes or borrow them from refcounted source, which is kept alive by them
+  union {
+    struct {
+      char* data;               // len > IRIS_STRING_INLINE_CAP
+      IrisStringSource* source; // NULL if data is owned
+    };
+    char inline_data[IRIS_STRING_INLINE_CAP];
+  };
   size_t len;
-  size_t hash;
+  atomic_size_t hash; // 0 if not yet computed, boxed strings are shared between threads, so it's accessed atomically
 } IrisString;
 
+#define string_is_inline(str) ((str).len <= IRIS_STRING_INLINE_CAP)
+#define string_is_borrowed(str) (!string_is_inline(str) && ((str).source != NULL))
+
+/*
+  @brief  Heap allocation that is owned by string or NULL if there's none
+*/
+#define string_owned_data(str) ((string_is_inline(str) || ((str).source != NULL)) ? NULL : (str).data)
+
+/*
+  @brief  Pointer to bytes of string
+  @warn   For inline strings it points into given string itself,
+          so it's only valid as long as that particular copy of string is
+*/
+#define string_bytes(str) (string_is_inline(str) ? (str).inline_data : (str).data)
+
+/*
+  @brief  Copy of string, borrowed strings share their source instead of copying bytes
+*/
 IrisString string_copy(const IrisString);
 
+/*
+  @brief  Immutable buffer that strings could borrow bytes from
+          Takes ownership of mapped file, which is released when last reference is gone
+*/
+IrisStringSource* string_source_from_file(IrisMappedFile*);
+const char* string_source_data(const IrisStringSource*);
+size_t string_source_len(const IrisStringSource*);
+IrisStringSource* string_source_retain(IrisStringSource*);
+void string_source_release(IrisStringSource*);
+
+/*
+  @brief  Create string that borrows given range of source, short strings are still stored inline
+  @warn   Range should be within source
+*/
+IrisString string_from_source(IrisStringSource*, const char* low, const char* high);
+
 /*
   @brief  Create string object from null-terminated string
   @warn   Use only for const static strings in binary and don't mess with dynamic C strings
@@ -46,14 +95,22 @@ size_t string_card(const IrisString);
 */
 char string_nth(const IrisString, size_t idx);
 
+/*
+  @brief  Byte-wise equality, cached hashes are only used for fast rejection
+*/
 bool string_equal(const IrisString, const IrisString);
 
+/*
+  @brief  Returns hash of string, computing and caching it on first call
+*/
+size_t string_hash(IrisString*);
+
 void string_destroy(IrisString*);
 void string_move(IrisString*);
 void string_print(const IrisString, bool newline);
 void string_print_repr(const IrisString, bool newline);
 void string_print_internal(const IrisString, bool newline);
 
-#define string_to_object(str) (struct _IrisObject){ .kind = irisObjectKindString, .string_variant = str }
+#define string_to_object(str) object_box_string(str)
 
 #endif
@@ -0,0 +1,166 @@
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_utils.h"
+#include "iris_hash.h"
+
+// todo: lookups could go without lock by publishing index with atomic pointer and retiring old ones
+
+// names are stored in pages that never move, so pointers returned by symbol_name stay valid after growth
+#define SYMBOL_PAGE_SIZE 256U
+#define SYMBOL_PAGE_LIMIT 4096U
+#define SYMBOL_INDEX_PREALLOC 512U
+
+static_assert((SYMBOL_PAGE_SIZE & (SYMBOL_PAGE_SIZE - 1U)) == 0U, "symbol page size should be power of 2");
+static_assert((SYMBOL_INDEX_PREALLOC & (SYMBOL_INDEX_PREALLOC - 1U)) == 0U, "symbol index size should be power of 2");
+
+static pthread_mutex_t symbol_lock = PTHREAD_MUTEX_INITIALIZER;
+static IrisString* symbol_pages[SYMBOL_PAGE_LIMIT];
+static _Atomic uint32_t symbol_count = 0U;
+static uint32_t* symbol_index = NULL; // open addressing by name hash, stores id + 1, 0 marks empty slot
+static uint32_t symbol_index_cap = 0U;
+
+#define symbol_entry(id) (&symbol_pages[(id) / SYMBOL_PAGE_SIZE][(id) & (SYMBOL_PAGE_SIZE - 1U)])
+
+static void symbol_index_grow(void) {
+  uint32_t new_cap = (symbol_index_cap == 0U) ? SYMBOL_INDEX_PREALLOC : (symbol_index_cap << 1U);
+  uint32_t* new_index = iris_alloc0_kind(new_cap, uint32_t, irisObjectKindSymbol);
+  for (uint32_t i = 0U; i < symbol_index_cap; i++) {
+    if (symbol_index[i] != 0U) {
+      uint32_t idx = (uint32_t)string_hash(symbol_entry(symbol_index[i] - 1U)) & (new_cap - 1U);
+      while (new_index[idx] != 0U) {
+        idx = (idx + 1U) & (new_cap - 1U);
+      }
+      new_index[idx] = symbol_index[i];
+    }
+  }
+  if (symbol_index != NULL) {
+    iris_free(symbol_index);
+  }
+  symbol_index = new_index;
+  symbol_index_cap = new_cap;
+}
+
+/*
+  @brief  Find or insert name, should be called with lock held and arena unbound
+          Bytes are only borrowed for probing, they're copied when name is inserted
+*/
+static uint32_t symbol_intern(const char* bytes, size_t len, size_t hash) {
+  uint32_t count = atomic_load_explicit(&symbol_count, memory_order_relaxed);
+  if (((count + 1U) * 2U) > symbol_index_cap) {
+    symbol_index_grow();
+  }
+  uint32_t idx = (uint32_t)hash & (symbol_index_cap - 1U);
+  while (symbol_index[idx] != 0U) {
+    IrisString* present = symbol_entry(symbol_index[idx] - 1U);
+    if ((string_hash(present) == hash) && (present->len == len) && (memcmp(string_bytes(*present), bytes, len) == 0)) {
+      return symbol_index[idx] - 1U;
+    }
+    idx = (idx + 1U) & (symbol_index_cap - 1U);
+  }
+  iris_check((count / SYMBOL_PAGE_SIZE) < SYMBOL_PAGE_LIMIT, "symbol table exhausted");
+  if ((count & (SYMBOL_PAGE_SIZE - 1U)) == 0U) {
+    symbol_pages[count / SYMBOL_PAGE_SIZE] = iris_alloc_kind(SYMBOL_PAGE_SIZE, IrisString, irisObjectKindSymbol);
+  }
+  // bytes are always copied, so borrowed strings don't keep their sources alive forever
+  IrisString name = string_from_view(bytes, bytes + len);
+  atomic_store_explicit(&name.hash, hash, memory_order_relaxed);
+  iris_retag(string_owned_data(name), irisObjectKindSymbol);
+  *symbol_entry(count) = name;
+  symbol_index[idx] = count + 1U;
+  atomic_store_explicit(&symbol_count, count + 1U, memory_order_release);
+  return count;
+}
+
+static IrisSymbol symbol_from_bytes(const char* bytes, size_t len, size_t hash) {
+  pthread_mutex_lock(&symbol_lock);
+  // table outlives any interpreter, so it's never allocated from arena that might be bound to caller
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  uint32_t id = symbol_intern(bytes, len, hash);
+  arena_bind(arena);
+  pthread_mutex_unlock(&symbol_lock);
+  return (IrisSymbol){ .id = id };
+}
+
+IrisSymbol symbol_from_string(const IrisString str) {
+  assert(string_is_valid(str));
+  // hash that was already computed for string is reused, otherwise bytes are hashed before taking lock
+  size_t hash = atomic_load_explicit(&str.hash, memory_order_relaxed);
+  if (hash == 0ULL) {
+    hash = iris_hash_bytes(string_bytes(str), str.len);
+  }
+  return symbol_from_bytes(string_bytes(str), str.len, hash);
+}
+
+IrisSymbol symbol_from_view(const char* low, const char* high) {
+  assert(pointer_is_valid(low));
+  assert(pointer_is_valid(high));
+  assert(low <= high);
+  return symbol_from_bytes(low, (size_t)(high - low), iris_hash_bytes(low, (size_t)(high - low)));
+}
+
+IrisSymbol symbol_from_chars(const char* chars) {
+  assert(pointer_is_valid(chars));
+  return symbol_from_view(chars, chars + strlen(chars));
+}
+
+const IrisString* symbol_name(const IrisSymbol sym) {
+  assert(symbol_is_valid(sym));
+  return symbol_entry(sym.id);
+}
+
+bool symbol_is_valid(const IrisSymbol sym) {
+  return sym.id < atomic_load_explicit(&symbol_count, memory_order_acquire);
+}
+
+bool symbol_equal(const IrisSymbol x, const IrisSymbol y) {
+  assert(symbol_is_valid(x));
+  assert(symbol_is_valid(y));
+  return x.id == y.id;
+}
+
+size_t symbol_hash(const IrisSymbol sym) {
+  assert(symbol_is_valid(sym));
+  // interned names are hashed before being published
+  return atomic_load_explicit(&symbol_entry(sym.id)->hash, memory_order_relaxed);
+}
+
+size_t symbol_table_card(void) {
+  return (size_t)atomic_load(&symbol_count);
+}
+
+void symbol_module_deinit(void) {
+  pthread_mutex_lock(&symbol_lock);
+  uint32_t count = atomic_load(&symbol_count);
+  for (uint32_t id = 0U; id < count; id++) {
+    string_destroy(symbol_entry(id));
+  }
+  for (uint32_t page = 0U; page < SYMBOL_PAGE_LIMIT; page++) {
+    if (symbol_pages[page] != NULL) {
+      iris_free(symbol_pages[page]);
+      symbol_pages[page] = NULL;
+    }
+  }
+  if (symbol_index != NULL) {
+    iris_free(symbol_index);
+    symbol_index = NULL;
+  }
+  symbol_index_cap = 0U;
+  atomic_store(&symbol_count, 0U);
+  pthread_mutex_unlock(&symbol_lock);
+}
+
+void symbol_print(const IrisSymbol sym, bool newline) {
+  string_print(*symbol_name(sym), newline);
+}
+
+void symbol_print_repr(const IrisSymbol sym, bool newline) {
+  string_print(*symbol_name(sym), newline);
+}
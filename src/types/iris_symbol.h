@@ -0,0 +1,55 @@
+#ifndef IRIS_SYMBOL_H
+#define IRIS_SYMBOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// todo: symbols are never released, long running hosts that generate names dynamically will leak them
+// todo: namespaced symbols?
+
+typedef struct _IrisSymbol {
+  // Interned name, equal names always produce the same id for whole lifetime of process
+  // Names are stored in global thread-safe table, so symbols themselves are immediate values
+  uint32_t id;
+} IrisSymbol;
+
+/*
+  @brief  Intern name given by byte range, names are compared byte-wise
+*/
+IrisSymbol symbol_from_view(const char* low, const char* high);
+
+/*
+  @brief  Intern null-terminated name
+*/
+IrisSymbol symbol_from_chars(const char*);
+
+IrisSymbol symbol_from_string(const struct _IrisString);
+
+/*
+  @brief  Interned name of symbol
+  @warn   Returned string is owned by symbol table and should not be destroyed or mutated
+*/
+const struct _IrisString* symbol_name(const IrisSymbol);
+
+bool symbol_is_valid(const IrisSymbol);
+bool symbol_equal(const IrisSymbol, const IrisSymbol);
+
+/*
+  @brief  Hash of symbol is the same as of string that holds its name
+*/
+size_t symbol_hash(const IrisSymbol);
+
+size_t symbol_table_card(void);
+
+/*
+  @brief  Release every interned name, all symbols that are still alive are invalidated
+*/
+void symbol_module_deinit(void);
+
+void symbol_print(const IrisSymbol, bool newline);
+void symbol_print_repr(const IrisSymbol, bool newline);
+
+#define symbol_to_object(sym) (struct _IrisObject){ .kind = irisObjectKindSymbol, .symbol_variant = (sym) }
+
+#endif
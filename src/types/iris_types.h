@@ -10,12 +10,12 @@
 typedef struct {
   // Yet unformed scope used in reader to fill in local definitions
   const IrisList inhereted_scopes;  // immutable formed scopes
-  IrisDict       local_scope;       // interpreter-local scope that could be modified
+  IrisMap        local_scope;       // interpreter-local scope that could be modified
 } IrisScopeUnformed;
 
 typedef struct {
   const IrisList inhereted_scopes;  // immutable formed scopes
-  const IrisDict local_scope;       // interpreter-local scope that could be modified
+  const IrisMap  local_scope;       // interpreter-local scope that could be modified
 } IrisScope;
 
 inline IrisScope iris_scope_form(const IrisScopeUnformed scope) {
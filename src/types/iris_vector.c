@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdatomic.h>
+
+#include "types/iris_types.h"
+#include "iris_memory.h"
+#include "iris_arena.h"
+#include "iris_utils.h"
+
+#define VECTOR_MASK ((size_t)IRIS_VECTOR_WIDTH - 1ULL)
+
+typedef struct _IrisVectorNode {
+  atomic_uint refcount;  // vectors and parent nodes that reference node
+  unsigned int len;      // used slots, only tail and the rightmost nodes could be partially filled
+  union {
+    struct _IrisVectorNode* children[IRIS_VECTOR_WIDTH];
+    IrisObject items[IRIS_VECTOR_WIDTH]; // for leaves, which are nodes at level 0
+  };
+} IrisVectorNode;
+
+// nodes are shared by copies that could outlive the form that created them, so they're always kept on heap,
+// arena is unbound for whole duration of mutation, which makes copies of items that are put into nodes be on heap too
+
+static IrisVectorNode* vector_node_new(void) {
+  IrisVectorNode* result = iris_alloc_kind(1, IrisVectorNode, irisObjectKindVector);
+  atomic_init(&result->refcount, 1U);
+  result->len = 0U;
+  return result;
+}
+
+static void vector_node_release(IrisVectorNode* node, size_t level) {
+  assert(pointer_is_valid(node));
+  if (atomic_fetch_sub_explicit(&node->refcount, 1U, memory_order_acq_rel) != 1U) {
+    return;
+  }
+  if (level == 0ULL) {
+    for (unsigned int i = 0U; i < node->len; i++) {
+      object_destroy(&node->items[i]);
+    }
+  } else {
+    for (unsigned int i = 0U; i < node->len; i++) {
+      vector_node_release(node->children[i], level - IRIS_VECTOR_BITS);
+    }
+  }
+  iris_free(node);
+}
+
+static void vector_node_retain(IrisVectorNode* node) {
+  atomic_fetch_add_explicit(&node->refcount, 1U, memory_order_relaxed);
+}
+
+/*
+  @brief  Get node that could be mutated instead of given one
+          Node that is referenced only by caller is returned as is, shared one is copied and caller's reference to it is dropped
+*/
+static IrisVectorNode* vector_node_own(IrisVectorNode* node, size_t level) {
+  if (atomic_load_explicit(&node->refcount, memory_order_acquire) == 1U) {
+    return node;
+  }
+  IrisVectorNode* result = vector_node_new();
+  result->len = node->len;
+  if (level == 0ULL) {
+    for (unsigned int i = 0U; i < node->len; i++) {
+      result->items[i] = object_copy(node->items[i]);
+    }
+  } else {
+    for (unsigned int i = 0U; i < node->len; i++) {
+      result->children[i] = node->children[i];
+      vector_node_retain(result->children[i]);
+    }
+  }
+  vector_node_release(node, level);
+  return result;
+}
+
+/*
+  @brief  Chain of single child nodes from given level down to leaf
+*/
+static IrisVectorNode* vector_new_path(size_t level, IrisVectorNode* leaf) {
+  if (level == 0ULL) {
+    return leaf;
+  }
+  IrisVectorNode* result = vector_node_new();
+  result->children[0] = vector_new_path(level - IRIS_VECTOR_BITS, leaf);
+  result->len = 1U;
+  return result;
+}
+
+/*
+  @brief  Put full leaf at index idx of trie, copying shared nodes along the path
+*/
+static IrisVectorNode* vector_push_leaf(IrisVectorNode* node, size_t level, size_t idx, IrisVectorNode* leaf) {
+  assert(level != 0ULL);
+  IrisVectorNode* result = vector_node_own(node, level);
+  size_t sub = (idx >> level) & VECTOR_MASK;
+  assert(sub <= result->len);
+  if (level == IRIS_VECTOR_BITS) {
+    result->children[sub] = leaf;
+  } else if (sub < result->len) {
+    result->children[sub] = vector_push_leaf(result->children[sub], level - IRIS_VECTOR_BITS, idx, leaf);
+  } else {
+    result->children[sub] = vector_new_path(level - IRIS_VECTOR_BITS, leaf);
+  }
+  if (sub == result->len) {
+    result->len++;
+  }
+  return result;
+}
+
+/*
+  @brief  Push heap allocated item past the last one, view should end at the last item
+*/
+static void vector_append(IrisVector* vec, IrisObject item) {
+  assert((vec->start + vec->len) == vec->count);
+  if (vec->tail == NULL) {
+    vec->tail = vector_node_new();
+  } else if (vec->tail->len == IRIS_VECTOR_WIDTH) {
+    // full tail becomes the rightmost leaf of trie
+    size_t trie_count = vec->count - IRIS_VECTOR_WIDTH;
+    if (vec->root == NULL) {
+      vec->root = vec->tail;
+      vec->shift = 0ULL;
+    } else if (trie_count == ((size_t)IRIS_VECTOR_WIDTH << vec->shift)) {
+      // trie is full, it grows by one level
+      IrisVectorNode* root = vector_node_new();
+      root->children[0] = vec->root;
+      root->children[1] = vector_new_path(vec->shift, vec->tail);
+      root->len = 2U;
+      vec->root = root;
+      vec->shift += IRIS_VECTOR_BITS;
+    } else {
+      vec->root = vector_push_leaf(vec->root, vec->shift, trie_count, vec->tail);
+    }
+    vec->tail = vector_node_new();
+  } else {
+    vec->tail = vector_node_own(vec->tail, 0ULL);
+  }
+  vec->tail->items[vec->tail->len++] = item;
+  vec->count++;
+  vec->len++;
+}
+
+IrisVector vector_new(void) {
+  return (IrisVector){0};
+}
+
+IrisVector vector_from_list(const IrisList list) {
+  assert(list_is_valid(list));
+  IrisVector result = vector_new();
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  for (size_t i = 0ULL; i < list.len; i++) {
+    // items of list could be allocated from arena
+    vector_append(&result, (arena != NULL) ? object_clone(list.items[i]) : object_copy(list.items[i]));
+  }
+  arena_bind(arena);
+  return result;
+}
+
+IrisVector vector_copy(const IrisVector vec) {
+  assert(vector_is_valid(vec));
+  if (vec.root != NULL) { vector_node_retain(vec.root); }
+  if (vec.tail != NULL) { vector_node_retain(vec.tail); }
+  return vec;
+}
+
+void vector_push_object(IrisVector* vec, IrisObject* obj) {
+  assert(pointer_is_valid(vec));
+  assert(pointer_is_valid(obj));
+  assert(vector_is_valid(*vec));
+  assert(object_is_valid(*obj));
+  IrisArena* arena = arena_bound();
+  arena_bind(NULL);
+  IrisObject item;
+  if (arena != NULL) {
+    // object could be allocated from arena, which is reset before nodes are released
+    item = object_clone(*obj);
+    arena_bind(arena);
+    object_destroy(obj);
+    arena_bind(NULL);
+  } else {
+    item = *obj;
+    object_move(obj);
+  }
+  if ((vec->start + vec->len) != vec->count) {
+    // slice that doesn't reach the end would overwrite items that are shared past its view, so view is copied first
+    IrisVector fresh = vector_new();
+    for (size_t i = 0ULL; i < vec->len; i++) {
+      vector_append(&fresh, object_copy(*vector_nth(*vec, i)));
+    }
+    vector_destroy(vec);
+    *vec = fresh;
+  }
+  vector_append(vec, item);
+  arena_bind(arena);
+}
+
+const IrisObject* vector_nth(const IrisVector vec, size_t idx) {
+  assert(vector_is_valid(vec));
+  iris_check(idx < vec.len, "idx out of bounds");
+  size_t i = vec.start + idx;
+  size_t tail_offset = vec.count - vec.tail->len;
+  if (i >= tail_offset) {
+    return &vec.tail->items[i - tail_offset];
+  }
+  const IrisVectorNode* node = vec.root;
+  for (size_t level = vec.shift; level != 0ULL; level -= IRIS_VECTOR_BITS) {
+    node = node->children[(i >> level) & VECTOR_MASK];
+  }
+  return &node->items[i & VECTOR_MASK];
+}
+
+IrisVector vector_slice(const IrisVector vec, size_t l, size_t h) {
+  assert(vector_is_valid(vec));
+  iris_check(l <= h, "low bound is greater than high one");
+  iris_check(l < vec.len, "low bound is outside of vector");
+  iris_check(h < vec.len, "high bound is outside of vector");
+  IrisVector result = vector_copy(vec);
+  result.start += l;
+  result.len = h - l + 1ULL;
+  return result;
+}
+
+IrisVector vector_rest(const IrisVector vec) {
+  assert(vector_is_valid(vec));
+  if (vec.len <= 1ULL) {
+    return vector_new();
+  }
+  return vector_slice(vec, 1ULL, vec.len - 1ULL);
+}
+
+size_t vector_card(const IrisVector vec) {
+  assert(vector_is_valid(vec));
+  return vec.len;
+}
+
+bool vector_is_empty(const IrisVector vec) {
+  assert(vector_is_valid(vec));
+  return vec.len == 0ULL;
+}
+
+bool vector_is_valid(const IrisVector vec) {
+  if (vec.tail == NULL) {
+    return (vec.root == NULL) && (vec.count == 0ULL) && (vec.start == 0ULL) && (vec.len == 0ULL);
+  }
+  return pointer_is_valid(vec.tail) && (atomic_load_explicit(&vec.tail->refcount, memory_order_relaxed) != 0U) &&
+    (vec.tail->len != 0U) &&
+    ((vec.root == NULL) || pointer_is_valid(vec.root)) &&
+    ((vec.start + vec.len) <= vec.count) && (vec.len != 0ULL);
+}
+
+void vector_destroy(IrisVector* vec) {
+  assert(pointer_is_valid(vec));
+  assert(vector_is_valid(*vec));
+  if (vec->root != NULL) {
+    vector_node_release(vec->root, vec->shift);
+  }
+  if (vec->tail != NULL) {
+    vector_node_release(vec->tail, 0ULL);
+  }
+  vector_move(vec);
+}
+
+void vector_move(IrisVector* vec) {
+  assert(pointer_is_valid(vec));
+  *vec = vector_new();
+}
+
+void vector_print_repr(const IrisVector vec, bool newline) {
+  assert(vector_is_valid(vec));
+  (void)fputc('[', stdout);
+  for (size_t i = 0ULL; i < vec.len; i++) {
+    if (i != 0ULL) { (void)fputc(' ', stdout); }
+    object_print_repr(*vector_nth(vec, i), false);
+  }
+  (void)fputc(']', stdout);
+  if (newline) { (void)fputc('\n', stdout); }
+  fflush(stdout);
+}
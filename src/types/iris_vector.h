@@ -0,0 +1,68 @@
+#ifndef IRIS_VECTOR_H
+#define IRIS_VECTOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// todo: relaxed radix balanced nodes, so that concatenation and slicing from the end could share structure too
+
+#define IRIS_VECTOR_BITS 5U
+#define IRIS_VECTOR_WIDTH (1U << IRIS_VECTOR_BITS)
+
+typedef struct _IrisVector {
+  // immutable persistent sequence, 32-way trie of refcounted nodes with the last leaf kept aside as tail
+  // copies share every node, push copies only nodes on the path to the changed leaf that are shared
+  // so older versions are left intact, rest and slicing just narrow the view over the same nodes
+  // nodes could be shared across interpreter threads, so their counts are atomic as for map nodes
+  struct _IrisVectorNode* root; // NULL while every item fits in tail
+  struct _IrisVectorNode* tail; // NULL for empty vector
+  size_t count; // items in trie and tail, including ones outside of view
+  size_t shift; // bits of index above leaves, 0 if root is leaf itself
+  size_t start; // vector is view over items [start, start + len)
+  size_t len;
+} IrisVector;
+
+IrisVector vector_new(void);
+
+/*
+  @brief  Vector of copies of list items
+*/
+IrisVector vector_from_list(const struct _IrisList);
+
+/*
+  @brief  Copy that shares every node, O(1)
+*/
+IrisVector vector_copy(const IrisVector);
+
+/*
+  @brief  Moves object to the end of vector, other vectors that share nodes with it aren't affected
+  @warn   Passed object should no longer be used!
+*/
+void vector_push_object(IrisVector*, struct _IrisObject*);
+
+/*
+  @brief  Get reference to item, it's valid as long as vector isn't destroyed
+*/
+const struct _IrisObject* vector_nth(const IrisVector, size_t idx);
+
+/*
+  @brief  Get vector of consequent items l..h (inclusive) that shares nodes with given one, O(1)
+*/
+IrisVector vector_slice(const IrisVector, size_t l, size_t h);
+
+/*
+  @brief  Get vector without the first item that shares nodes with given one, O(1)
+*/
+IrisVector vector_rest(const IrisVector);
+
+size_t vector_card(const IrisVector);
+bool vector_is_empty(const IrisVector);
+bool vector_is_valid(const IrisVector);
+
+void vector_destroy(IrisVector*);
+void vector_move(IrisVector*);
+void vector_print_repr(const IrisVector, bool newline);
+
+#define vector_to_object(vec) object_box_vector(vec)
+
+#endif